@@ -1,8 +1,19 @@
 #ifndef DATA_STRUCTURES_H
 #define DATA_STRUCTURES_H
 
+#include "adaptive_marked_array.h"
 #include "default_trie.h"
+#include "dense_bitmap.h"
+#include "ipv4_lpm.h"
+#include "ipv6_lpm.h"
 #include "marked_array.h"
 #include "message_buffer.h"
+#include "multicast_buffer.h"
+#include "pipeline.h"
+#include "sharded_cache.h"
+#include "sharded_trie.h"
+#include "shared_message_buffer.h"
+#include "static_trie.h"
+#include "timing_wheel.h"
 
 #endif
@@ -0,0 +1,145 @@
+#include "default_trie.h"
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "benchmarking.h"
+
+using ostp::libcc::data_structures::DefaultTrie;
+using ostp::libcc::data_structures::TrieDiff;
+using ostp::libcc::utils::do_not_optimize;
+
+const int no_match = -1;     // Default return of the tries.
+const int word_count = 4096; // Number of words in the trie.
+
+/// Generates the specified number of random lowercase words of 4 to 16 letters.
+std::vector<std::string> random_words(int count, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> length(4, 16);
+    std::uniform_int_distribution<int> letter('a', 'z');
+    std::vector<std::string> words(count);
+    for (std::string &word : words) {
+        word.resize(length(rng));
+        for (char &c : word) {
+            c = static_cast<char>(letter(rng));
+        }
+    }
+    return words;
+}
+
+START_BENCH_SUITE(DefaultTrie)
+
+const std::vector<std::string> words = random_words(word_count, 1);
+const std::vector<std::string> misses = random_words(word_count, 2);
+DefaultTrie<char, int> trie(no_match);
+std::vector<std::pair<std::string, int>> entries;
+for (int i = 0; i < word_count; i++) {
+    trie.insert(words[i].data(), words[i].size(), i);
+    entries.emplace_back(words[i], i);
+}
+
+// A copy with a few returns changed, as a reload would bring.
+const int changed_count = 16;
+DefaultTrie<char, int> changed = trie;
+for (int i = 0; i < changed_count; i++) {
+    const std::string &word = words[i * (word_count / changed_count)];
+    changed.insert(word.data(), word.size(), -2 - i);
+}
+const TrieDiff<char, int> forward = trie.diff(changed);
+const TrieDiff<char, int> backward = changed.diff(trie);
+
+START_BENCH(Insert) {
+    DefaultTrie<char, int> fresh(no_match);
+    BENCH_LOOP {
+        const std::string &word = words[_iteration % word_count];
+        fresh.insert(word.data(), word.size(), static_cast<int>(_iteration));
+    }
+    do_not_optimize(fresh);
+}
+END_BENCH
+
+START_BENCH(InsertAll) {
+    BENCH_LOOP {
+        DefaultTrie<char, int> fresh(no_match);
+        for (int i = 0; i < word_count; i++) {
+            fresh.insert(words[i].data(), words[i].size(), i);
+        }
+        do_not_optimize(fresh);
+    }
+}
+END_BENCH
+
+START_BENCH(BulkLoad) {
+    BENCH_LOOP {
+        DefaultTrie<char, int> fresh(no_match, entries);
+        do_not_optimize(fresh);
+    }
+}
+END_BENCH
+
+START_BENCH(GetHit) {
+    BENCH_LOOP {
+        const std::string &word = words[_iteration % word_count];
+        do_not_optimize(trie.get(word.data(), word.size()));
+    }
+}
+END_BENCH
+
+START_BENCH(GetMiss) {
+    BENCH_LOOP {
+        const std::string &word = misses[_iteration % word_count];
+        do_not_optimize(trie.get(word.data(), word.size()));
+    }
+}
+END_BENCH
+
+START_BENCH(Contains) {
+    BENCH_LOOP {
+        const std::string &word = words[_iteration % word_count];
+        do_not_optimize(trie.contains(word.data(), word.size()));
+    }
+}
+END_BENCH
+
+START_BENCH(FindWithinDistance1) {
+    BENCH_LOOP {
+        const std::string &word = misses[_iteration % word_count];
+        do_not_optimize(trie.find_within_distance(word.data(), word.size(), 1, 10));
+    }
+}
+END_BENCH
+
+START_BENCH(FindWithinDistance2) {
+    BENCH_LOOP {
+        const std::string &word = misses[_iteration % word_count];
+        do_not_optimize(trie.find_within_distance(word.data(), word.size(), 2, 10));
+    }
+}
+END_BENCH
+
+START_BENCH(DiffFewChanges) {
+    BENCH_LOOP { do_not_optimize(trie.diff(changed)); }
+}
+END_BENCH
+
+START_BENCH(ApplyFewChanges) {
+    BENCH_LOOP {
+        trie.apply(_iteration % 2 == 0 ? forward : backward);
+    }
+    do_not_optimize(trie);
+}
+END_BENCH
+
+START_BENCH(RemoveInsert) {
+    BENCH_LOOP {
+        const std::string &word = words[_iteration % word_count];
+        trie.remove(word.data(), word.size());
+        trie.insert(word.data(), word.size(), static_cast<int>(_iteration % word_count));
+    }
+}
+END_BENCH
+
+END_BENCH_SUITE
@@ -1,13 +1,40 @@
 #ifndef DEFAULT_TRIE_H
 #define DEFAULT_TRIE_H
 
+#include <algorithm>
+#include <atomic>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <ranges>
+#include <thread>
+#include <type_traits>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "default_trie_node.h"
+#include "metrics.h"
 
 namespace ostp::libcc::data_structures {
 
+/// Changes turning one trie into another, as returned by DefaultTrie::diff().
+template <class K, class R>
+struct TrieDiff {
+    std::vector<std::pair<std::vector<K>, R>> added;    // Keys only in the other trie.
+    std::vector<std::vector<K>> removed;                // Keys only in this trie.
+    std::vector<std::pair<std::vector<K>, R>> changed;  // Keys whose return differs.
+
+    /// Returns whether the tries hold the same keys and returns.
+    bool empty() const { return added.empty() && removed.empty() && changed.empty(); }
+
+    /// Returns the number of keys that differ.
+    std::size_t size() const { return added.size() + removed.size() + changed.size(); }
+};
+
 /// Default trie data structure.
 template <class K, class R>
 
@@ -19,6 +46,7 @@ class DefaultTrie {
     std::vector<int> free_slots;    // Vector of free slots in the results vector.
     std::vector<TrieNode<K>> trie;  // Trie data structure.
     int _size = 0;                  // Number of entries in the trie.
+    std::vector<int> path;          // Nodes above the last node updated, to rehash them.
 
    public:
     /// Constructs a trie with the specified default return for no matches and for the root node.
@@ -33,8 +61,109 @@ class DefaultTrie {
         this->default_return = default_return;
     }
 
+    /// Constructs a trie holding the specified entries, built in one pass over them sorted.
+    ///
+    /// The entries are sorted on several threads unless they already are, and the subtrees under
+    /// each first symbol are then built on separate threads with the children of every node laid
+    /// out next to each other, before being stitched under the root. When a key appears more than
+    /// once, its last return is kept as if the entries had been inserted in order. Keys must be
+    /// ordered by operator< on K.
+    ///
+    /// Arguments:
+    ///     default_return: The default return for no matches.
+    ///     entries: Pairs of a key, a contiguous range of K, and its return.
+    ///     threads: The largest number of threads to build with.
+    template <std::ranges::forward_range Entries>
+        requires std::is_lvalue_reference_v<std::ranges::range_reference_t<const Entries>> &&
+                 std::ranges::contiguous_range<
+                     decltype(std::declval<std::ranges::range_reference_t<const Entries>>().first)>
+    DefaultTrie(const R default_return, const Entries &entries,
+                const unsigned threads = std::thread::hardware_concurrency())
+        : default_return(default_return) {
+        const unsigned workers = std::max(threads, 1u);
+        std::vector<BulkEntry> sorted;
+        if constexpr (std::ranges::sized_range<const Entries>) {
+            sorted.reserve(std::ranges::size(entries));
+        }
+        for (const auto &[key, value] : entries) {
+            sorted.push_back({std::ranges::data(key), static_cast<int>(std::ranges::size(key)),
+                              &value});
+        }
+        parallel_sort(sorted, workers);
+
+        // Returns of the empty key go to the root.
+        std::size_t first = 0;
+        while (first < sorted.size() && sorted[first].key_len == 0) {
+            first++;
+        }
+        TrieNode<K> root;
+        root.res = NO_MATCH;
+        if (first > 0) {
+            root.res = 0;
+            results.push_back(*sorted[first - 1].value);
+        }
+
+        // Keys sharing their first symbol form one subtree under the root.
+        std::vector<std::pair<std::size_t, std::size_t>> buckets;
+        for (std::size_t i = first; i < sorted.size();) {
+            std::size_t j = i + 1;
+            while (j < sorted.size() && sorted[j].key[0] == sorted[i].key[0]) {
+                j++;
+            }
+            buckets.emplace_back(i, j);
+            i = j;
+        }
+
+        // Build the largest subtrees first to balance the threads.
+        std::vector<std::size_t> order(buckets.size());
+        for (std::size_t b = 0; b < order.size(); b++) {
+            order[b] = b;
+        }
+        std::sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+            return buckets[a].second - buckets[a].first > buckets[b].second - buckets[b].first;
+        });
+        std::vector<Subtrie> subtries(buckets.size());
+        parallel_for(order.size(), workers, [&](std::size_t i) {
+            const auto [begin, end] = buckets[order[i]];
+            subtries[order[i]] = build_subtrie(sorted, begin, end);
+        });
+
+        // Place each subtree after the previous ones and link it to the root.
+        std::vector<std::pair<int, int>> offsets(subtries.size());
+        std::size_t node_count = 1;
+        std::size_t result_count = results.size();
+        for (std::size_t b = 0; b < subtries.size(); b++) {
+            offsets[b] = {static_cast<int>(node_count), static_cast<int>(result_count)};
+            root.next.emplace(sorted[buckets[b].first].key[0], offsets[b].first);
+            node_count += subtries[b].nodes.size();
+            result_count += subtries[b].results.size();
+        }
+        trie.resize(node_count);
+        results.resize(result_count);
+        trie[0] = std::move(root);
+        parallel_for(subtries.size(), workers, [&](std::size_t b) {
+            const auto [node_offset, result_offset] = offsets[b];
+            for (std::size_t n = 0; n < subtries[b].nodes.size(); n++) {
+                TrieNode<K> &node = subtries[b].nodes[n];
+                for (auto &[symbol, child] : node.next) {
+                    child += node_offset;
+                }
+                if (node.res != NO_MATCH) {
+                    node.res += result_offset;
+                }
+                trie[node_offset + n] = std::move(node);
+            }
+            std::move(subtries[b].results.begin(), subtries[b].results.end(),
+                      results.begin() + result_offset);
+        });
+        if constexpr (HASHED) {
+            hash_node(trie, trie[0], results);
+        }
+        this->_size = static_cast<int>(result_count);
+    }
+
     /// Returns the size of the trie.
-    int size() { return this->_size; }
+    int size() const { return this->_size; }
 
     /// Inserts the specfied entry to the trie with the specified return.
     ///
@@ -45,6 +174,9 @@ class DefaultTrie {
     void insert(const K entry[], const int entry_len, const R entry_return) {
         // Traverse the trie until we reach the end of the entry or a node with no next entry.
         int node = 0;
+        if constexpr (HASHED) {
+            path.resize(entry_len);
+        }
         for (int i = 0; i < entry_len; i++) {
             // Create a new node if there is no next entry.
             if (trie[node].next.find(entry[i]) == trie[node].next.end()) {
@@ -55,12 +187,19 @@ class DefaultTrie {
             }
 
             // Move to the next node.
+            if constexpr (HASHED) {
+                path[i] = node;
+            }
             node = trie[node].next[entry[i]];
         }
 
         // If there is already a return for the match ending in the last node, replace it otherwise
         // add it to the results vector.
         if (trie[node].res != NO_MATCH) {
+            if constexpr (HASHED) {
+                rehash(entry, node, return_hash(results[trie[node].res]),
+                       return_hash(entry_return));
+            }
             results[trie[node].res] = entry_return;
             return;
         } else {
@@ -73,6 +212,9 @@ class DefaultTrie {
                 trie[node].res = results.size();
                 results.push_back(entry_return);
             }
+            if constexpr (HASHED) {
+                rehash(entry, node, 0, return_hash(entry_return));
+            }
         }
     }
 
@@ -90,6 +232,9 @@ class DefaultTrie {
     void remove(const K entry[], const int entry_len) {
         // Traverse the trie until we reach the end of the entry or a node with no next entry.
         int node = 0;
+        if constexpr (HASHED) {
+            path.resize(entry_len);
+        }
         for (int i = 0; i < entry_len; i++) {
             // Return if there is no next entry.
             if (trie[node].next.find(entry[i]) == trie[node].next.end()) {
@@ -97,14 +242,20 @@ class DefaultTrie {
             }
 
             // Move to the next node.
+            if constexpr (HASHED) {
+                path[i] = node;
+            }
             node = trie[node].next[entry[i]];
         }
 
         // If there is a return for the match ending in the last node, remove it.
         if (trie[node].res != NO_MATCH) {
+            if constexpr (HASHED) {
+                rehash(entry, node, return_hash(results[trie[node].res]), 0);
+            }
             this->_size--;
-            results[trie[node].res] = NO_MATCH;
             free_slots.push_back(trie[node].res);
+            trie[node].res = NO_MATCH;
         }
     }
 
@@ -113,21 +264,24 @@ class DefaultTrie {
     /// Arguments:
     ///     entry: The entry to get the return for.
     ///     entry_len: The length of the entry.
-    R get(const K entry[], const int entry_len) {
+    R get(const K entry[], const int entry_len) const {
         // Traverse the trie until we reach the end of the entry or a node with no next entry.
         int node = 0;
         for (int i = 0; i < entry_len; i++) {
             // Return the default return if there is no next entry.
-            if (trie[node].next.find(entry[i]) == trie[node].next.end()) {
+            const auto next = trie[node].next.find(entry[i]);
+            if (next == trie[node].next.end()) {
+                record_lookup(i, false);
                 return default_return;
             }
 
             // Move to the next node.
-            node = trie[node].next[entry[i]];
+            node = next->second;
         }
 
         // Return the result for the match ending in the last node or the default return if there
         // isn't one.
+        record_lookup(entry_len, trie[node].res != NO_MATCH);
         if (trie[node].res == NO_MATCH) {
             return default_return;
         } else {
@@ -140,22 +294,436 @@ class DefaultTrie {
     /// Arguments:
     ///     entry: The entry to check for.
     ///     entry_len: The length of the entry.
-    bool contains(const K entry[], const int entry_len) {
+    bool contains(const K entry[], const int entry_len) const {
         // Traverse the trie until we reach the end of the entry or a node with no next entry.
         int node = 0;
         for (int i = 0; i < entry_len; i++) {
             // Return false if there is no next entry.
-            if (trie[node].next.find(entry[i]) == trie[node].next.end()) {
+            const auto next = trie[node].next.find(entry[i]);
+            if (next == trie[node].next.end()) {
                 return false;
             }
 
             // Move to the next node.
-            node = trie[node].next[entry[i]];
+            node = next->second;
         }
 
         // Return whether there is a return for the match ending in the last node.
         return trie[node].res != NO_MATCH;
     }
+
+    /// Returns the returns of the entries within the specified edit distance of a query.
+    ///
+    /// Walks the trie once carrying a row of the Levenshtein table of the query against the
+    /// prefix of each node, and skips the subtree of any node whose row exceeds the distance
+    /// everywhere. Once the limit is reached by entries at some distance, farther entries are no
+    /// longer searched for.
+    ///
+    /// Arguments:
+    ///     query: The query to match the entries against.
+    ///     query_len: The length of the query.
+    ///     max_distance: The largest number of insertions, deletions and substitutions allowed.
+    ///     limit: The largest number of results to return.
+    ///
+    /// Returns:
+    ///     The return and distance of each matching entry, closest first.
+    std::vector<std::pair<R, int>> find_within_distance(
+        const K query[], const int query_len, const int max_distance,
+        const std::size_t limit = std::numeric_limits<std::size_t>::max()) const {
+        if (max_distance < 0 || limit == 0) {
+            return {};
+        }
+
+        // Distances beyond the bound are saturated to it plus one to keep the rows small.
+        int bound = max_distance;
+        const int columns = query_len + 1;
+        std::vector<int> rows(columns);
+        for (int j = 0; j < columns; j++) {
+            rows[j] = std::min(j, bound + 1);
+        }
+
+        // Matching nodes grouped by distance.
+        std::vector<std::vector<int>> matches(max_distance + 1);
+        auto add_match = [&](int node, int distance) {
+            matches[distance].push_back(trie[node].res);
+
+            // Tighten the bound while the closer matches alone fill the limit.
+            while (bound > 0) {
+                std::size_t closer = 0;
+                for (int d = 0; d < bound; d++) {
+                    closer += matches[d].size();
+                }
+                if (closer < limit) {
+                    break;
+                }
+                bound--;
+            }
+        };
+        if (trie[0].res != NO_MATCH && rows[query_len] <= bound) {
+            add_match(0, rows[query_len]);
+        }
+
+        // Depth-first walk where the row of a node's parent is the row above its own.
+        struct Visit {
+            int node;
+            K symbol;
+            int depth;
+        };
+        std::vector<Visit> stack;
+        for (const auto &[symbol, child] : trie[0].next) {
+            stack.push_back({child, symbol, 1});
+        }
+        while (!stack.empty() && matches[0].size() < limit) {
+            const Visit visit = stack.back();
+            stack.pop_back();
+
+            if (rows.size() < static_cast<std::size_t>((visit.depth + 1) * columns)) {
+                rows.resize((visit.depth + 1) * columns);
+            }
+            const int *above = rows.data() + (visit.depth - 1) * columns;
+            int *row = rows.data() + visit.depth * columns;
+
+            row[0] = std::min(visit.depth, bound + 1);
+            int row_min = row[0];
+            for (int j = 1; j < columns; j++) {
+                const int substitute = above[j - 1] + (query[j - 1] == visit.symbol ? 0 : 1);
+                row[j] = std::min({substitute, above[j] + 1, row[j - 1] + 1, bound + 1});
+                row_min = std::min(row_min, row[j]);
+            }
+
+            if (row[query_len] <= bound && trie[visit.node].res != NO_MATCH) {
+                add_match(visit.node, row[query_len]);
+            }
+            if (row_min <= bound) {
+                for (const auto &[symbol, child] : trie[visit.node].next) {
+                    stack.push_back({child, symbol, visit.depth + 1});
+                }
+            }
+        }
+
+        std::vector<std::pair<R, int>> found_returns;
+        for (int distance = 0; distance <= bound && found_returns.size() < limit; distance++) {
+            for (const int res : matches[distance]) {
+                if (found_returns.size() == limit) {
+                    break;
+                }
+                found_returns.emplace_back(results[res], distance);
+            }
+        }
+        return found_returns;
+    }
+
+    /// Returns the changes turning this trie into another.
+    ///
+    /// Walks both tries together from their roots. When the returns can be hashed, every node
+    /// keeps a hash of the keys and returns below it, updated along the path of each insert and
+    /// remove, and subtrees with equal hashes are skipped, so the walk only visits the paths to
+    /// the keys that differ. Otherwise every node of both tries is visited. Subtrees whose keys
+    /// were all removed count as absent.
+    ///
+    /// Arguments:
+    ///     other: The trie to compare against.
+    ///
+    /// Returns:
+    ///     The keys only in the other trie and the keys whose return differs, with the return
+    ///     they have there, and the keys only in this trie.
+    TrieDiff<K, R> diff(const DefaultTrie &other) const
+        requires std::equality_comparable<R>
+    {
+        TrieDiff<K, R> changes;
+
+        // Depth-first walk over pairs of nodes with the same key, NO_MATCH where a trie has none.
+        struct Visit {
+            int node;
+            int other_node;
+            K symbol;
+            int depth;
+        };
+        std::vector<K> key;
+        std::vector<Visit> stack = {{0, 0, K{}, 0}};
+        while (!stack.empty()) {
+            const Visit visit = stack.back();
+            stack.pop_back();
+            const TrieNode<K> *node = visit.node == NO_MATCH ? nullptr : &trie[visit.node];
+            const TrieNode<K> *other_node =
+                visit.other_node == NO_MATCH ? nullptr : &other.trie[visit.other_node];
+            if constexpr (HASHED) {
+                if ((node ? node->hash : 0) == (other_node ? other_node->hash : 0)) {
+                    continue;
+                }
+            }
+            key.resize(visit.depth);
+            if (visit.depth > 0) {
+                key.back() = visit.symbol;
+            }
+
+            const int res = node ? node->res : NO_MATCH;
+            const int other_res = other_node ? other_node->res : NO_MATCH;
+            if (res != NO_MATCH && other_res == NO_MATCH) {
+                changes.removed.push_back(key);
+            } else if (res == NO_MATCH && other_res != NO_MATCH) {
+                changes.added.emplace_back(key, other.results[other_res]);
+            } else if (res != NO_MATCH && !(results[res] == other.results[other_res])) {
+                changes.changed.emplace_back(key, other.results[other_res]);
+            }
+
+            if (node != nullptr) {
+                for (const auto &[symbol, child] : node->next) {
+                    int other_child = NO_MATCH;
+                    if (other_node != nullptr) {
+                        const auto it = other_node->next.find(symbol);
+                        if (it != other_node->next.end()) {
+                            other_child = it->second;
+                        }
+                    }
+                    stack.push_back({child, other_child, symbol, visit.depth + 1});
+                }
+            }
+            if (other_node != nullptr) {
+                for (const auto &[symbol, other_child] : other_node->next) {
+                    if (node == nullptr || !node->next.contains(symbol)) {
+                        stack.push_back({NO_MATCH, other_child, symbol, visit.depth + 1});
+                    }
+                }
+            }
+        }
+        return changes;
+    }
+
+    /// Applies changes to the trie in place, as returned by diff() on it or on a trie with the
+    /// same keys and returns, after which it holds the same keys and returns as the other trie.
+    ///
+    /// Arguments:
+    ///     changes: The changes to apply.
+    void apply(const TrieDiff<K, R> &changes) {
+        for (const std::vector<K> &key : changes.removed) {
+            remove(key.data(), static_cast<int>(key.size()));
+        }
+        for (const auto &[key, value] : changes.changed) {
+            insert(key.data(), static_cast<int>(key.size()), value);
+        }
+        for (const auto &[key, value] : changes.added) {
+            insert(key.data(), static_cast<int>(key.size()), value);
+        }
+    }
+
+   private:
+    /// Entry of a bulk load pointing into the caller's entries.
+    struct BulkEntry {
+        const K *key;
+        int key_len;
+        const R *value;
+    };
+
+    /// Nodes and returns of a subtree built apart from the trie, indexed from zero.
+    struct Subtrie {
+        std::vector<TrieNode<K>> nodes;
+        std::vector<R> results;
+    };
+
+    /// Runs the specified task for each index below the count on up to the specified threads.
+    template <class Task>
+    static void parallel_for(const std::size_t count, const unsigned threads, const Task &task) {
+        std::atomic<std::size_t> next(0);
+        auto work = [&] {
+            for (std::size_t i = next.fetch_add(1); i < count; i = next.fetch_add(1)) {
+                task(i);
+            }
+        };
+        std::vector<std::thread> pool;
+        for (std::size_t t = 1; t < std::min<std::size_t>(threads, count); t++) {
+            pool.emplace_back(work);
+        }
+        work();
+        for (std::thread &thread : pool) {
+            thread.join();
+        }
+    }
+
+    /// Stably sorts bulk entries by key, sorting chunks on separate threads and merging them.
+    static void parallel_sort(std::vector<BulkEntry> &entries, const unsigned threads) {
+        auto less = [](const BulkEntry &a, const BulkEntry &b) {
+            return std::lexicographical_compare(a.key, a.key + a.key_len, b.key,
+                                                b.key + b.key_len);
+        };
+        if (std::is_sorted(entries.begin(), entries.end(), less)) {
+            return;
+        }
+
+        // Chunks below a few thousand entries are not worth a thread.
+        const std::size_t chunks =
+            std::clamp<std::size_t>(entries.size() / 4096, 1, std::max(threads, 1u));
+        std::vector<std::size_t> bounds(chunks + 1);
+        for (std::size_t c = 0; c <= chunks; c++) {
+            bounds[c] = entries.size() * c / chunks;
+        }
+        parallel_for(chunks, threads, [&](std::size_t c) {
+            std::stable_sort(entries.begin() + bounds[c], entries.begin() + bounds[c + 1], less);
+        });
+        for (std::size_t width = 1; width < chunks; width *= 2) {
+            parallel_for((chunks + 2 * width - 1) / (2 * width), threads, [&](std::size_t m) {
+                const std::size_t begin = bounds[2 * m * width];
+                const std::size_t middle = bounds[std::min((2 * m + 1) * width, chunks)];
+                const std::size_t end = bounds[std::min((2 * m + 2) * width, chunks)];
+                std::inplace_merge(entries.begin() + begin, entries.begin() + middle,
+                                   entries.begin() + end, less);
+            });
+        }
+    }
+
+    /// Builds the subtree of sorted non-empty keys sharing their first symbol breadth-first, so
+    /// the children of each node are contiguous. Its root is the node of that first symbol.
+    static Subtrie build_subtrie(const std::vector<BulkEntry> &entries, const std::size_t begin,
+                                 const std::size_t end) {
+        // Each node covers the range of keys starting with its prefix.
+        struct Range {
+            std::size_t begin;
+            std::size_t end;
+            int depth;
+        };
+
+        // Count the nodes, one per symbol not shared with the previous key, to allocate once.
+        std::size_t node_count = 1;
+        for (std::size_t i = begin; i < end; i++) {
+            int shared = 0;
+            if (i > begin) {
+                const BulkEntry &previous = entries[i - 1];
+                while (shared < previous.key_len && shared < entries[i].key_len &&
+                       previous.key[shared] == entries[i].key[shared]) {
+                    shared++;
+                }
+            } else {
+                shared = 1;
+            }
+            node_count += entries[i].key_len - shared;
+        }
+
+        Subtrie subtrie;
+        std::vector<Range> ranges;
+        subtrie.nodes.resize(node_count);
+        ranges.reserve(node_count);
+        ranges.push_back({begin, end, 1});
+        for (std::size_t n = 0; n < ranges.size(); n++) {
+            const Range range = ranges[n];
+            TrieNode<K> &node = subtrie.nodes[n];
+            node.res = NO_MATCH;
+
+            // Keys equal to the prefix sort first and the last of them is kept.
+            std::size_t i = range.begin;
+            while (i < range.end && entries[i].key_len == range.depth) {
+                i++;
+            }
+            if (i > range.begin) {
+                node.res = static_cast<int>(subtrie.results.size());
+                subtrie.results.push_back(*entries[i - 1].value);
+            }
+
+            // Add a child for each run of keys sharing the next symbol.
+            while (i < range.end) {
+                const K &symbol = entries[i].key[range.depth];
+                std::size_t j = i + 1;
+                while (j < range.end && entries[j].key[range.depth] == symbol) {
+                    j++;
+                }
+                node.next.emplace(symbol, static_cast<int>(ranges.size()));
+                ranges.push_back({i, j, range.depth + 1});
+                i = j;
+            }
+        }
+
+        // Children come after their parent, so hashing backwards finds them hashed.
+        if constexpr (HASHED) {
+            for (std::size_t n = subtrie.nodes.size(); n-- > 0;) {
+                hash_node(subtrie.nodes, subtrie.nodes[n], subtrie.results);
+            }
+        }
+        return subtrie;
+    }
+
+    /// Whether the returns can be hashed, in which case every node keeps the hash of its subtree.
+    static constexpr bool HASHED = requires(const R &value) {
+        { std::hash<R>{}(value) } -> std::convertible_to<std::size_t>;
+    };
+
+    /// Scrambles the bits of a hash.
+    static uint64_t mix(uint64_t hash) {
+        hash ^= hash >> 30;
+        hash *= 0xbf58476d1ce4e5b9;
+        hash ^= hash >> 27;
+        hash *= 0x94d049bb133111eb;
+        return hash ^ (hash >> 31);
+    }
+
+    /// Returns the part of the hash of a node due to the return of the match ending in it.
+    static uint64_t return_hash(const R &value) {
+        return mix(std::hash<R>{}(value) + 0x9e3779b97f4a7c15);
+    }
+
+    /// Returns the part of the hash of a node due to the subtree under one of its symbols.
+    static uint64_t child_hash(const K &symbol, const uint64_t hash) {
+        return hash == 0 ? 0 : mix(hash + std::hash<K>{}(symbol) * 0x9e3779b97f4a7c15);
+    }
+
+    /// Updates the hashes of a node whose return changed and of the nodes above it.
+    ///
+    /// Arguments:
+    ///     entry: The key of the node, whose path holds the nodes above it.
+    ///     node: The node.
+    ///     old_hash: The return hash of the node before, 0 if it had no return.
+    ///     new_hash: The return hash of the node after, 0 if it has no return.
+    void rehash(const K entry[], const int node, const uint64_t old_hash,
+                const uint64_t new_hash) {
+        if (old_hash == new_hash) {
+            return;
+        }
+        uint64_t before = trie[node].hash;
+        trie[node].hash += new_hash - old_hash;
+        uint64_t after = trie[node].hash;
+        for (int i = static_cast<int>(path.size()) - 1; i >= 0; i--) {
+            TrieNode<K> &parent = trie[path[i]];
+            const uint64_t parent_before = parent.hash;
+            parent.hash += child_hash(entry[i], after) - child_hash(entry[i], before);
+            before = parent_before;
+            after = parent.hash;
+        }
+    }
+
+    /// Sets the hash of a node from its return and the hashes of its children.
+    ///
+    /// Arguments:
+    ///     nodes: The nodes the node and its children are in.
+    ///     node: The node.
+    ///     results: The returns its return indexes.
+    static void hash_node(std::vector<TrieNode<K>> &nodes, TrieNode<K> &node,
+                          const std::vector<R> &results) {
+        node.hash = node.res == NO_MATCH ? 0 : return_hash(results[node.res]);
+        for (const auto &[symbol, child] : node.next) {
+            node.hash += child_hash(symbol, nodes[child].hash);
+        }
+    }
+
+    /// Metrics shared by every trie.
+    struct Metrics {
+        utils::Histogram &lookup_depth = utils::MetricsRegistry::global().histogram(
+            "libcc_default_trie_lookup_depth", "Nodes traversed by get().");
+        utils::Counter &hits = utils::MetricsRegistry::global().counter(
+            "libcc_default_trie_hits_total", "Lookups returning a stored value.");
+        utils::Counter &misses = utils::MetricsRegistry::global().counter(
+            "libcc_default_trie_misses_total", "Lookups returning the default return.");
+    };
+
+    /// Records the depth and outcome of a lookup if metrics are enabled.
+    ///
+    /// Arguments:
+    ///     depth: The number of nodes traversed.
+    ///     hit: Whether the lookup found a stored value.
+    static void record_lookup([[maybe_unused]] int depth, [[maybe_unused]] bool hit) {
+        if constexpr (utils::metrics_enabled) {
+            static Metrics metrics;
+            metrics.lookup_depth.record(depth);
+            (hit ? metrics.hits : metrics.misses).add();
+        }
+    }
 };
 
 }  // namespace ostp::libcc::data_structures
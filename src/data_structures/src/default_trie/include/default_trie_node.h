@@ -2,6 +2,7 @@
 #define DEFAULT_TRIE_NODE_H
 #define NO_MATCH -1
 
+#include <cstdint>
 #include <vector>
 #include <unordered_map>
 
@@ -21,6 +22,10 @@ namespace ostp::libcc::data_structures
 
         /// Index of the return for the match ending in this node or NO_MATCH if there isn't one.
         int res;
+
+        /// Hash of the keys below this node and their returns, 0 if there are none. Only kept
+        /// when the returns can be hashed.
+        uint64_t hash = 0;
     };
 
 } // namespace ostp::libcc::data_structures
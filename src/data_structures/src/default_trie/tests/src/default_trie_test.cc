@@ -1,17 +1,45 @@
 #include "default_trie.h"
 
+#include <algorithm>
+#include <map>
+#include <random>
 #include <sstream>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "logger.h"
 #include "testing.h"
 
 using ostp::libcc::data_structures::DefaultTrie;
+using ostp::libcc::data_structures::TrieDiff;
 using ostp::libcc::utils::log_error;
 using std::stringstream;
 
 const int no_match = -1;
 
+/// Return without a hash, for which diff() walks the whole tries.
+struct Unhashed {
+    int value;
+    bool operator==(const Unhashed &) const = default;
+};
+
+/// Returns the keys of a diff as strings mapped to their return, -2 for removed keys.
+template <class R>
+std::map<std::string, int> diff_keys(const TrieDiff<char, R> &diff) {
+    std::map<std::string, int> keys;
+    for (const auto &[key, value] : diff.added) {
+        keys[std::string(key.begin(), key.end())] = static_cast<int>(value);
+    }
+    for (const auto &[key, value] : diff.changed) {
+        keys[std::string(key.begin(), key.end())] = static_cast<int>(value);
+    }
+    for (const auto &key : diff.removed) {
+        keys[std::string(key.begin(), key.end())] = -2;
+    }
+    return keys;
+}
+
 START_SUITE(DefaultTrie_Constructor)
 
 START_TEST(EmptyStringShouldHaveNoMatch) {
@@ -73,6 +101,11 @@ START_TEST(DefaultTrie_RemoveTest) {
     // Neither the children or parents are removed.
     TEST(trie.get("abc", 3) == 3);
     TEST(trie.get("a", 1) == 1);
+
+    // The removed key is no longer contained and can be inserted again.
+    TEST(!trie.contains("ab", 2));
+    trie.insert("ab", 2, 4);
+    TEST(trie.get("ab", 2) == 4 && trie.size() == size_before);
 }
 END_TEST
 
@@ -99,4 +132,204 @@ START_TEST(DefaultTrie_ContainsTest) {
 }
 END_TEST
 
+START_TEST(DefaultTrie_FindWithinDistance) {
+    DefaultTrie<char, int> trie(no_match);
+    trie.insert("cat", 3, 1);
+    trie.insert("cart", 4, 2);
+    trie.insert("cut", 3, 3);
+    trie.insert("dog", 3, 4);
+    trie.insert("at", 2, 5);
+    trie.insert("", 0, 6);
+
+    // An exact search only finds the query itself.
+    TEST((trie.find_within_distance("cat", 3, 0) == std::vector<std::pair<int, int>>{{1, 0}}));
+    TEST(trie.find_within_distance("cab", 3, 0).empty());
+
+    // Substitutions, insertions and deletions each count once and results are closest first.
+    const DefaultTrie<char, int> &reader = trie;
+    std::vector<std::pair<int, int>> found = reader.find_within_distance("cat", 3, 1);
+    ASSERT(found.size() == 4);
+    TEST(found[0] == std::make_pair(1, 0));
+    for (int i = 1; i < 4; i++) {
+        TEST(found[i].second == 1 && found[i].first != 4 && found[i].first != 6);
+    }
+
+    // The empty key is reached by deleting every symbol.
+    found = trie.find_within_distance("ca", 2, 2);
+    TEST(std::find(found.begin(), found.end(), std::make_pair(6, 2)) != found.end());
+}
+END_TEST
+
+START_TEST(DefaultTrie_FindWithinDistanceLimit) {
+    DefaultTrie<char, int> trie(no_match);
+    trie.insert("abcd", 4, 0);
+    trie.insert("abce", 4, 1);
+    trie.insert("abxe", 4, 2);
+    trie.insert("axye", 4, 3);
+
+    // The limit keeps the closest matches.
+    std::vector<std::pair<int, int>> found = trie.find_within_distance("abcd", 4, 3, 2);
+    TEST((found == std::vector<std::pair<int, int>>{{0, 0}, {1, 1}}));
+    TEST(trie.find_within_distance("abcd", 4, 3, 0).empty());
+    TEST(trie.find_within_distance("abcd", 4, 3).size() == 4);
+
+    // Removed entries are not matched.
+    trie.remove("abcd", 4);
+    found = trie.find_within_distance("abcd", 4, 1);
+    TEST((found == std::vector<std::pair<int, int>>{{1, 1}}));
+}
+END_TEST
+
+START_TEST(DefaultTrie_BulkLoad) {
+    // Random keys, including repeats and prefixes of each other, in no particular order.
+    std::mt19937 rng(7);
+    std::vector<std::pair<std::string, int>> entries;
+    for (int i = 0; i < 20000; i++) {
+        std::string key(rng() % 6, ' ');
+        for (char &c : key) {
+            c = static_cast<char>('a' + rng() % 4);
+        }
+        entries.emplace_back(key, i);
+    }
+
+    // The bulk loaded trie matches inserting the entries in order on any number of threads.
+    DefaultTrie<char, int> inserted(no_match);
+    for (const auto &[key, value] : entries) {
+        inserted.insert(key.data(), key.size(), value);
+    }
+    for (const unsigned threads : {1u, 3u, 8u}) {
+        DefaultTrie<char, int> loaded(no_match, entries, threads);
+        ASSERT(loaded.size() == inserted.size());
+        for (const auto &[key, value] : entries) {
+            TEST(loaded.get(key.data(), key.size()) == inserted.get(key.data(), key.size()));
+        }
+        TEST(loaded.get("abcde", 5) == inserted.get("abcde", 5));
+    }
+
+    // Sorted input is loaded as is and the trie can still be updated.
+    std::sort(entries.begin(), entries.end());
+    DefaultTrie<char, int> loaded(no_match, entries);
+    TEST(loaded.get("", 0) == inserted.get("", 0));
+    loaded.insert("zz", 2, -2);
+    loaded.remove("a", 1);
+    TEST(loaded.get("zz", 2) == -2 && !loaded.contains("a", 1));
+    TEST(loaded.size() == inserted.size());
+}
+END_TEST
+
+START_TEST(DefaultTrie_BulkLoadEmpty) {
+    const std::vector<std::pair<std::vector<int>, int>> entries;
+    DefaultTrie<int, int> trie(no_match, entries);
+    TEST(trie.size() == 0);
+    TEST(trie.get(nullptr, 0) == no_match);
+}
+END_TEST
+
+START_TEST(DefaultTrie_DiffAndApply) {
+    // Random keys over a small alphabet so that they share long prefixes.
+    std::mt19937 rng(11);
+    auto random_key = [&rng]() {
+        std::string key(rng() % 7, ' ');
+        for (char &c : key) {
+            c = static_cast<char>('a' + rng() % 4);
+        }
+        return key;
+    };
+    std::map<std::string, int> before;
+    DefaultTrie<char, int> live(no_match);
+    for (int i = 0; i < 3000; i++) {
+        const std::string key = random_key();
+        before[key] = i;
+        live.insert(key.data(), key.size(), i);
+    }
+
+    // Change a few keys in a copy, tracking the expected diff.
+    DefaultTrie<char, int> target = live;
+    std::map<std::string, int> after = before;
+    std::map<std::string, int> expected;
+    for (int i = 0; i < 60; i++) {
+        const std::string key = random_key();
+        if (i % 3 == 0) {
+            target.remove(key.data(), key.size());
+            if (after.erase(key) > 0) {
+                expected[key] = before.contains(key) ? -2 : 0;
+            }
+        } else {
+            target.insert(key.data(), key.size(), 10000 + i);
+            after[key] = 10000 + i;
+            expected[key] = 10000 + i;
+        }
+    }
+    std::erase_if(expected, [&](const auto &change) {
+        return change.second == 0 || (before.contains(change.first) &&
+                                      after.contains(change.first) &&
+                                      before.at(change.first) == after.at(change.first));
+    });
+
+    const TrieDiff<char, int> diff = live.diff(target);
+    TEST(diff.size() == expected.size());
+    TEST(diff_keys(diff) == expected);
+    for (const auto &[key, value] : diff.added) {
+        TEST(!before.contains(std::string(key.begin(), key.end())));
+    }
+
+    // Applying the diff makes the tries the same.
+    live.apply(diff);
+    TEST(live.diff(target).empty());
+    TEST(live.size() == static_cast<int>(after.size()));
+    for (const auto &[key, value] : after) {
+        TEST(live.get(key.data(), key.size()) == value);
+    }
+    for (const auto &[key, value] : before) {
+        if (!after.contains(key)) {
+            TEST(!live.contains(key.data(), key.size()));
+        }
+    }
+}
+END_TEST
+
+START_TEST(DefaultTrie_DiffIgnoresLayout) {
+    // A bulk loaded trie has the same hashes as one built by inserting.
+    std::vector<std::pair<std::string, int>> entries = {{"", 0}, {"ab", 1}, {"abc", 2}, {"b", 3}};
+    DefaultTrie<char, int> loaded(no_match, entries);
+    DefaultTrie<char, int> inserted(no_match);
+    for (auto it = entries.rbegin(); it != entries.rend(); ++it) {
+        inserted.insert(it->first.data(), it->first.size(), it->second);
+    }
+    TEST(loaded.diff(inserted).empty());
+
+    // Nodes left by removed keys count as absent.
+    inserted.insert("abcdef", 6, 4);
+    inserted.remove("abcdef", 6);
+    TEST(loaded.diff(inserted).empty());
+    TEST(inserted.diff(loaded).empty());
+
+    // Swapping returns between keys is a change of both.
+    inserted.insert("ab", 2, 2);
+    inserted.insert("abc", 3, 1);
+    TEST((diff_keys(loaded.diff(inserted)) == std::map<std::string, int>{{"ab", 2}, {"abc", 1}}));
+}
+END_TEST
+
+START_TEST(DefaultTrie_DiffUnhashedReturns) {
+    const Unhashed none{no_match};
+    DefaultTrie<char, Unhashed> live(none);
+    DefaultTrie<char, Unhashed> target(none);
+    live.insert("ab", 2, {1});
+    live.insert("b", 1, {2});
+    target.insert("ab", 2, {5});
+    target.insert("c", 1, {3});
+
+    const TrieDiff<char, Unhashed> diff = live.diff(target);
+    ASSERT(diff.size() == 3);
+    TEST(diff.changed.size() == 1 && diff.changed[0].second.value == 5);
+    TEST(diff.added.size() == 1 && diff.added[0].first == std::vector<char>{'c'});
+    TEST(diff.removed.size() == 1 && diff.removed[0] == std::vector<char>{'b'});
+
+    live.apply(diff);
+    TEST(live.diff(target).empty());
+    TEST(live.get("ab", 2).value == 5 && !live.contains("b", 1));
+}
+END_TEST
+
 END_SUITE
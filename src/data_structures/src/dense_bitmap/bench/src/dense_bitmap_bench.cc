@@ -0,0 +1,174 @@
+#include "dense_bitmap.h"
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "adaptive_marked_array.h"
+#include "benchmarking.h"
+#include "marked_array.h"
+
+using ostp::libcc::data_structures::AdaptiveMarkedArray;
+using ostp::libcc::data_structures::DenseBitmap;
+using ostp::libcc::data_structures::MarkedArray;
+using ostp::libcc::data_structures::SimdLevel;
+using ostp::libcc::utils::do_not_optimize;
+
+const int size = 1 << 20;      // Indices of each set.
+const int index_count = 4096;  // Number of random indices cycled through.
+
+/// Unites two half full sets of a million bits per iteration on an instruction set.
+void unite(uint64_t iterations, const DenseBitmap &a, const DenseBitmap &b, SimdLevel level) {
+    DenseBitmap result(size);
+    if (!DenseBitmap::use_simd_level(level)) {
+        return;
+    }
+    for (uint64_t i = 0; i < iterations; i++) {
+        result = a;
+        result.union_with(b);
+        do_not_optimize(result.initialized_count());
+    }
+}
+
+/// Counts the common indices of two half full sets per iteration on an instruction set.
+void count_common(uint64_t iterations, const DenseBitmap &a, const DenseBitmap &b,
+                  SimdLevel level) {
+    if (!DenseBitmap::use_simd_level(level)) {
+        return;
+    }
+    for (uint64_t i = 0; i < iterations; i++) {
+        do_not_optimize(a.intersection_count(b));
+    }
+}
+
+/// Scans a million bits for the last one per iteration on an instruction set.
+void scan(uint64_t iterations, const DenseBitmap &last, SimdLevel level) {
+    if (!DenseBitmap::use_simd_level(level)) {
+        return;
+    }
+    for (uint64_t i = 0; i < iterations; i++) {
+        do_not_optimize(last.find_next_set(0));
+    }
+}
+
+/// Builds a marked array holding one index in every ratio of its range and looks each index up
+/// again, once per iteration.
+void build_sparse(uint64_t iterations, const std::vector<int> &fill, int ratio) {
+    for (uint64_t i = 0; i < iterations; i++) {
+        MarkedArray<bool> set(size, false);
+        for (int j = 0; j < size / ratio; j++) {
+            set.insert(fill[j], true);
+        }
+        int found = 0;
+        for (int j = 0; j < size / ratio; j++) {
+            found += set.is_initialzed(fill[j]);
+        }
+        do_not_optimize(found);
+    }
+}
+
+/// Builds a bitmap holding one index in every ratio of its range and looks each index up again,
+/// once per iteration.
+void build_dense(uint64_t iterations, const std::vector<int> &fill, int ratio) {
+    for (uint64_t i = 0; i < iterations; i++) {
+        DenseBitmap set(size);
+        for (int j = 0; j < size / ratio; j++) {
+            set.insert(fill[j]);
+        }
+        int found = 0;
+        for (int j = 0; j < size / ratio; j++) {
+            found += set.is_initialzed(fill[j]);
+        }
+        do_not_optimize(found);
+    }
+}
+
+START_BENCH_SUITE(DenseBitmap)
+
+std::mt19937 rng(1);
+std::uniform_int_distribution<int> distribution(0, size - 1);
+std::vector<int> indices(index_count);
+for (int &index : indices) {
+    index = distribution(rng);
+}
+std::vector<int> fill(size / 16);
+for (int &index : fill) {
+    index = distribution(rng);
+}
+
+// Two half full sets and one with a single index at the end.
+DenseBitmap a(size);
+DenseBitmap b(size);
+DenseBitmap last(size);
+for (int i = 0; i < size / 2; i++) {
+    a.insert(distribution(rng));
+    b.insert(distribution(rng));
+}
+last.insert(size - 1);
+const SimdLevel best = DenseBitmap::simd_level();
+
+START_BENCH(UnionScalar) { unite(_iterations, a, b, SimdLevel::SCALAR); }
+END_BENCH
+
+START_BENCH(UnionSse) { unite(_iterations, a, b, SimdLevel::SSE); }
+END_BENCH
+
+START_BENCH(UnionAvx2) { unite(_iterations, a, b, SimdLevel::AVX2); }
+END_BENCH
+
+START_BENCH(IntersectionCountScalar) { count_common(_iterations, a, b, SimdLevel::SCALAR); }
+END_BENCH
+
+START_BENCH(IntersectionCountSse) { count_common(_iterations, a, b, SimdLevel::SSE); }
+END_BENCH
+
+START_BENCH(IntersectionCountAvx2) { count_common(_iterations, a, b, SimdLevel::AVX2); }
+END_BENCH
+
+START_BENCH(FindNextSetScalar) { scan(_iterations, last, SimdLevel::SCALAR); }
+END_BENCH
+
+START_BENCH(FindNextSetSse) { scan(_iterations, last, SimdLevel::SSE); }
+END_BENCH
+
+START_BENCH(FindNextSetAvx2) { scan(_iterations, last, SimdLevel::AVX2); }
+END_BENCH
+
+DenseBitmap::use_simd_level(best);
+
+// Random inserts into a set holding about half of its range.
+START_BENCH(InsertRandomMarkedArray) {
+    MarkedArray<bool> array(size, false);
+    BENCH_LOOP { array.insert(indices[_iteration % index_count], true); }
+    do_not_optimize(array);
+}
+END_BENCH
+
+START_BENCH(InsertRandomAdaptive) {
+    AdaptiveMarkedArray array(size);
+    BENCH_LOOP { array.insert(indices[_iteration % index_count]); }
+    do_not_optimize(array);
+}
+END_BENCH
+
+// Sets built and read back at a fill ratio well below, close to and well above the default dense
+// ratio of AdaptiveMarkedArray, which sits where the two forms cost the same.
+START_BENCH(BuildMarkedArrayOneIn4096) { build_sparse(_iterations, fill, 4096); }
+END_BENCH
+
+START_BENCH(BuildBitmapOneIn4096) { build_dense(_iterations, fill, 4096); }
+END_BENCH
+
+START_BENCH(BuildMarkedArrayOneIn80) { build_sparse(_iterations, fill, 80); }
+END_BENCH
+
+START_BENCH(BuildBitmapOneIn80) { build_dense(_iterations, fill, 80); }
+END_BENCH
+
+START_BENCH(BuildMarkedArrayOneIn16) { build_sparse(_iterations, fill, 16); }
+END_BENCH
+
+START_BENCH(BuildBitmapOneIn16) { build_dense(_iterations, fill, 16); }
+END_BENCH
+
+END_BENCH_SUITE
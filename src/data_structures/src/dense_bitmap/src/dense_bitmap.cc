@@ -0,0 +1,299 @@
+#include "dense_bitmap.h"
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define LIBCC_DENSE_BITMAP_X86 1
+#endif
+
+namespace ostp::libcc::data_structures {
+
+// See dense_bitmap.h for documentation.
+
+namespace {
+
+/// Bulk operation combining two arrays of words.
+enum class Op {
+    UNION,         // a | b
+    INTERSECTION,  // a & b
+    DIFFERENCE,    // a & ~b
+    COUNT,         // popcount(a & b), nothing stored
+};
+
+/// Bulk operations of one instruction set.
+struct Kernels {
+    SimdLevel level;
+
+    /// Store the operation of a and b into out (unless counting) and return the bits set in it.
+    uint64_t (*combine[4])(const uint64_t *a, const uint64_t *b, uint64_t *out, std::size_t n);
+
+    /// Returns the first word in [begin, end) that is not zero, or end.
+    std::size_t (*find_nonzero)(const uint64_t *words, std::size_t begin, std::size_t end);
+};
+
+template <Op op>
+inline uint64_t apply_scalar(uint64_t a, uint64_t b) {
+    if constexpr (op == Op::UNION) {
+        return a | b;
+    } else if constexpr (op == Op::DIFFERENCE) {
+        return a & ~b;
+    } else {
+        return a & b;
+    }
+}
+
+template <Op op>
+uint64_t combine_scalar(const uint64_t *a, const uint64_t *b, uint64_t *out, std::size_t n) {
+    uint64_t count = 0;
+    for (std::size_t i = 0; i < n; i++) {
+        const uint64_t word = apply_scalar<op>(a[i], b[i]);
+        if constexpr (op != Op::COUNT) {
+            out[i] = word;
+        }
+        count += std::popcount(word);
+    }
+    return count;
+}
+
+std::size_t find_nonzero_scalar(const uint64_t *words, std::size_t begin, std::size_t end) {
+    while (begin < end && words[begin] == 0) {
+        begin++;
+    }
+    return begin;
+}
+
+#ifdef LIBCC_DENSE_BITMAP_X86
+
+template <Op op>
+__attribute__((target("sse4.2,popcnt"))) uint64_t combine_sse(const uint64_t *a,
+                                                               const uint64_t *b, uint64_t *out,
+                                                               std::size_t n) {
+    uint64_t count = 0;
+    std::size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        const __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i));
+        const __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i));
+        __m128i v;
+        if constexpr (op == Op::UNION) {
+            v = _mm_or_si128(va, vb);
+        } else if constexpr (op == Op::DIFFERENCE) {
+            v = _mm_andnot_si128(vb, va);
+        } else {
+            v = _mm_and_si128(va, vb);
+        }
+        if constexpr (op != Op::COUNT) {
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), v);
+        }
+        count += _mm_popcnt_u64(_mm_cvtsi128_si64(v)) +
+                 _mm_popcnt_u64(_mm_cvtsi128_si64(_mm_unpackhi_epi64(v, v)));
+    }
+    for (; i < n; i++) {
+        const uint64_t word = apply_scalar<op>(a[i], b[i]);
+        if constexpr (op != Op::COUNT) {
+            out[i] = word;
+        }
+        count += _mm_popcnt_u64(word);
+    }
+    return count;
+}
+
+__attribute__((target("sse4.2,popcnt"))) std::size_t find_nonzero_sse(const uint64_t *words,
+                                                                       std::size_t begin,
+                                                                       std::size_t end) {
+    for (; begin + 2 <= end; begin += 2) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(words + begin));
+        if (!_mm_testz_si128(v, v)) {
+            break;
+        }
+    }
+    return find_nonzero_scalar(words, begin, end);
+}
+
+/// Counts the bits of each 64-bit lane with nibble lookups, as POPCNT has no 256-bit form.
+__attribute__((target("avx2"))) inline __m256i popcount_lanes(__m256i v) {
+    const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 0, 1,
+                                            1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i low_nibbles = _mm256_set1_epi8(0x0f);
+    const __m256i low = _mm256_and_si256(v, low_nibbles);
+    const __m256i high = _mm256_and_si256(_mm256_srli_epi16(v, 4), low_nibbles);
+    const __m256i bytes =
+        _mm256_add_epi8(_mm256_shuffle_epi8(lookup, low), _mm256_shuffle_epi8(lookup, high));
+    return _mm256_sad_epu8(bytes, _mm256_setzero_si256());
+}
+
+template <Op op>
+__attribute__((target("avx2,popcnt"))) uint64_t combine_avx2(const uint64_t *a,
+                                                              const uint64_t *b, uint64_t *out,
+                                                              std::size_t n) {
+    __m256i counts = _mm256_setzero_si256();
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+        const __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i));
+        __m256i v;
+        if constexpr (op == Op::UNION) {
+            v = _mm256_or_si256(va, vb);
+        } else if constexpr (op == Op::DIFFERENCE) {
+            v = _mm256_andnot_si256(vb, va);
+        } else {
+            v = _mm256_and_si256(va, vb);
+        }
+        if constexpr (op != Op::COUNT) {
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), v);
+        }
+        counts = _mm256_add_epi64(counts, popcount_lanes(v));
+    }
+    uint64_t count = _mm256_extract_epi64(counts, 0) + _mm256_extract_epi64(counts, 1) +
+                     _mm256_extract_epi64(counts, 2) + _mm256_extract_epi64(counts, 3);
+    for (; i < n; i++) {
+        const uint64_t word = apply_scalar<op>(a[i], b[i]);
+        if constexpr (op != Op::COUNT) {
+            out[i] = word;
+        }
+        count += _mm_popcnt_u64(word);
+    }
+    return count;
+}
+
+__attribute__((target("avx2"))) std::size_t find_nonzero_avx2(const uint64_t *words,
+                                                              std::size_t begin,
+                                                              std::size_t end) {
+    for (; begin + 4 <= end; begin += 4) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(words + begin));
+        if (!_mm256_testz_si256(v, v)) {
+            break;
+        }
+    }
+    return find_nonzero_scalar(words, begin, end);
+}
+
+#endif
+
+/// Returns the kernels of an instruction set, which must be supported by this build.
+const Kernels &kernels_of(SimdLevel level) {
+    static const Kernels scalar{
+        SimdLevel::SCALAR,
+        {combine_scalar<Op::UNION>, combine_scalar<Op::INTERSECTION>,
+         combine_scalar<Op::DIFFERENCE>, combine_scalar<Op::COUNT>},
+        find_nonzero_scalar,
+    };
+#ifdef LIBCC_DENSE_BITMAP_X86
+    static const Kernels sse{
+        SimdLevel::SSE,
+        {combine_sse<Op::UNION>, combine_sse<Op::INTERSECTION>, combine_sse<Op::DIFFERENCE>,
+         combine_sse<Op::COUNT>},
+        find_nonzero_sse,
+    };
+    static const Kernels avx2{
+        SimdLevel::AVX2,
+        {combine_avx2<Op::UNION>, combine_avx2<Op::INTERSECTION>, combine_avx2<Op::DIFFERENCE>,
+         combine_avx2<Op::COUNT>},
+        find_nonzero_avx2,
+    };
+    if (level == SimdLevel::AVX2) {
+        return avx2;
+    }
+    if (level == SimdLevel::SSE) {
+        return sse;
+    }
+#endif
+    return scalar;
+}
+
+/// Returns the widest instruction set the CPU supports.
+SimdLevel best_level() {
+#ifdef LIBCC_DENSE_BITMAP_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt")) {
+        return SimdLevel::AVX2;
+    }
+    if (__builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("popcnt")) {
+        return SimdLevel::SSE;
+    }
+#endif
+    return SimdLevel::SCALAR;
+}
+
+/// Returns the kernels in use, the best supported ones unless chosen otherwise.
+std::atomic<const Kernels *> &active_kernels() {
+    static std::atomic<const Kernels *> active(&kernels_of(best_level()));
+    return active;
+}
+
+/// Returns the kernels in use.
+const Kernels &kernels() { return *active_kernels().load(std::memory_order_relaxed); }
+
+}  // namespace
+
+DenseBitmap::DenseBitmap(int size) : _size(size) {
+    if (size < 0) {
+        throw std::runtime_error("Size must not be negative");
+    }
+    words.assign((static_cast<std::size_t>(size) + 63) / 64, 0);
+}
+
+void DenseBitmap::union_with(const DenseBitmap &other) {
+    check_size(other);
+    _initialized_count = static_cast<int>(kernels().combine[static_cast<int>(Op::UNION)](
+        words.data(), other.words.data(), words.data(), words.size()));
+}
+
+void DenseBitmap::intersect_with(const DenseBitmap &other) {
+    check_size(other);
+    _initialized_count = static_cast<int>(kernels().combine[static_cast<int>(Op::INTERSECTION)](
+        words.data(), other.words.data(), words.data(), words.size()));
+}
+
+void DenseBitmap::subtract(const DenseBitmap &other) {
+    check_size(other);
+    _initialized_count = static_cast<int>(kernels().combine[static_cast<int>(Op::DIFFERENCE)](
+        words.data(), other.words.data(), words.data(), words.size()));
+}
+
+int DenseBitmap::intersection_count(const DenseBitmap &other) const {
+    check_size(other);
+    return static_cast<int>(kernels().combine[static_cast<int>(Op::COUNT)](
+        words.data(), other.words.data(), nullptr, words.size()));
+}
+
+int DenseBitmap::find_next_set(int from) const {
+    if (from < 0) {
+        throw std::runtime_error("Index out of bounds");
+    }
+    if (from >= _size) {
+        return -1;
+    }
+
+    // Look at the rest of the first word, then for the next word that is not zero.
+    std::size_t word = static_cast<std::size_t>(from) / 64;
+    const uint64_t rest = words[word] & (~uint64_t{0} << (from & 63));
+    if (rest != 0) {
+        return static_cast<int>(word * 64 + std::countr_zero(rest));
+    }
+    word = kernels().find_nonzero(words.data(), word + 1, words.size());
+    if (word == words.size()) {
+        return -1;
+    }
+    return static_cast<int>(word * 64 + std::countr_zero(words[word]));
+}
+
+SimdLevel DenseBitmap::simd_level() { return kernels().level; }
+
+bool DenseBitmap::use_simd_level(SimdLevel level) {
+    if (static_cast<int>(level) > static_cast<int>(best_level())) {
+        return false;
+    }
+    active_kernels().store(&kernels_of(level), std::memory_order_relaxed);
+    return true;
+}
+
+void DenseBitmap::check_size(const DenseBitmap &other) const {
+    if (other._size != _size) {
+        throw std::runtime_error("Bitmaps must have the same size");
+    }
+}
+
+}  // namespace ostp::libcc::data_structures
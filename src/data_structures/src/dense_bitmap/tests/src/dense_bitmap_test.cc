@@ -0,0 +1,193 @@
+#include "dense_bitmap.h"
+
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "adaptive_marked_array.h"
+#include "logger.h"
+#include "testing.h"
+
+using ostp::libcc::data_structures::AdaptiveMarkedArray;
+using ostp::libcc::data_structures::DenseBitmap;
+using ostp::libcc::data_structures::SimdLevel;
+using ostp::libcc::utils::log_error;
+
+const int size = 1000;  // Not a multiple of the 64, 128 or 256 bits the operations work on.
+
+/// Returns a bitmap and the same set as booleans, each index set with the specified odds.
+std::pair<DenseBitmap, std::vector<bool>> random_set(unsigned seed, double odds) {
+    std::mt19937 rng(seed);
+    std::bernoulli_distribution set(odds);
+    DenseBitmap bitmap(size);
+    std::vector<bool> reference(size);
+    for (int i = 0; i < size; i++) {
+        if (set(rng)) {
+            bitmap.insert(i);
+            reference[i] = true;
+        }
+    }
+    return {bitmap, reference};
+}
+
+/// Returns whether a bitmap holds the same set as the booleans, including its count.
+bool same_set(const DenseBitmap &bitmap, const std::vector<bool> &reference) {
+    int count = 0;
+    for (int i = 0; i < size; i++) {
+        if (bitmap.is_initialzed(i) != reference[i]) {
+            return false;
+        }
+        count += reference[i];
+    }
+    return bitmap.initialized_count() == count;
+}
+
+START_SUITE(DenseBitmap_Tests)
+
+START_TEST(InsertAndErase) {
+    DenseBitmap bitmap(size);
+    TEST(bitmap.size() == size);
+    TEST(bitmap.initialized_count() == 0);
+    bitmap.insert(0);
+    bitmap.insert(999);
+    bitmap.insert(999);
+    TEST(bitmap.is_initialzed(0) && bitmap.get(999));
+    TEST(bitmap.is_uninitialized(500));
+    TEST(bitmap.initialized_count() == 2);
+    bitmap.erase(0);
+    bitmap.erase(1);
+    TEST(bitmap.is_uninitialized(0));
+    TEST(bitmap.initialized_count() == 1);
+
+    bool thrown = false;
+    try {
+        bitmap.insert(size);
+    } catch (const std::runtime_error &) {
+        thrown = true;
+    }
+    TEST(thrown);
+}
+END_TEST
+
+START_SERIAL_TEST(BulkOperationsAgreeOnEveryInstructionSet) {
+    const SimdLevel best = DenseBitmap::simd_level();
+    for (SimdLevel level : {SimdLevel::SCALAR, SimdLevel::SSE, SimdLevel::AVX2}) {
+        if (!DenseBitmap::use_simd_level(level)) {
+            continue;
+        }
+        TEST(DenseBitmap::simd_level() == level);
+        for (unsigned seed = 0; seed < 8; seed++) {
+            const auto [a, a_set] = random_set(seed, 0.3);
+            const auto [b, b_set] = random_set(seed + 100, 0.6);
+
+            std::vector<bool> united(size), intersected(size), subtracted(size);
+            int common = 0;
+            for (int i = 0; i < size; i++) {
+                united[i] = a_set[i] || b_set[i];
+                intersected[i] = a_set[i] && b_set[i];
+                subtracted[i] = a_set[i] && !b_set[i];
+                common += intersected[i];
+            }
+
+            DenseBitmap result = a;
+            result.union_with(b);
+            TEST(same_set(result, united));
+            result = a;
+            result.intersect_with(b);
+            TEST(same_set(result, intersected));
+            result = a;
+            result.subtract(b);
+            TEST(same_set(result, subtracted));
+            TEST(a.intersection_count(b) == common);
+
+            // Scanning visits exactly the members in order.
+            int expected = -1;
+            for (int i = 0; i < size; i++) {
+                if (a_set[i]) {
+                    expected = i;
+                    break;
+                }
+            }
+            for (int i = a.find_next_set(0); i != -1; i = a.find_next_set(i + 1)) {
+                TEST(i == expected);
+                expected = -1;
+                for (int j = i + 1; j < size; j++) {
+                    if (a_set[j]) {
+                        expected = j;
+                        break;
+                    }
+                }
+            }
+            TEST(expected == -1);
+        }
+    }
+    TEST(DenseBitmap::use_simd_level(best));
+}
+END_TEST
+
+START_TEST(FindNextSetAcrossEmptyWords) {
+    DenseBitmap bitmap(size);
+    TEST(bitmap.find_next_set(0) == -1);
+    bitmap.insert(3);
+    bitmap.insert(900);
+    TEST(bitmap.find_next_set(0) == 3);
+    TEST(bitmap.find_next_set(3) == 3);
+    TEST(bitmap.find_next_set(4) == 900);
+    TEST(bitmap.find_next_set(901) == -1);
+    TEST(bitmap.find_next_set(size) == -1);
+}
+END_TEST
+
+START_TEST(BulkOperationsRequireTheSameSize) {
+    DenseBitmap a(size);
+    DenseBitmap b(size + 1);
+    bool thrown = false;
+    try {
+        a.union_with(b);
+    } catch (const std::runtime_error &) {
+        thrown = true;
+    }
+    TEST(thrown);
+}
+END_TEST
+
+START_TEST(AdaptiveArrayMovesToABitmapWhenDense) {
+    AdaptiveMarkedArray array(size, 0.1);
+    for (int i = 0; i < 100; i++) {
+        array.insert(i * 7);
+    }
+    TEST(!array.is_dense());
+    TEST(array.initialized_count() == 100);
+
+    // Crossing the ratio moves every index to the bitmap.
+    array.insert(999);
+    array.insert(999);
+    ASSERT(array.is_dense());
+    TEST(array.initialized_count() == 101);
+    TEST(array.size() == size);
+    for (int i = 0; i < size; i++) {
+        TEST(array.get(i) == ((i % 7 == 0 && i < 700) || i == 999));
+    }
+
+    // The bitmap then takes the bulk operations.
+    DenseBitmap odd(size);
+    for (int i = 1; i < size; i += 2) {
+        odd.insert(i);
+    }
+    array.densify().subtract(odd);
+    TEST(array.is_uninitialized(7));
+    TEST(array.is_initialzed(14));
+}
+END_TEST
+
+START_TEST(AdaptiveArrayCanBeDensifiedEarly) {
+    AdaptiveMarkedArray array(size);
+    array.insert(5);
+    const DenseBitmap &bitmap = array.densify();
+    TEST(array.is_dense());
+    TEST(bitmap.initialized_count() == 1);
+    TEST(bitmap.find_next_set(0) == 5);
+}
+END_TEST
+
+END_SUITE
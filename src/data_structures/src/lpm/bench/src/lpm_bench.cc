@@ -0,0 +1,201 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "benchmarking.h"
+#include "default_trie.h"
+#include "ipv4_lpm.h"
+#include "ipv6_lpm.h"
+
+using ostp::libcc::data_structures::DefaultTrie;
+using ostp::libcc::data_structures::Ipv4Lpm;
+using ostp::libcc::data_structures::Ipv6Address;
+using ostp::libcc::data_structures::Ipv6Lpm;
+using ostp::libcc::utils::do_not_optimize;
+
+const int no_match = -1;                 // Default return of the tables.
+const int ipv4_prefix_count = 900000;    // About the size of the IPv4 BGP table.
+const int ipv6_prefix_count = 200000;    // About the size of the IPv6 BGP table.
+const std::size_t address_count = 1 << 20;  // Addresses looked up, more than the caches hold.
+const std::size_t batch_size = 64;          // Addresses per batch lookup.
+
+/// Returns a prefix length drawn from a distribution of percentages over lengths.
+int random_length(std::mt19937 &rng, const std::vector<std::pair<int, int>> &percentages) {
+    int roll = static_cast<int>(rng() % 100);
+    for (const auto &[len, percentage] : percentages) {
+        if (roll < percentage) {
+            return len;
+        }
+        roll -= percentage;
+    }
+    return percentages.back().first;
+}
+
+/// Generates IPv4 prefixes with the mix of lengths of a BGP table, mostly /24s.
+std::vector<std::pair<uint32_t, int>> ipv4_prefixes(int count, uint32_t seed) {
+    const std::vector<std::pair<int, int>> lengths = {
+        {24, 58}, {22, 11}, {23, 10}, {21, 5}, {20, 4}, {19, 3}, {16, 3},
+        {18, 2},  {17, 1},  {12, 1},  {28, 1}, {32, 1},
+    };
+    std::mt19937 rng(seed);
+    std::vector<std::pair<uint32_t, int>> prefixes;
+    for (int i = 0; i < count; i++) {
+        const int len = random_length(rng, lengths);
+        // Unicast space from 1.0.0.0 to 223.255.255.255.
+        const uint32_t address = (1 + rng() % 223) << 24 | (rng() & 0xffffff);
+        prefixes.emplace_back(address & (~uint32_t{0} << (32 - len)), len);
+    }
+    return prefixes;
+}
+
+/// Generates IPv6 prefixes under 2000::/3 with the mix of lengths of a BGP table, mostly /48s.
+std::vector<std::pair<Ipv6Address, int>> ipv6_prefixes(int count, uint32_t seed) {
+    const std::vector<std::pair<int, int>> lengths = {
+        {48, 50}, {32, 15}, {44, 10}, {40, 8}, {36, 5}, {29, 5}, {56, 4}, {64, 3},
+    };
+    std::mt19937 rng(seed);
+
+    // Allocations cluster under a few thousand /24s of the registries.
+    std::vector<uint32_t> allocations(4096);
+    for (uint32_t &allocation : allocations) {
+        allocation = 0x200000 | (rng() & 0x1fffff);
+    }
+
+    std::vector<std::pair<Ipv6Address, int>> prefixes;
+    for (int i = 0; i < count; i++) {
+        const int len = random_length(rng, lengths);
+        const uint32_t allocation = allocations[rng() % allocations.size()];
+        Ipv6Address address{};
+        address[0] = static_cast<uint8_t>(allocation >> 16);
+        address[1] = static_cast<uint8_t>(allocation >> 8);
+        address[2] = static_cast<uint8_t>(allocation);
+        for (int byte = 3; byte < 8; byte++) {
+            address[byte] = static_cast<uint8_t>(rng());
+        }
+        for (int bit = len; bit < 64; bit++) {
+            address[bit / 8] &= static_cast<uint8_t>(~(0x80 >> (bit % 8)));
+        }
+        prefixes.emplace_back(address, len);
+    }
+    return prefixes;
+}
+
+/// Generates addresses under random prefixes of a table, with random host bits.
+std::vector<uint32_t> ipv4_addresses(const std::vector<std::pair<uint32_t, int>> &prefixes,
+                                     uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::vector<uint32_t> addresses(address_count);
+    for (uint32_t &address : addresses) {
+        const auto &[prefix, len] = prefixes[rng() % prefixes.size()];
+        address = prefix | (len == 32 ? 0 : rng() & (~uint32_t{0} >> len));
+    }
+    return addresses;
+}
+
+/// Generates addresses under random prefixes of a table, with random host bits.
+std::vector<Ipv6Address> ipv6_addresses(const std::vector<std::pair<Ipv6Address, int>> &prefixes,
+                                        uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::vector<Ipv6Address> addresses(address_count);
+    for (Ipv6Address &address : addresses) {
+        const auto &[prefix, len] = prefixes[rng() % prefixes.size()];
+        address = prefix;
+        for (int bit = len; bit < 128; bit++) {
+            if (rng() & 1) {
+                address[bit / 8] |= static_cast<uint8_t>(0x80 >> (bit % 8));
+            }
+        }
+    }
+    return addresses;
+}
+
+/// Looks up the specified number of addresses in batches.
+template <typename Lpm, typename Address>
+void lookup_batches(std::size_t _iterations, const Lpm &lpm,
+                    const std::vector<Address> &addresses) {
+    int returns[batch_size];
+    std::size_t done = 0;
+    while (done < _iterations) {
+        const std::size_t first = done % address_count;
+        const std::size_t count = std::min({batch_size, _iterations - done, address_count - first});
+        lpm.get_batch(&addresses[first], returns, count);
+        do_not_optimize(returns);
+        done += count;
+    }
+}
+
+START_BENCH_SUITE(Lpm)
+
+const std::vector<std::pair<uint32_t, int>> v4_prefixes = ipv4_prefixes(ipv4_prefix_count, 1);
+const std::vector<uint32_t> v4_addresses = ipv4_addresses(v4_prefixes, 2);
+Ipv4Lpm<int> v4(no_match);
+for (int i = 0; i < ipv4_prefix_count; i++) {
+    v4.insert(v4_prefixes[i].first, v4_prefixes[i].second, i);
+}
+
+const std::vector<std::pair<Ipv6Address, int>> v6_prefixes = ipv6_prefixes(ipv6_prefix_count, 3);
+const std::vector<Ipv6Address> v6_addresses = ipv6_addresses(v6_prefixes, 4);
+Ipv6Lpm<int> v6(no_match);
+for (int i = 0; i < ipv6_prefix_count; i++) {
+    v6.insert(v6_prefixes[i].first, v6_prefixes[i].second, i);
+}
+
+// Baseline: a byte trie of the IPv4 prefixes rounded to whole bytes, which only finds the entry
+// of an address's /24 rather than its longest match.
+DefaultTrie<uint8_t, int> trie(no_match);
+for (int i = 0; i < ipv4_prefix_count; i++) {
+    const uint32_t prefix = v4_prefixes[i].first;
+    const uint8_t bytes[] = {static_cast<uint8_t>(prefix >> 24), static_cast<uint8_t>(prefix >> 16),
+                             static_cast<uint8_t>(prefix >> 8)};
+    trie.insert(bytes, std::min(3, (v4_prefixes[i].second + 7) / 8), i);
+}
+
+START_BENCH(Ipv4Get) {
+    BENCH_LOOP { do_not_optimize(v4.get(v4_addresses[_iteration % address_count])); }
+}
+END_BENCH
+
+START_BENCH(Ipv4GetBatch) { lookup_batches(_iterations, v4, v4_addresses); }
+END_BENCH
+
+START_BENCH(Ipv4DefaultTrieBaseline) {
+    BENCH_LOOP {
+        const uint32_t address = v4_addresses[_iteration % address_count];
+        const uint8_t bytes[] = {static_cast<uint8_t>(address >> 24),
+                                 static_cast<uint8_t>(address >> 16),
+                                 static_cast<uint8_t>(address >> 8)};
+        do_not_optimize(trie.get(bytes, 3));
+    }
+}
+END_BENCH
+
+START_BENCH(Ipv4RemoveInsert) {
+    BENCH_LOOP {
+        const auto &[prefix, len] = v4_prefixes[_iteration % ipv4_prefix_count];
+        v4.remove(prefix, len);
+        v4.insert(prefix, len, static_cast<int>(_iteration % ipv4_prefix_count));
+    }
+}
+END_BENCH
+
+START_BENCH(Ipv6Get) {
+    BENCH_LOOP { do_not_optimize(v6.get(v6_addresses[_iteration % address_count])); }
+}
+END_BENCH
+
+START_BENCH(Ipv6GetBatch) { lookup_batches(_iterations, v6, v6_addresses); }
+END_BENCH
+
+START_BENCH(Ipv6RemoveInsert) {
+    BENCH_LOOP {
+        const auto &[prefix, len] = v6_prefixes[_iteration % ipv6_prefix_count];
+        v6.remove(prefix, len);
+        v6.insert(prefix, len, static_cast<int>(_iteration % ipv6_prefix_count));
+    }
+}
+END_BENCH
+
+END_BENCH_SUITE
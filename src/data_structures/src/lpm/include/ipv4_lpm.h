@@ -0,0 +1,285 @@
+#ifndef LIBCC_DATA_STRUCTURES_IPV4_LPM_H
+#define LIBCC_DATA_STRUCTURES_IPV4_LPM_H
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+namespace ostp::libcc::data_structures {
+
+/// Longest prefix match over IPv4 addresses with the DIR-24-8 layout.
+///
+/// Prefixes of any length from 0 to 32 bits are expanded into a table with an entry for every
+/// /24, and prefixes longer than 24 bits into groups of 256 entries, one per address, that the
+/// entry of their /24 points to. A lookup therefore reads one entry, or two for addresses under
+/// a prefix longer than 24 bits. Each entry keeps the length of the prefix it was expanded from,
+/// so inserting and removing a prefix only rewrites the entries it covers, and groups whose
+/// entries become identical again are folded back into their /24.
+///
+/// Addresses and prefixes are in host byte order, so 10.0.0.0 is 0x0a000000. The table of /24
+/// entries takes 64 MiB.
+template <typename R>
+class Ipv4Lpm {
+   public:
+    /// Constructs an empty table.
+    ///
+    /// Arguments:
+    ///     default_return: The return for addresses no prefix matches.
+    explicit Ipv4Lpm(const R default_return)
+        : default_return(default_return), tbl24(std::size_t{1} << 24, EMPTY) {}
+
+    /// Inserts a prefix or replaces its return.
+    ///
+    /// Arguments:
+    ///     prefix: The prefix, whose bits past its length are ignored.
+    ///     prefix_len: The length of the prefix in bits.
+    ///     prefix_return: The return for addresses the prefix is the longest match of.
+    ///
+    /// Throws:
+    ///     std::runtime_error if the length is not in [0, 32] or the table is full.
+    void insert(uint32_t prefix, const int prefix_len, const R prefix_return) {
+        check_length(prefix_len);
+        prefix &= mask(prefix_len);
+        const auto it = rules[prefix_len].find(prefix);
+        if (it != rules[prefix_len].end()) {
+            results[it->second] = prefix_return;
+            return;
+        }
+
+        if (free_ids.empty() && results.size() == EMPTY) {
+            throw std::runtime_error("Too many prefixes");
+        }
+        uint32_t id;
+        if (!free_ids.empty()) {
+            id = free_ids.back();
+            free_ids.pop_back();
+            results[id] = prefix_return;
+        } else {
+            id = static_cast<uint32_t>(results.size());
+            results.push_back(prefix_return);
+        }
+        rules[prefix_len].emplace(prefix, id);
+
+        // Overwrite the entries of the prefix not already expanded from a longer one.
+        const uint32_t entry = make_entry(prefix_len, id);
+        const auto covered = [prefix_len](uint32_t current) {
+            return depth(current) <= prefix_len;
+        };
+        if (prefix_len <= 24) {
+            const uint32_t first = prefix >> 8;
+            const uint32_t last = first + (uint32_t{1} << (24 - prefix_len));
+            for (uint32_t i = first; i < last; i++) {
+                if (tbl24[i] & EXTENDED) {
+                    fill_group(tbl24[i] & PAYLOAD, 0, 256, entry, covered);
+                } else if (covered(tbl24[i])) {
+                    tbl24[i] = entry;
+                }
+            }
+        } else {
+            const uint32_t i = prefix >> 8;
+            if (!(tbl24[i] & EXTENDED)) {
+                tbl24[i] = EXTENDED | allocate_group(tbl24[i]);
+            }
+            const uint32_t first = prefix & 0xff;
+            fill_group(tbl24[i] & PAYLOAD, first, first + (uint32_t{1} << (32 - prefix_len)),
+                       entry, covered);
+        }
+    }
+
+    /// Removes a prefix if the table holds it.
+    ///
+    /// Arguments:
+    ///     prefix: The prefix, whose bits past its length are ignored.
+    ///     prefix_len: The length of the prefix in bits.
+    ///
+    /// Throws:
+    ///     std::runtime_error if the length is not in [0, 32].
+    void remove(uint32_t prefix, const int prefix_len) {
+        check_length(prefix_len);
+        prefix &= mask(prefix_len);
+        const auto it = rules[prefix_len].find(prefix);
+        if (it == rules[prefix_len].end()) {
+            return;
+        }
+        const uint32_t id = it->second;
+        rules[prefix_len].erase(it);
+        free_ids.push_back(id);
+
+        // The entries expanded from the prefix fall back to the longest shorter prefix covering
+        // it, or to no match.
+        uint32_t replacement = EMPTY;
+        for (int len = prefix_len - 1; len >= 0; len--) {
+            const auto covering = rules[len].find(prefix & mask(len));
+            if (covering != rules[len].end()) {
+                replacement = make_entry(len, covering->second);
+                break;
+            }
+        }
+        const uint32_t removed = make_entry(prefix_len, id);
+        const auto expanded = [removed](uint32_t current) { return current == removed; };
+        if (prefix_len <= 24) {
+            const uint32_t first = prefix >> 8;
+            const uint32_t last = first + (uint32_t{1} << (24 - prefix_len));
+            for (uint32_t i = first; i < last; i++) {
+                if (tbl24[i] & EXTENDED) {
+                    fill_group(tbl24[i] & PAYLOAD, 0, 256, replacement, expanded);
+                    fold_group(i);
+                } else if (expanded(tbl24[i])) {
+                    tbl24[i] = replacement;
+                }
+            }
+        } else {
+            const uint32_t i = prefix >> 8;
+            const uint32_t first = prefix & 0xff;
+            fill_group(tbl24[i] & PAYLOAD, first, first + (uint32_t{1} << (32 - prefix_len)),
+                       replacement, expanded);
+            fold_group(i);
+        }
+    }
+
+    /// Returns whether the table holds a prefix.
+    ///
+    /// Throws:
+    ///     std::runtime_error if the length is not in [0, 32].
+    bool contains(uint32_t prefix, const int prefix_len) const {
+        check_length(prefix_len);
+        return rules[prefix_len].contains(prefix & mask(prefix_len));
+    }
+
+    /// Returns the return of the longest prefix matching an address, or the default return.
+    R get(const uint32_t address) const {
+        uint32_t entry = tbl24[address >> 8];
+        if (entry & EXTENDED) {
+            entry = tbl8[((entry & PAYLOAD) << 8) | (address & 0xff)];
+        }
+        return entry == EMPTY ? default_return : results[entry & PAYLOAD];
+    }
+
+    /// Looks up many addresses, reading the entries of a group of them before resolving any so
+    /// that their cache misses overlap.
+    ///
+    /// Arguments:
+    ///     addresses: The addresses to look up.
+    ///     returns: Receives the return of each address.
+    ///     count: The number of addresses.
+    void get_batch(const uint32_t addresses[], R returns[], const std::size_t count) const {
+        uint32_t entries[BATCH_WIDTH];
+        for (std::size_t first = 0; first < count; first += BATCH_WIDTH) {
+            const std::size_t width = std::min(BATCH_WIDTH, count - first);
+            for (std::size_t i = 0; i < width; i++) {
+                entries[i] = tbl24[addresses[first + i] >> 8];
+            }
+            for (std::size_t i = 0; i < width; i++) {
+                uint32_t entry = entries[i];
+                if (entry & EXTENDED) {
+                    entry = tbl8[((entry & PAYLOAD) << 8) | (addresses[first + i] & 0xff)];
+                }
+                returns[first + i] = entry == EMPTY ? default_return : results[entry & PAYLOAD];
+            }
+        }
+    }
+
+    /// Updates the return for addresses no prefix matches.
+    void update_default_return(const R default_return) { this->default_return = default_return; }
+
+    /// Returns the number of prefixes.
+    std::size_t size() const { return results.size() - free_ids.size(); }
+
+    /// Returns the number of groups of 256 entries in use for prefixes longer than 24 bits.
+    std::size_t group_count() const { return tbl8.size() / 256 - free_groups.size(); }
+
+   private:
+    /// Entry pointing to a group rather than holding a result.
+    static constexpr uint32_t EXTENDED = uint32_t{1} << 31;
+
+    /// Position of the length of the prefix an entry was expanded from.
+    static constexpr int DEPTH_SHIFT = 25;
+
+    /// Bits of the result or group of an entry.
+    static constexpr uint32_t PAYLOAD = (uint32_t{1} << DEPTH_SHIFT) - 1;
+
+    /// Entry without any match, whose payload no result has.
+    static constexpr uint32_t EMPTY = PAYLOAD;
+
+    /// Number of addresses a batch lookup reads the entries of together.
+    static constexpr std::size_t BATCH_WIDTH = 16;
+
+    /// Returns the mask of the bits of a prefix length.
+    static uint32_t mask(const int prefix_len) {
+        return prefix_len == 0 ? 0 : ~uint32_t{0} << (32 - prefix_len);
+    }
+
+    /// Returns the entry of a result expanded from a prefix of the specified length.
+    static uint32_t make_entry(const int prefix_len, const uint32_t id) {
+        return (static_cast<uint32_t>(prefix_len) << DEPTH_SHIFT) | id;
+    }
+
+    /// Returns the length of the prefix an entry without a group was expanded from.
+    static int depth(const uint32_t entry) {
+        return entry == EMPTY ? -1 : static_cast<int>(entry >> DEPTH_SHIFT);
+    }
+
+    /// Throws if a prefix length is out of range.
+    static void check_length(const int prefix_len) {
+        if (prefix_len < 0 || prefix_len > 32) {
+            throw std::runtime_error("Invalid prefix length");
+        }
+    }
+
+    /// Returns a group with every entry set to the entry of the /24 it extends.
+    uint32_t allocate_group(const uint32_t entry) {
+        uint32_t group;
+        if (!free_groups.empty()) {
+            group = free_groups.back();
+            free_groups.pop_back();
+        } else {
+            group = static_cast<uint32_t>(tbl8.size() / 256);
+            tbl8.resize(tbl8.size() + 256);
+        }
+        std::fill_n(tbl8.begin() + std::size_t{group} * 256, 256, entry);
+        return group;
+    }
+
+    /// Sets the entries [first, last) of a group that satisfy a condition.
+    template <typename Condition>
+    void fill_group(const uint32_t group, const uint32_t first, const uint32_t last,
+                    const uint32_t entry, const Condition &condition) {
+        uint32_t *entries = &tbl8[std::size_t{group} * 256];
+        for (uint32_t j = first; j < last; j++) {
+            if (condition(entries[j])) {
+                entries[j] = entry;
+            }
+        }
+    }
+
+    /// Folds the group of a /24 back into it if its entries are all the same.
+    void fold_group(const uint32_t i) {
+        const uint32_t group = tbl24[i] & PAYLOAD;
+        const uint32_t *entries = &tbl8[std::size_t{group} * 256];
+        for (int j = 1; j < 256; j++) {
+            if (entries[j] != entries[0]) {
+                return;
+            }
+        }
+        tbl24[i] = entries[0];
+        free_groups.push_back(group);
+    }
+
+    R default_return;                   // Return for no match.
+    std::vector<uint32_t> tbl24;        // Entry of each /24.
+    std::vector<uint32_t> tbl8;         // Groups of 256 entries.
+    std::vector<uint32_t> free_groups;  // Groups no /24 points to.
+    std::vector<R> results;             // Return of each prefix.
+    std::vector<uint32_t> free_ids;     // Unused results.
+
+    /// Result of each prefix, by prefix length.
+    std::array<std::unordered_map<uint32_t, uint32_t>, 33> rules;
+};
+
+}  // namespace ostp::libcc::data_structures
+
+#endif
@@ -0,0 +1,468 @@
+#ifndef LIBCC_DATA_STRUCTURES_IPV6_LPM_H
+#define LIBCC_DATA_STRUCTURES_IPV6_LPM_H
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace ostp::libcc::data_structures {
+
+/// An IPv6 address or prefix in network byte order.
+using Ipv6Address = std::array<uint8_t, 16>;
+
+/// Longest prefix match over IPv6 addresses with a 16-bit root and compressed 8-bit strides.
+///
+/// The first 16 bits of an address index a direct table. Below it, each node consumes the next
+/// byte of the address. Prefixes are expanded to the byte they end in, so a node maps each of its
+/// 256 slots either to a child or to the return of the longest prefix covering the slot. Nodes
+/// store this compressed: a bitmap of the slots with a child and a bitmap of the slots where the
+/// return changes, and the children and distinct returns in slot order, each found by counting
+/// the bits set before the slot. Runs of slots sharing a return, the common case, cost one entry,
+/// so a node with a handful of children takes about a hundred bytes instead of a kilobyte.
+///
+/// The prefixes themselves are kept in an ordered map, and inserting or removing one rebuilds the
+/// node the prefix ends in from it, keeping the children whose contents did not change.
+template <typename R>
+class Ipv6Lpm {
+   public:
+    /// Constructs an empty table.
+    ///
+    /// Arguments:
+    ///     default_return: The return for addresses no prefix matches.
+    explicit Ipv6Lpm(const R default_return)
+        : default_return(default_return), root_leaves(ROOT_SLOTS, NONE),
+          root_children(ROOT_SLOTS) {}
+
+    /// Inserts a prefix or replaces its return.
+    ///
+    /// Arguments:
+    ///     prefix: The prefix, whose bits past its length are ignored.
+    ///     prefix_len: The length of the prefix in bits.
+    ///     prefix_return: The return for addresses the prefix is the longest match of.
+    ///
+    /// Throws:
+    ///     std::runtime_error if the length is not in [0, 128].
+    void insert(const Ipv6Address &prefix, const int prefix_len, const R prefix_return) {
+        check_length(prefix_len);
+        const Ipv6Address base = masked(prefix, prefix_len);
+        const auto it = rules.find({base, prefix_len});
+        if (it != rules.end()) {
+            results[it->second] = prefix_return;
+            return;
+        }
+
+        uint32_t id;
+        if (!free_ids.empty()) {
+            id = free_ids.back();
+            free_ids.pop_back();
+            results[id] = prefix_return;
+        } else {
+            id = static_cast<uint32_t>(results.size());
+            results.push_back(prefix_return);
+        }
+        rules.emplace(std::make_pair(base, prefix_len), id);
+        update(base, prefix_len);
+    }
+
+    /// Removes a prefix if the table holds it.
+    ///
+    /// Arguments:
+    ///     prefix: The prefix, whose bits past its length are ignored.
+    ///     prefix_len: The length of the prefix in bits.
+    ///
+    /// Throws:
+    ///     std::runtime_error if the length is not in [0, 128].
+    void remove(const Ipv6Address &prefix, const int prefix_len) {
+        check_length(prefix_len);
+        const Ipv6Address base = masked(prefix, prefix_len);
+        const auto it = rules.find({base, prefix_len});
+        if (it == rules.end()) {
+            return;
+        }
+        free_ids.push_back(it->second);
+        rules.erase(it);
+        update(base, prefix_len);
+    }
+
+    /// Returns whether the table holds a prefix.
+    ///
+    /// Throws:
+    ///     std::runtime_error if the length is not in [0, 128].
+    bool contains(const Ipv6Address &prefix, const int prefix_len) const {
+        check_length(prefix_len);
+        return rules.contains({masked(prefix, prefix_len), prefix_len});
+    }
+
+    /// Returns the return of the longest prefix matching an address, or the default return.
+    R get(const Ipv6Address &address) const {
+        const uint32_t root = root_slot(address);
+        const Node *node = root_children[root].get();
+        if (node == nullptr) {
+            return result(root_leaves[root]);
+        }
+        for (int byte = 2;; byte++) {
+            const Node *child = descend(*node, address[byte]);
+            if (child == nullptr) {
+                return result(leaf(*node, address[byte]));
+            }
+            node = child;
+        }
+    }
+
+    /// Looks up many addresses, walking groups of them down the nodes together so the cache
+    /// misses of each level overlap instead of one lookup waiting on the next.
+    ///
+    /// Arguments:
+    ///     addresses: The addresses to look up.
+    ///     returns: Receives the return of each address.
+    ///     count: The number of addresses.
+    void get_batch(const Ipv6Address addresses[], R returns[], const std::size_t count) const {
+        for (std::size_t first = 0; first < count; first += BATCH_WIDTH) {
+            const std::size_t width = std::min(BATCH_WIDTH, count - first);
+            const Ipv6Address *group = addresses + first;
+            const Node *nodes[BATCH_WIDTH];
+            bool active = false;
+            for (std::size_t i = 0; i < width; i++) {
+                const uint32_t root = root_slot(group[i]);
+                nodes[i] = root_children[root].get();
+                if (nodes[i] == nullptr) {
+                    returns[first + i] = result(root_leaves[root]);
+                } else {
+                    __builtin_prefetch(nodes[i]);
+                    active = true;
+                }
+            }
+            for (int byte = 2; active; byte++) {
+                active = false;
+                for (std::size_t i = 0; i < width; i++) {
+                    if (nodes[i] == nullptr) {
+                        continue;
+                    }
+                    const Node *child = descend(*nodes[i], group[i][byte]);
+                    if (child == nullptr) {
+                        returns[first + i] = result(leaf(*nodes[i], group[i][byte]));
+                    } else {
+                        __builtin_prefetch(child);
+                        active = true;
+                    }
+                    nodes[i] = child;
+                }
+            }
+        }
+    }
+
+    /// Updates the return for addresses no prefix matches.
+    void update_default_return(const R default_return) { this->default_return = default_return; }
+
+    /// Returns the number of prefixes.
+    std::size_t size() const { return rules.size(); }
+
+    /// Returns the number of nodes below the root table.
+    std::size_t node_count() const {
+        std::size_t count = 0;
+        for (const std::unique_ptr<Node> &child : root_children) {
+            if (child) {
+                count += nodes_under(*child);
+            }
+        }
+        return count;
+    }
+
+   private:
+    /// Number of slots of the root table.
+    static constexpr std::size_t ROOT_SLOTS = std::size_t{1} << 16;
+
+    /// Bits consumed by the root table.
+    static constexpr int ROOT_BITS = 16;
+
+    /// Bits consumed by each node.
+    static constexpr int STRIDE = 8;
+
+    /// Leaf without any match.
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    /// Number of addresses a batch lookup walks down together.
+    static constexpr std::size_t BATCH_WIDTH = 16;
+
+    /// A node consuming one byte of the address, its 256 slots compressed. Descending to a child
+    /// only reads the first cache line.
+    struct alignas(64) Node {
+        std::array<uint64_t, 4> child_bits{};   // Slots leading to a child.
+        std::array<uint16_t, 4> child_ranks{};  // Child slots before each word.
+        std::unique_ptr<Node[]> children;       // Children in slot order.
+        std::array<uint64_t, 4> leaf_bits{};    // Leaf slots whose leaf differs from the last.
+        std::array<uint16_t, 4> leaf_ranks{};   // Leaf bits set before each word.
+        std::unique_ptr<uint32_t[]> leaves;     // Result of each run of leaf slots.
+        uint32_t inherited = NONE;              // Result covering the whole node.
+    };
+
+    /// Returns the child below a slot of a node, or null if the slot is a leaf.
+    static const Node *descend(const Node &node, const unsigned slot) {
+        const unsigned word = slot >> 6;
+        const uint64_t bit = uint64_t{1} << (slot & 63);
+        if (!(node.child_bits[word] & bit)) {
+            return nullptr;
+        }
+        return &node.children[node.child_ranks[word] +
+                              std::popcount(node.child_bits[word] & (bit - 1))];
+    }
+
+    /// Returns the result of a leaf slot of a node.
+    static uint32_t leaf(const Node &node, const unsigned slot) {
+        const unsigned word = slot >> 6;
+        const uint64_t bit = uint64_t{1} << (slot & 63);
+        return node.leaves[node.leaf_ranks[word] +
+                           std::popcount(node.leaf_bits[word] & (bit | (bit - 1))) - 1];
+    }
+
+    /// Returns the return of a result, or the default return.
+    R result(const uint32_t id) const { return id == NONE ? default_return : results[id]; }
+
+    /// Throws if a prefix length is out of range.
+    static void check_length(const int prefix_len) {
+        if (prefix_len < 0 || prefix_len > 128) {
+            throw std::runtime_error("Invalid prefix length");
+        }
+    }
+
+    /// Returns an address with the bits past a length cleared.
+    static Ipv6Address masked(Ipv6Address address, const int len) {
+        for (int byte = 0; byte < 16; byte++) {
+            const int bits = std::clamp(len - byte * 8, 0, 8);
+            address[byte] &= static_cast<uint8_t>(0xff00 >> bits);
+        }
+        return address;
+    }
+
+    /// Returns the number of nodes of a subtree.
+    static std::size_t nodes_under(const Node &node) {
+        std::size_t count = 1;
+        const int children = node.child_ranks[3] + std::popcount(node.child_bits[3]);
+        for (int c = 0; c < children; c++) {
+            count += nodes_under(node.children[c]);
+        }
+        return count;
+    }
+
+    /// Returns whether a region, the addresses whose first base_len bits are those of base,
+    /// holds prefixes longer than base_len.
+    bool has_rules_inside(const Ipv6Address &base, const int base_len) const {
+        const auto it = rules.lower_bound({base, base_len + 1});
+        return it != rules.end() && masked(it->first.first, base_len) == base;
+    }
+
+    /// Returns the result of the longest prefix of at most max_len bits covering an address.
+    uint32_t covering(const Ipv6Address &address, const int max_len) const {
+        for (int len = max_len; len >= 0; len--) {
+            const auto it = rules.find({masked(address, len), len});
+            if (it != rules.end()) {
+                return it->second;
+            }
+        }
+        return NONE;
+    }
+
+    /// Returns the root slot of an address.
+    static uint32_t root_slot(const Ipv6Address &address) {
+        return (uint32_t{address[0]} << 8) | address[1];
+    }
+
+    /// Expands the prefixes inside a region ending by some length into slots indexed by the bits
+    /// of the address from the region's length to that one, longer prefixes overwriting shorter
+    /// ones, and marks the slots holding longer prefixes.
+    ///
+    /// Arguments:
+    ///     base: The region, with the bits past base_len cleared.
+    ///     base_len: The bits fixed in the region.
+    ///     end_len: The length the slots end at, 16 or a multiple of 8 above base_len.
+    ///     slots: The slots, filled beforehand with the result covering the region.
+    ///     deeper: Receives whether each slot holds longer prefixes, unless null.
+    void expand(const Ipv6Address &base, const int base_len, const int end_len, uint32_t slots[],
+                bool deeper[]) const {
+        std::vector<std::pair<int, std::pair<uint32_t, uint32_t>>> ending;
+        const uint32_t slot_mask = (uint32_t{1} << (end_len - base_len)) - 1;
+        for (auto it = rules.lower_bound({base, base_len + 1});
+             it != rules.end() && masked(it->first.first, base_len) == base; ++it) {
+            const Ipv6Address &address = it->first.first;
+            const uint32_t top =
+                end_len == ROOT_BITS ? root_slot(address) : address[end_len / 8 - 1];
+            const uint32_t slot = top & slot_mask;
+            const int len = it->first.second;
+            if (len <= end_len) {
+                ending.push_back({len, {slot, it->second}});
+            } else if (deeper != nullptr) {
+                deeper[slot] = true;
+            }
+        }
+        std::stable_sort(ending.begin(), ending.end(),
+                         [](const auto &a, const auto &b) { return a.first < b.first; });
+        for (const auto &[len, rule] : ending) {
+            std::fill_n(slots + rule.first, uint32_t{1} << (end_len - len), rule.second);
+        }
+    }
+
+    /// Builds the node of a region from the prefixes inside it.
+    ///
+    /// Arguments:
+    ///     base: The region, with the bits past base_len cleared.
+    ///     base_len: The bits fixed in the region.
+    ///     inherited: The result covering the whole region.
+    ///     old: The node previously built for the region, whose children are moved over when
+    ///         their contents are still valid, or null.
+    Node build(const Ipv6Address &base, const int base_len, const uint32_t inherited,
+               Node *old) const {
+        uint32_t slots[256];
+        bool deeper[256] = {};
+        std::fill_n(slots, 256, inherited);
+        expand(base, base_len, base_len + STRIDE, slots, deeper);
+
+        Node node;
+        node.inherited = inherited;
+        int child_count = 0;
+        int leaf_count = 0;
+        uint32_t last_leaf = NONE;
+        for (int slot = 0; slot < 256; slot++) {
+            const uint64_t bit = uint64_t{1} << (slot & 63);
+            if (deeper[slot]) {
+                node.child_bits[slot >> 6] |= bit;
+                child_count++;
+            } else if (leaf_count == 0 || slots[slot] != last_leaf) {
+                node.leaf_bits[slot >> 6] |= bit;
+                last_leaf = slots[slot];
+                leaf_count++;
+            }
+        }
+        for (int word = 1; word < 4; word++) {
+            node.child_ranks[word] =
+                node.child_ranks[word - 1] + std::popcount(node.child_bits[word - 1]);
+            node.leaf_ranks[word] =
+                node.leaf_ranks[word - 1] + std::popcount(node.leaf_bits[word - 1]);
+        }
+
+        if (child_count > 0) {
+            node.children = std::make_unique<Node[]>(child_count);
+        }
+        if (leaf_count > 0) {
+            node.leaves = std::make_unique<uint32_t[]>(leaf_count);
+        }
+        int child = 0;
+        int leaf = 0;
+        for (int slot = 0; slot < 256; slot++) {
+            const unsigned word = slot >> 6;
+            const uint64_t bit = uint64_t{1} << (slot & 63);
+            if (node.child_bits[word] & bit) {
+                // A child below a slot whose covering result did not change holds the same.
+                Node *reused = nullptr;
+                if (old != nullptr && (old->child_bits[word] & bit)) {
+                    Node &candidate = old->children[old->child_ranks[word] +
+                                                    std::popcount(old->child_bits[word] &
+                                                                  (bit - 1))];
+                    if (candidate.inherited == slots[slot]) {
+                        reused = &candidate;
+                    }
+                }
+                if (reused != nullptr) {
+                    node.children[child++] = std::move(*reused);
+                } else {
+                    Ipv6Address child_base = base;
+                    child_base[base_len / 8] = static_cast<uint8_t>(slot);
+                    node.children[child++] =
+                        build(child_base, base_len + STRIDE, slots[slot], nullptr);
+                }
+            } else if (node.leaf_bits[word] & bit) {
+                node.leaves[leaf++] = slots[slot];
+            }
+        }
+        return node;
+    }
+
+    /// Brings the root table and the nodes up to date after a prefix was inserted or removed.
+    void update(const Ipv6Address &prefix, const int prefix_len) {
+        if (prefix_len <= ROOT_BITS) {
+            update_root(prefix, prefix_len);
+            return;
+        }
+
+        // Find the node the prefix ends in, or the deepest one on its way.
+        const uint32_t root = root_slot(prefix);
+        std::vector<Node *> path;
+        Node *node = root_children[root].get();
+        int base_len = ROOT_BITS;
+        while (node != nullptr) {
+            path.push_back(node);
+            if (prefix_len <= base_len + STRIDE) {
+                break;
+            }
+            const unsigned slot = prefix[base_len / 8];
+            const uint64_t bit = uint64_t{1} << (slot & 63);
+            if (!(node->child_bits[slot >> 6] & bit)) {
+                break;
+            }
+            node = &node->children[node->child_ranks[slot >> 6] +
+                                   std::popcount(node->child_bits[slot >> 6] & (bit - 1))];
+            base_len += STRIDE;
+        }
+
+        // Rebuild the deepest node on the way whose region still holds prefixes, so nodes left
+        // empty by a removal are dropped.
+        while (!path.empty() && !has_rules_inside(masked(prefix, base_len), base_len)) {
+            path.pop_back();
+            base_len -= STRIDE;
+        }
+        if (path.empty()) {
+            if (has_rules_inside(masked(prefix, ROOT_BITS), ROOT_BITS)) {
+                root_children[root] = std::make_unique<Node>(
+                    build(masked(prefix, ROOT_BITS), ROOT_BITS, root_leaves[root], nullptr));
+            } else {
+                root_children[root].reset();
+            }
+            return;
+        }
+        Node *target = path.back();
+        *target = build(masked(prefix, base_len), base_len, target->inherited, target);
+    }
+
+    /// Brings the root slots of a prefix of at most 16 bits up to date, and the nodes below the
+    /// slots whose covering result changed.
+    void update_root(const Ipv6Address &prefix, const int prefix_len) {
+        const uint32_t first = root_slot(prefix);
+        std::vector<uint32_t> slots(std::size_t{1} << (ROOT_BITS - prefix_len),
+                                    covering(prefix, prefix_len));
+        expand(prefix, prefix_len, ROOT_BITS, slots.data(), nullptr);
+
+        for (uint32_t i = 0; i < slots.size(); i++) {
+            const uint32_t slot = first + i;
+            if (root_leaves[slot] == slots[i]) {
+                continue;
+            }
+            root_leaves[slot] = slots[i];
+            if (root_children[slot]) {
+                Ipv6Address base{};
+                base[0] = static_cast<uint8_t>(slot >> 8);
+                base[1] = static_cast<uint8_t>(slot);
+                Node *child = root_children[slot].get();
+                *child = build(base, ROOT_BITS, slots[i], child);
+            }
+        }
+    }
+
+    R default_return;                                  // Return for no match.
+    std::vector<uint32_t> root_leaves;                 // Result covering each root slot.
+    std::vector<std::unique_ptr<Node>> root_children;  // Node below each root slot, if any.
+    std::vector<R> results;                            // Return of each prefix.
+    std::vector<uint32_t> free_ids;                    // Unused results.
+
+    /// Result of each prefix, by prefix and length.
+    std::map<std::pair<Ipv6Address, int>, uint32_t> rules;
+};
+
+}  // namespace ostp::libcc::data_structures
+
+#endif
@@ -0,0 +1,291 @@
+#include <cstdint>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "ipv4_lpm.h"
+#include "ipv6_lpm.h"
+#include "logger.h"
+#include "testing.h"
+
+using ostp::libcc::data_structures::Ipv4Lpm;
+using ostp::libcc::data_structures::Ipv6Address;
+using ostp::libcc::data_structures::Ipv6Lpm;
+using ostp::libcc::utils::log_error;
+
+const int none = -1;  // Default return.
+
+/// Returns the IPv4 address of four bytes.
+uint32_t ipv4(uint32_t a, uint32_t b, uint32_t c, uint32_t d) {
+    return (a << 24) | (b << 16) | (c << 8) | d;
+}
+
+/// Returns whether the first bits of two IPv6 addresses are the same.
+bool same_prefix(const Ipv6Address &a, const Ipv6Address &b, int len) {
+    for (int bit = 0; bit < len; bit++) {
+        const int shift = 7 - bit % 8;
+        if (((a[bit / 8] >> shift) & 1) != ((b[bit / 8] >> shift) & 1)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// Returns an IPv6 address with its first bits from a prefix and the rest random.
+Ipv6Address random_under(const Ipv6Address &prefix, int len, std::mt19937 &rng) {
+    Ipv6Address address;
+    for (int byte = 0; byte < 16; byte++) {
+        address[byte] = static_cast<uint8_t>(rng());
+    }
+    for (int bit = 0; bit < len; bit++) {
+        const uint8_t mask = static_cast<uint8_t>(0x80 >> (bit % 8));
+        address[bit / 8] = (address[bit / 8] & ~mask) | (prefix[bit / 8] & mask);
+    }
+    return address;
+}
+
+START_SUITE(Lpm_Tests)
+
+START_TEST(Ipv4LongestPrefixWins) {
+    Ipv4Lpm<int> lpm(none);
+    lpm.insert(ipv4(10, 0, 0, 0), 8, 1);
+    lpm.insert(ipv4(10, 1, 0, 0), 16, 2);
+    lpm.insert(ipv4(10, 1, 2, 0), 24, 3);
+    lpm.insert(ipv4(10, 1, 2, 128), 25, 4);
+    lpm.insert(ipv4(10, 1, 2, 7), 32, 5);
+    lpm.insert(ipv4(10, 64, 0, 0), 10, 6);  // Not byte aligned.
+
+    TEST(lpm.size() == 6);
+    TEST(lpm.get(ipv4(11, 0, 0, 0)) == none);
+    TEST(lpm.get(ipv4(10, 0, 0, 1)) == 1);
+    TEST(lpm.get(ipv4(10, 1, 3, 1)) == 2);
+    TEST(lpm.get(ipv4(10, 1, 2, 1)) == 3);
+    TEST(lpm.get(ipv4(10, 1, 2, 200)) == 4);
+    TEST(lpm.get(ipv4(10, 1, 2, 7)) == 5);
+    TEST(lpm.get(ipv4(10, 127, 255, 255)) == 6);
+    TEST(lpm.get(ipv4(10, 128, 0, 0)) == 1);
+
+    // The bits past the length are ignored and inserting again replaces the return.
+    lpm.insert(ipv4(10, 1, 99, 99), 16, 7);
+    TEST(lpm.size() == 6);
+    TEST(lpm.contains(ipv4(10, 1, 0, 0), 16));
+    TEST(!lpm.contains(ipv4(10, 1, 0, 0), 17));
+    TEST(lpm.get(ipv4(10, 1, 3, 1)) == 7);
+
+    // A default route matches everything else.
+    lpm.insert(0, 0, 0);
+    TEST(lpm.get(ipv4(192, 168, 1, 1)) == 0);
+    lpm.update_default_return(-2);
+    lpm.remove(0, 0);
+    TEST(lpm.get(ipv4(192, 168, 1, 1)) == -2);
+}
+END_TEST
+
+START_TEST(Ipv4RemovalRestoresShorterPrefixes) {
+    Ipv4Lpm<int> lpm(none);
+    lpm.insert(ipv4(10, 1, 0, 0), 16, 1);
+    lpm.insert(ipv4(10, 1, 2, 0), 24, 2);
+    lpm.insert(ipv4(10, 1, 2, 16), 28, 3);
+    TEST(lpm.group_count() == 1);
+
+    lpm.remove(ipv4(10, 1, 2, 0), 24);
+    TEST(lpm.get(ipv4(10, 1, 2, 1)) == 1);
+    TEST(lpm.get(ipv4(10, 1, 2, 17)) == 3);
+
+    // Once its entries are the same again, the group folds back into its /24.
+    lpm.remove(ipv4(10, 1, 2, 16), 28);
+    TEST(lpm.get(ipv4(10, 1, 2, 17)) == 1);
+    TEST(lpm.group_count() == 0);
+    TEST(lpm.size() == 1);
+
+    // Removing a missing prefix does nothing.
+    lpm.remove(ipv4(10, 1, 2, 16), 28);
+    TEST(lpm.size() == 1);
+}
+END_TEST
+
+START_TEST(Ipv4MatchesBruteForce) {
+    std::mt19937 rng(7);
+    Ipv4Lpm<int> lpm(none);
+    std::map<std::pair<uint32_t, int>, int> reference;
+
+    // Prefixes under a /10 so that they nest.
+    const auto random_prefix = [&rng]() {
+        const uint32_t address = ipv4(10, 0, 0, 0) | (rng() & 0x3fffff);
+        const int len = static_cast<int>(rng() % 33);
+        const uint32_t mask = len == 0 ? 0 : ~uint32_t{0} << (32 - len);
+        return std::make_pair(address & mask, len);
+    };
+    const auto longest_match = [&reference](uint32_t address) {
+        int best_len = -1;
+        int best = none;
+        for (const auto &[prefix, value] : reference) {
+            const uint32_t mask = prefix.second == 0 ? 0 : ~uint32_t{0} << (32 - prefix.second);
+            if ((address & mask) == prefix.first && prefix.second > best_len) {
+                best_len = prefix.second;
+                best = value;
+            }
+        }
+        return best;
+    };
+
+    for (int round = 0; round < 40; round++) {
+        for (int i = 0; i < 50; i++) {
+            const auto prefix = random_prefix();
+            if (rng() % 3 == 0 && !reference.empty()) {
+                const auto victim = std::next(reference.begin(), rng() % reference.size());
+                lpm.remove(victim->first.first, victim->first.second);
+                reference.erase(victim);
+            } else {
+                const int value = static_cast<int>(rng() % 1000);
+                lpm.insert(prefix.first, prefix.second, value);
+                reference[prefix] = value;
+            }
+        }
+        TEST(lpm.size() == reference.size());
+
+        std::vector<uint32_t> addresses;
+        for (int i = 0; i < 200; i++) {
+            addresses.push_back(random_prefix().first | (rng() & 0xff));
+        }
+        std::vector<int> returns(addresses.size());
+        lpm.get_batch(addresses.data(), returns.data(), addresses.size());
+        for (std::size_t i = 0; i < addresses.size(); i++) {
+            const int expected = longest_match(addresses[i]);
+            TEST(lpm.get(addresses[i]) == expected);
+            TEST(returns[i] == expected);
+        }
+    }
+
+    for (const auto &[prefix, value] : reference) {
+        lpm.remove(prefix.first, prefix.second);
+    }
+    TEST(lpm.size() == 0);
+    TEST(lpm.group_count() == 0);
+}
+END_TEST
+
+START_TEST(Ipv6LongestPrefixWins) {
+    Ipv6Lpm<int> lpm(none);
+    const Ipv6Address documentation = {0x20, 0x01, 0x0d, 0xb8};
+    lpm.insert(documentation, 32, 1);
+    lpm.insert({0x20, 0x01, 0x0d, 0xb8, 0x12, 0x34}, 48, 2);
+    lpm.insert({0x20, 0x01, 0x0d, 0xb8, 0x12, 0x34, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1}, 128, 3);
+    lpm.insert({0x20}, 3, 4);  // Not byte aligned.
+
+    TEST(lpm.size() == 4);
+    TEST(lpm.get({0x30}) == 4);
+    TEST(lpm.get({0x40}) == none);
+    TEST(lpm.get({0x20, 0x01, 0x0d, 0xb8, 0xff}) == 1);
+    TEST(lpm.get({0x20, 0x01, 0x0d, 0xb8, 0x12, 0x34, 0xff}) == 2);
+    TEST(lpm.get({0x20, 0x01, 0x0d, 0xb8, 0x12, 0x34, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1}) == 3);
+    TEST(lpm.get({0x20, 0x01, 0x0d, 0xb8, 0x12, 0x34, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2}) == 2);
+    TEST(lpm.contains({0x20, 0x01, 0x0d, 0xb8, 0xff}, 32));
+    TEST(!lpm.contains(documentation, 33));
+
+    // Changing a short prefix reaches the nodes below it.
+    lpm.insert({0x20, 0x01}, 16, 5);
+    lpm.remove(documentation, 32);
+    TEST(lpm.get({0x20, 0x01, 0x0d, 0xb8, 0xff}) == 5);
+    TEST(lpm.get({0x20, 0x01, 0x0d, 0xb8, 0x12, 0x34, 0xff}) == 2);
+
+    // Nodes left without prefixes are dropped.
+    TEST(lpm.node_count() > 0);
+    lpm.remove({0x20, 0x01, 0x0d, 0xb8, 0x12, 0x34}, 48);
+    lpm.remove({0x20, 0x01, 0x0d, 0xb8, 0x12, 0x34, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1}, 128);
+    TEST(lpm.node_count() == 0);
+    TEST(lpm.get({0x20, 0x01, 0x0d, 0xb8, 0x12, 0x34, 0xff}) == 5);
+
+    bool thrown = false;
+    try {
+        lpm.insert(documentation, 129, 0);
+    } catch (const std::runtime_error &) {
+        thrown = true;
+    }
+    TEST(thrown);
+}
+END_TEST
+
+START_TEST(Ipv6MatchesBruteForce) {
+    std::mt19937 rng(11);
+    Ipv6Lpm<int> lpm(none);
+    std::map<std::pair<Ipv6Address, int>, int> reference;
+
+    // Prefixes under a few seeds so that they nest at every depth.
+    std::vector<Ipv6Address> seeds;
+    for (int i = 0; i < 4; i++) {
+        seeds.push_back(random_under({0x20, 0x01, 0x0d, 0xb8}, 32, rng));
+    }
+    const auto random_address = [&]() {
+        const Ipv6Address &seed = seeds[rng() % seeds.size()];
+        return random_under(seed, static_cast<int>(rng() % 129), rng);
+    };
+    const auto longest_match = [&reference](const Ipv6Address &address) {
+        int best_len = -1;
+        int best = none;
+        for (const auto &[prefix, value] : reference) {
+            if (prefix.second > best_len && same_prefix(address, prefix.first, prefix.second)) {
+                best_len = prefix.second;
+                best = value;
+            }
+        }
+        return best;
+    };
+
+    for (int round = 0; round < 40; round++) {
+        for (int i = 0; i < 50; i++) {
+            if (rng() % 3 == 0 && !reference.empty()) {
+                const auto victim = std::next(reference.begin(), rng() % reference.size());
+                lpm.remove(victim->first.first, victim->first.second);
+                reference.erase(victim);
+                continue;
+            }
+            // Keep the reference keys masked like the table's, as its keys compare whole.
+            auto prefix = std::make_pair(random_address(), static_cast<int>(rng() % 129));
+            for (int bit = prefix.second; bit < 128; bit++) {
+                prefix.first[bit / 8] &= static_cast<uint8_t>(~(0x80 >> (bit % 8)));
+            }
+            const int value = static_cast<int>(rng() % 1000);
+            lpm.insert(prefix.first, prefix.second, value);
+            reference[prefix] = value;
+        }
+        TEST(lpm.size() == reference.size());
+
+        std::vector<Ipv6Address> addresses;
+        for (int i = 0; i < 200; i++) {
+            addresses.push_back(random_address());
+        }
+        std::vector<int> returns(addresses.size());
+        lpm.get_batch(addresses.data(), returns.data(), addresses.size());
+        for (std::size_t i = 0; i < addresses.size(); i++) {
+            const int expected = longest_match(addresses[i]);
+            TEST(lpm.get(addresses[i]) == expected);
+            TEST(returns[i] == expected);
+        }
+    }
+
+    for (const auto &[prefix, value] : reference) {
+        lpm.remove(prefix.first, prefix.second);
+    }
+    TEST(lpm.size() == 0);
+    TEST(lpm.node_count() == 0);
+}
+END_TEST
+
+START_TEST(InvalidLengthsThrow) {
+    Ipv4Lpm<int> lpm(none);
+    for (int len : {-1, 33}) {
+        bool thrown = false;
+        try {
+            lpm.insert(0, len, 0);
+        } catch (const std::runtime_error &) {
+            thrown = true;
+        }
+        TEST(thrown);
+    }
+}
+END_TEST
+
+END_SUITE
@@ -0,0 +1,55 @@
+#include "marked_array.h"
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "benchmarking.h"
+
+using ostp::libcc::data_structures::MarkedArray;
+using ostp::libcc::utils::do_not_optimize;
+
+const int default_return = 0;  // Default value returned for uninitialized positions.
+const int size = 1 << 20;      // Size of the arrays.
+const int index_count = 4096;  // Number of random indices cycled through.
+
+START_BENCH_SUITE(MarkedArray)
+
+std::mt19937 rng(1);
+std::uniform_int_distribution<int> distribution(0, size - 1);
+std::vector<int> indices(index_count);
+for (int &index : indices) {
+    index = distribution(rng);
+}
+
+MarkedArray<int> half_full(size, default_return);
+for (int i = 0; i < size; i += 2) {
+    half_full.insert(i, i);
+}
+
+START_BENCH(Construct) {
+    BENCH_LOOP {
+        MarkedArray<int> array(size, default_return);
+        do_not_optimize(array);
+    }
+}
+END_BENCH
+
+START_BENCH(InsertRandom) {
+    MarkedArray<int> array(size, default_return);
+    BENCH_LOOP { array.insert(indices[_iteration % index_count], static_cast<int>(_iteration)); }
+    do_not_optimize(array);
+}
+END_BENCH
+
+START_BENCH(GetRandom) {
+    BENCH_LOOP { do_not_optimize(half_full.get(indices[_iteration % index_count])); }
+}
+END_BENCH
+
+START_BENCH(IsInitializedSequential) {
+    BENCH_LOOP { do_not_optimize(half_full.is_initialzed(static_cast<int>(_iteration % size))); }
+}
+END_BENCH
+
+END_BENCH_SUITE
@@ -1,9 +1,11 @@
 #ifndef MARKED_ARRAY_H
 #define MARKED_ARRAY_H
 
+#include <stdexcept>
 #include <vector>
 
 #include "marked_array_entry.h"
+#include "metrics.h"
 
 namespace ostp::libcc::data_structures
 {
@@ -22,11 +24,20 @@ namespace ostp::libcc::data_structures
               _default_return(default_return)
         {
             _initialized_count = 0;
+            if constexpr (utils::metrics_enabled)
+            {
+                metrics().capacity.add(_size);
+            }
         }
 
         /// Destructor.
         ~MarkedArray()
         {
+            if constexpr (utils::metrics_enabled)
+            {
+                metrics().capacity.add(-_size);
+                metrics().initialized.add(-_initialized_count);
+            }
             delete[] _markings;
             delete[] _entries;
         }
@@ -82,6 +93,25 @@ namespace ostp::libcc::data_structures
             return _size;
         }
 
+        /// Returns the index that was initialized with the specified marking, that is the
+        /// mark-th index initialized. Walking every marking lists the initialized indices in
+        /// insertion order without scanning the whole array.
+        ///
+        /// Arguments:
+        ///     mark: marking in [0, initialized_count()).
+        ///
+        /// Returns:
+        ///     the index initialized with the marking.
+        int marked_index(int mark)
+        {
+            // Check validity of the marking.
+            if (mark < 0 || mark >= _initialized_count)
+            {
+                throw std::runtime_error("Marking out of bounds");
+            }
+            return _markings[mark];
+        }
+
         /// Returns the value stored in the specified position.
         ///
         /// Arguments:
@@ -116,9 +146,29 @@ namespace ostp::libcc::data_structures
             // Create new marking.
             _entries[index] = MarkedArrayEntry<K>{_initialized_count, value};
             _markings[_initialized_count++] = index;
+            if constexpr (utils::metrics_enabled)
+            {
+                metrics().initialized.add(1);
+            }
         }
 
     private:
+        /// Metrics shared by every marked array. Their fill ratio is initialized / capacity.
+        struct Metrics
+        {
+            utils::Gauge &capacity = utils::MetricsRegistry::global().gauge(
+                "libcc_marked_array_capacity", "Elements of every live marked array.");
+            utils::Gauge &initialized = utils::MetricsRegistry::global().gauge(
+                "libcc_marked_array_initialized", "Initialized elements of live marked arrays.");
+        };
+
+        /// Returns the metrics, registering them on first use.
+        static Metrics &metrics()
+        {
+            static Metrics metrics;
+            return metrics;
+        }
+
         const int _size;               // Size of the array.
         const K _default_return;       // Default value returned for uninitialized positions.
         int _initialized_count;        // Number of initialized elements.
@@ -1,4 +1,5 @@
 #include <sstream>
+#include <stdexcept>
 #include <string>
 
 #include "marked_array.h"
@@ -87,4 +88,30 @@ START_TEST(MarkedArray_Get)
 }
 END_TEST
 
+START_TEST(MarkedArray_MarkedIndex)
+{
+    MarkedArray<int> array(size, 0);
+    array.insert(7, insertion_value);
+    array.insert(2, insertion_value);
+    array.insert(7, update_value);
+
+    // Markings list the initialized indices in insertion order.
+    ASSERT(array.initialized_count() == 2);
+    TEST(array.marked_index(0) == 7);
+    TEST(array.marked_index(1) == 2);
+
+    // Markings past the initialized ones are rejected.
+    bool thrown = false;
+    try
+    {
+        array.marked_index(2);
+    }
+    catch (const std::runtime_error &)
+    {
+        thrown = true;
+    }
+    TEST(thrown);
+}
+END_TEST
+
 END_SUITE
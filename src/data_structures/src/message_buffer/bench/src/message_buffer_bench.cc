@@ -0,0 +1,45 @@
+#include "message_buffer.h"
+
+#include <cstdint>
+#include <thread>
+
+#include "benchmarking.h"
+
+using ostp::libcc::data_structures::MessageBuffer;
+using ostp::libcc::utils::do_not_optimize;
+
+const uint64_t stop = UINT64_MAX;  // Message ending the echo thread.
+
+START_BENCH_SUITE(MessageBuffer)
+
+START_BENCH(PushPop) {
+    MessageBuffer<uint64_t> buffer;
+    BENCH_LOOP {
+        uint64_t message = _iteration;
+        (void)buffer.push(std::move(message));
+        do_not_optimize(*buffer.pop());
+    }
+}
+END_BENCH
+
+// One round trip per iteration between two threads through a pair of buffers.
+START_BENCH(PingPong) {
+    MessageBuffer<uint64_t> requests;
+    MessageBuffer<uint64_t> responses;
+    std::thread echo([&]() {
+        for (auto message = requests.pop(); *message != stop; message = requests.pop()) {
+            (void)responses.push(std::move(*message));
+        }
+    });
+    BENCH_LOOP {
+        uint64_t message = _iteration;
+        (void)requests.push(std::move(message));
+        do_not_optimize(*responses.pop());
+    }
+    uint64_t message = stop;
+    (void)requests.push(std::move(message));
+    echo.join();
+}
+END_BENCH
+
+END_BENCH_SUITE
@@ -4,20 +4,24 @@
 #include <inttypes.h>
 
 #include <atomic>
-#include <future>
+#include <chrono>
+#include <cstddef>
+#include <deque>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <queue>
 #include <semaphore>
 #include <string>
 #include <vector>
 
-#include "absl/status/status.h"
+#include "metrics.h"
+#include "status.h"
+#include "status_or.h"
+#include "tracing.h"
 
 using std::atomic_int;
-using std::binary_semaphore;
-using std::future;
-using std::future_status;
+using std::counting_semaphore;
 using std::queue;
 using std::string;
 using std::vector;
@@ -29,12 +33,29 @@ namespace ostp::libcc::data_structures {
 ///
 /// The queue is initially open and can be closed by calling the close() method. Once the queue is
 /// closed, no more messages can be pushed to it.
-template <typename T>
+///
+/// When tracing is compiled in, push() and pop() record spans and the n-th pushed message starts
+/// a flow that ends in the pop() returning it, so traces show how long each message was queued.
+///
+/// The queued messages are stored with the specified allocator, for instance to place them on the
+/// NUMA node of the consumer.
+template <typename T, typename Allocator = std::allocator<T>>
 class MessageBuffer {
    public:
     /// Creates a new MessageBuffer.
     MessageBuffer() : messages(), semaphore(0), waiting_threads(0), closed(false) {}
 
+    /// Creates a new MessageBuffer storing its messages with the specified allocator.
+    ///
+    /// Arguments:
+    ///     allocator: The allocator of the queue storage.
+    explicit MessageBuffer(const Allocator &allocator)
+        : messages(std::deque<T, Allocator>(allocator)), semaphore(0), waiting_threads(0),
+          closed(false) {}
+
+    MessageBuffer(const MessageBuffer &) = delete;
+    MessageBuffer &operator=(const MessageBuffer &) = delete;
+
     /// Pushes a message to the queue.
     ///
     /// Arguments:
@@ -43,20 +64,65 @@ class MessageBuffer {
     /// Returns:
     ///     OK if the message was pushed successfully.
     ///     CLOSED if the queue is closed.
-    absl::Status push(T &&message) {
-        // Check if the queue is closed.
-        if (closed) {
-            return absl::CancelledError("Queue is closed.");
-        }
+    utils::StatusOr<void> push(T &&message) {
+        utils::Span span("MessageBuffer::push", "message_buffer");
+        {
+            std::lock_guard<std::mutex> lock(mutex);
 
-        // Push the message to the queue and signal the semaphore.
-        messages.push(std::move(message));
+            // Check if the queue is closed.
+            if (closed) {
+                return {utils::Status::CLOSED, "Queue is closed."};
+            }
+
+            // Push the message to the queue, numbering it to link it to its pop.
+            messages.push(std::move(message));
+            span.flow_start(flow_id(pushed_count++));
+        }
+        if constexpr (utils::metrics_enabled) {
+            metrics().depth.add(1);
+            metrics().pushed.add();
+        }
 
         // If there are threads waiting, signal one of them.
         semaphore.release();
 
         // Return OK.
-        return absl::OkStatus();
+        return {};
+    }
+
+    /// Pushes a batch of messages to the queue under a single lock.
+    ///
+    /// Arguments:
+    ///     batch: The messages to push, in order. It is left empty if they were pushed.
+    ///
+    /// Returns:
+    ///     OK if the messages were pushed successfully.
+    ///     CLOSED if the queue is closed, in which case none was pushed.
+    utils::StatusOr<void> push_batch(vector<T> &batch) {
+        utils::Span span("MessageBuffer::push_batch", "message_buffer");
+        const std::ptrdiff_t count = static_cast<std::ptrdiff_t>(batch.size());
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (closed) {
+                return {utils::Status::CLOSED, "Queue is closed."};
+            }
+            for (T &message : batch) {
+                messages.push(std::move(message));
+                span.flow_start(flow_id(pushed_count++));
+            }
+        }
+        batch.clear();
+        if (count == 0) {
+            return {};
+        }
+        if constexpr (utils::metrics_enabled) {
+            metrics().depth.add(count);
+            metrics().pushed.add(count);
+        }
+
+        // Make every message available at once.
+        semaphore.release(count);
+        return {};
     }
 
     /// Pops a message from the queue.
@@ -68,65 +134,104 @@ class MessageBuffer {
     ///     None.
     ///
     /// Returns:
-    ///     OK if the message was popped successfully and the message is returned.
-    ///     CLOSED if the queue is closed and the message is returned.
-    ///     EMPTY if the queue is empty and closed.
-    std::pair<absl::Status, T> pop() {
-        // If the queue is closed and empty, return an empty string.
-        if (closed && messages.empty()) {
-            return {absl::CancelledError("Queue is closed and empty."), nullptr};
+    ///     OK and the message if a message was popped, even if the queue is closed.
+    ///     CLOSED if the queue is closed and empty.
+    utils::StatusOr<T> pop() {
+        utils::Span span("MessageBuffer::pop", "message_buffer");
+
+        // If the queue is closed and empty, return an error. Otherwise register as waiting while
+        // holding the lock so a concurrent close() releases this thread.
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (closed && messages.empty()) {
+                return {utils::Status::CLOSED, "Queue is closed and empty."};
+            }
+            waiting_threads++;
         }
 
         // Wait for a message to be available.
-        waiting_threads++;
-        semaphore.acquire();
+        if constexpr (utils::metrics_enabled) {
+            utils::ScopedTimer timer(metrics().pop_wait_ns);
+            semaphore.acquire();
+        } else {
+            semaphore.acquire();
+        }
+
+        std::unique_lock<std::mutex> lock(mutex);
         waiting_threads--;
 
-        // If the queue was closed while waiting and there are no more messages, return an empty
-        // string.
+        // If the queue was closed while waiting and there are no more messages, return an error.
         if (closed && messages.empty()) {
-            return {absl::CancelledError("Queue is closed and empty."), nullptr};
+            return {utils::Status::CLOSED, "Queue is closed and empty."};
         }
 
         // Pop the message from the queue.
-        auto message = std::move(messages.front());
+        utils::StatusOr<T> message(std::move(messages.front()));
         messages.pop();
+        span.flow_end(flow_id(popped_count++));
+        lock.unlock();
+        if constexpr (utils::metrics_enabled) {
+            metrics().depth.add(-1);
+            metrics().popped.add();
+        }
 
         // Return the message.
-        return {absl::OkStatus(), std::move(message)};
+        return message;
     }
 
     /// Pops a message from the queue with a timeout.
     ///
     /// If the queue is empty but not closed, this method blocks until a message is pushed to the
     /// queue, the queue is closed or the timeout is reached. If the timeout is reached, the method
-    /// closes the queue and returns an empty string.
+    /// closes the queue and returns an error.
     ///
     /// Arguments:
     ///     timeout: The timeout in milliseconds.
     ///
     /// Returns:
-    ///     OK if the message was popped successfully and the message is returned.
+    ///     OK and the message if a message was popped, even if the queue is closed.
     ///     TIMEOUT if the timeout was reached.
-    ///     CLOSED if the queue is closed and the message is returned.
-    ///     EMPTY if the queue is empty and closed.
-    std::pair<absl::Status, T> pop(int timeout) {
-        // Try to pop a message with the pop() method without a timeout.
-        auto future = std::async(
-            std::launch::async,
-            static_cast<std::pair<absl::Status, T> (MessageBuffer::*)()>(&MessageBuffer::pop),
-            this);
-
-        // Wait until the future is ready or the timeout is reached.
-        future_status status = future.wait_for(std::chrono::milliseconds(timeout));
-
-        // Return the result of the future if it is ready or a timeout error.
-        if (status == future_status::ready) {
-            return std::move(future.get());
+    ///     CLOSED if the queue is closed and empty.
+    utils::StatusOr<T> pop(int timeout) {
+        utils::Span span("MessageBuffer::pop", "message_buffer");
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (closed && messages.empty()) {
+                return {utils::Status::CLOSED, "Queue is closed and empty."};
+            }
+            waiting_threads++;
+        }
+
+        // Wait for a message to be available or the timeout.
+        bool acquired;
+        if constexpr (utils::metrics_enabled) {
+            utils::ScopedTimer timer(metrics().pop_wait_ns);
+            acquired = semaphore.try_acquire_for(std::chrono::milliseconds(timeout));
         } else {
+            acquired = semaphore.try_acquire_for(std::chrono::milliseconds(timeout));
+        }
+
+        std::unique_lock<std::mutex> lock(mutex);
+        waiting_threads--;
+        if (!acquired) {
+            lock.unlock();
             close();
-            return {absl::DeadlineExceededError("Timeout reached."), nullptr};
+            return {utils::Status::TIMEOUT, "Timeout reached."};
+        }
+        if (closed && messages.empty()) {
+            return {utils::Status::CLOSED, "Queue is closed and empty."};
+        }
+
+        // Pop the message from the queue.
+        utils::StatusOr<T> message(std::move(messages.front()));
+        messages.pop();
+        span.flow_end(flow_id(popped_count++));
+        lock.unlock();
+        if constexpr (utils::metrics_enabled) {
+            metrics().depth.add(-1);
+            metrics().popped.add();
         }
+        return message;
     }
 
     /// Closes the queue.
@@ -140,11 +245,16 @@ class MessageBuffer {
     ///     None.
     void close() {
         // Mark the queue as closed.
-        closed = true;
+        int waiting;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            closed = true;
+            waiting = waiting_threads;
+        }
 
         // Release all waiting threads.
-        for (int i = 0; i < waiting_threads; i++) {
-            semaphore.release();
+        if (waiting > 0) {
+            semaphore.release(waiting);
         }
     }
 
@@ -160,33 +270,77 @@ class MessageBuffer {
     ///        threads waiting on the queue).
     ///     CLOSED if the queue is closed and the number of messages is returned or minus the number
     //             of threads waiting.
-    std::pair<absl::Status, int> size() const {
+    std::pair<utils::Status, int> size() const {
         // If the message que is not closed return the number of message available or minus
         // the number of thread blocked.
-        return {closed ? absl::CancelledError("Queue is closed.") : absl::OkStatus(),
-                closed ? -waiting_threads : messages.size()};
+        std::lock_guard<std::mutex> lock(mutex);
+        return {closed ? utils::Status::CLOSED : utils::Status::OK,
+                closed ? -waiting_threads : static_cast<int>(messages.size())};
     }
 
     /// Returns whether the queue is closed.
-    bool is_closed() const { return closed; }
+    bool is_closed() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return closed;
+    }
 
     /// Returns whether the queue is empty.
-    bool empty() const { return messages.empty(); }
+    bool empty() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return messages.empty();
+    }
 
    private:
+    /// Metrics shared by every message buffer.
+    struct Metrics {
+        utils::Gauge &depth = utils::MetricsRegistry::global().gauge(
+            "libcc_message_buffer_depth", "Messages queued in every message buffer.");
+        utils::Counter &pushed = utils::MetricsRegistry::global().counter(
+            "libcc_message_buffer_pushed_total", "Messages pushed to message buffers.");
+        utils::Counter &popped = utils::MetricsRegistry::global().counter(
+            "libcc_message_buffer_popped_total", "Messages popped from message buffers.");
+        utils::Histogram &pop_wait_ns = utils::MetricsRegistry::global().histogram(
+            "libcc_message_buffer_pop_wait_ns", "Time pop() waits for a message in nanoseconds.");
+    };
+
+    /// Returns the metrics, registering them on first use.
+    static Metrics &metrics() {
+        static Metrics metrics;
+        return metrics;
+    }
+
+    /// Returns the identifier of the trace flow of the message with the specified number.
+    uint64_t flow_id(uint64_t sequence) const { return (trace_id << 40) | (sequence & FLOW_MASK); }
+
+    /// Mask of the message number in a flow identifier.
+    static constexpr uint64_t FLOW_MASK = (uint64_t{1} << 40) - 1;
+
+    /// Source of the identifiers distinguishing the flows of different buffers.
+    static inline std::atomic<uint64_t> next_trace_id{1};
+
     // Attributes.
 
+    /// Guards the queue, the closed flag and the message numbers.
+    mutable std::mutex mutex;
+
     /// The queue of messages.
-    queue<T> messages;
+    queue<T, std::deque<T, Allocator>> messages;
 
-    /// The semaphore used to synchronize the queue.
-    binary_semaphore semaphore;
+    /// The semaphore counting the messages available to pop.
+    counting_semaphore<> semaphore;
 
     /// The number of threads waiting on the semaphore.
     atomic_int waiting_threads;
 
     /// Whether the queue is closed.
     bool closed;
+
+    /// The numbers of messages pushed and popped, which number the trace flows.
+    uint64_t pushed_count = 0;
+    uint64_t popped_count = 0;
+
+    /// The identifier of the buffer in trace flows.
+    const uint64_t trace_id = utils::tracing_compiled ? next_trace_id.fetch_add(1) : 0;
 };
 
 }  // namespace ostp::libcc::data_structures
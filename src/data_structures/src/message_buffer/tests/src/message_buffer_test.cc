@@ -1,17 +1,24 @@
 #include "message_buffer.h"
 
+#include <unistd.h>
+
+#include <atomic>
 #include <chrono>
+#include <fstream>
 #include <memory>
 #include <sstream>
 #include <string>
 #include <thread>
+#include <vector>
 
-#include "absl/status/status.h"
 #include "logger.h"
+#include "status.h"
 #include "testing.h"
+#include "tracing.h"
 
 using ostp::libcc::data_structures::MessageBuffer;
 using ostp::libcc::utils::log_error;
+using ostp::libcc::utils::Status;
 using std::stringstream;
 using std::thread;
 
@@ -29,7 +36,7 @@ START_TEST(ConstructsEmptyQueue) {
 
     auto [status, size] = queue.size();
     TEST(size == 0);
-    TEST(status == absl::OkStatus());
+    TEST(status == Status::OK);
 }
 END_TEST
 
@@ -38,13 +45,13 @@ START_TEST(PushUnblocksPop) {
 
     // Create a thread to pop.
     auto t1 = thread([&]() {
-        auto [status, res] = queue.pop();
-        TEST(status == absl::OkStatus());
-        TEST(*res == message1);
+        auto res = queue.pop();
+        TEST(res.ok());
+        TEST(**res == message1);
     });
 
     // Push message.
-    TEST(queue.push(std::make_unique<string>(message1)) == absl::OkStatus());
+    TEST(queue.push(std::make_unique<string>(message1)).ok());
     t1.join();
 }
 END_TEST
@@ -54,18 +61,18 @@ START_TEST(MessagesAreDeliveredInOrder) {
 
     // Create a thread to pop.
     auto t1 = thread([&]() {
-        auto [status1, res1] = queue.pop();
-        TEST(status1 == absl::OkStatus());
-        TEST(*res1 == message1);
+        auto res1 = queue.pop();
+        TEST(res1.ok());
+        TEST(**res1 == message1);
 
-        auto [status2, res2] = queue.pop();
-        TEST(status2 == absl::OkStatus());
-        TEST(*res2 == message2);
+        auto res2 = queue.pop();
+        TEST(res2.ok());
+        TEST(**res2 == message2);
     });
 
     // Push message.
-    TEST(queue.push(std::make_unique<string>(message1)) == absl::OkStatus());
-    TEST(queue.push(std::make_unique<string>(message2)) == absl::OkStatus());
+    TEST(queue.push(std::make_unique<string>(message1)).ok());
+    TEST(queue.push(std::make_unique<string>(message2)).ok());
     t1.join();
 }
 END_TEST
@@ -75,22 +82,49 @@ START_TEST(PopWithTimeoutCanUnblockNormally) {
 
     // Create a thread to pop.
     auto t1 = thread([&]() {
-        auto [status, res] = queue.pop(10000000);
-        TEST(status == absl::OkStatus());
-        TEST(*res == message1);
+        auto res = queue.pop(10000000);
+        TEST(res.ok());
+        TEST(**res == message1);
     });
 
     // Push message.
-    TEST(queue.push(std::make_unique<string>(message1)) == absl::OkStatus());
+    TEST(queue.push(std::make_unique<string>(message1)).ok());
     t1.join();
 }
 END_TEST
 
 START_TEST(PopWithTimeoutUnblocksAfterTimeoutWithTimeoutStatus) {
     MessageBuffer<std::unique_ptr<string>> queue;
-    auto [status, res] = queue.pop(10);
-    TEST(status.code() == absl::StatusCode::kDeadlineExceeded);
-    TEST(res == nullptr);
+    auto res = queue.pop(10);
+    TEST(res.status() == Status::TIMEOUT);
+    TEST(res.failed());
+}
+END_TEST
+
+START_TEST(PushBatchDeliversEveryMessageInOrder) {
+    MessageBuffer<int> queue;
+    auto consumer = thread([&]() {
+        for (int i = 0; i < 100; i++) {
+            auto res = queue.pop(10000);
+            ASSERT(res.ok());
+            TEST(*res == i);
+        }
+    });
+
+    // The batch is left empty once pushed.
+    std::vector<int> batch;
+    for (int i = 0; i < 100; i++) {
+        batch.push_back(i);
+    }
+    TEST(queue.push_batch(batch).ok());
+    TEST(batch.empty());
+    consumer.join();
+
+    // A closed queue refuses the whole batch.
+    queue.close();
+    batch = {1, 2};
+    TEST(queue.push_batch(batch).status() == Status::CLOSED);
+    TEST(batch.size() == 2);
 }
 END_TEST
 
@@ -99,9 +133,9 @@ START_TEST(CloseUnblocksPop) {
 
     // Create a thread to pop.
     auto t1 = thread([&]() {
-        auto [status, res] = queue.pop();
-        TEST(status.code() == absl::StatusCode::kCancelled);
-        TEST(res == nullptr);
+        auto res = queue.pop();
+        TEST(res.status() == Status::CLOSED);
+        TEST(res.failed());
     });
 
     // Close the queue.
@@ -112,20 +146,20 @@ END_TEST
 
 START_TEST(MessagesInTheBufferAreRetrievableAfterClose) {
     MessageBuffer<std::unique_ptr<string>> queue;
-    TEST(queue.push(std::make_unique<string>(message1)) == absl::OkStatus());
-    TEST(queue.push(std::make_unique<string>(message2)) == absl::OkStatus());
+    TEST(queue.push(std::make_unique<string>(message1)).ok());
+    TEST(queue.push(std::make_unique<string>(message2)).ok());
 
     // Close the queue.
     queue.close();
 
     // Pop the messages.
-    auto [pop1_status, pop1_res] = queue.pop();
-    TEST(pop1_status == absl::OkStatus());
-    TEST(*pop1_res == message1);
+    auto pop1_res = queue.pop();
+    TEST(pop1_res.ok());
+    TEST(**pop1_res == message1);
 
-    auto [pop2_status, pop2_res] = queue.pop();
-    TEST(pop2_status == absl::OkStatus());
-    TEST(*pop2_res == message2);
+    auto pop2_res = queue.pop();
+    TEST(pop2_res.ok());
+    TEST(**pop2_res == message2);
 
     // The queue should be closed and empty.
     TEST(queue.is_closed());
@@ -136,9 +170,85 @@ START_TEST(MessagesInTheBufferAreRetrievableAfterClose) {
     TEST(size == 0);
 
     // Popping new messages should return an error.
-    TEST(queue.pop().first.code() == absl::StatusCode::kCancelled);
+    TEST(queue.pop().status() == Status::CLOSED);
 }
 END_TEST
 
+START_TEST(ConcurrentProducersAndConsumersDeliverEveryMessage) {
+    MessageBuffer<int> queue;
+    const int producers = 4;
+    const int consumers = 4;
+    const int messages_per_producer = 10000;
+
+    // Producers push disjoint ranges and consumers add up what they pop until the queue closes.
+    std::atomic<long> sum = 0;
+    std::atomic<int> popped = 0;
+    vector<thread> threads;
+    for (int c = 0; c < consumers; c++) {
+        threads.emplace_back([&]() {
+            for (auto message = queue.pop(); message.ok(); message = queue.pop()) {
+                sum += *message;
+                popped++;
+            }
+        });
+    }
+    vector<thread> pushers;
+    for (int p = 0; p < producers; p++) {
+        pushers.emplace_back([&, p]() {
+            for (int i = 0; i < messages_per_producer; i++) {
+                int message = p * messages_per_producer + i;
+                (void)queue.push(std::move(message));
+            }
+        });
+    }
+    for (thread &pusher : pushers) {
+        pusher.join();
+    }
+
+    // Messages left when the queue closes are still popped.
+    queue.close();
+    for (thread &consumer : threads) {
+        consumer.join();
+    }
+
+    const long total = producers * messages_per_producer;
+    TEST(popped == total);
+    TEST(sum == total * (total - 1) / 2);
+}
+END_TEST
+
+START_SERIAL_TEST(TracesLinkPushToPop) {
+    if constexpr (ostp::libcc::utils::tracing_compiled) {
+        MessageBuffer<int> queue;
+        ostp::libcc::utils::clear_trace();
+        ostp::libcc::utils::start_tracing();
+        auto consumer = thread([&]() { TEST(queue.pop().ok()); });
+        TEST(queue.push(1).ok());
+        consumer.join();
+        ostp::libcc::utils::stop_tracing();
+
+        // The trace holds both spans and the two ends of one flow.
+        const string path = "/tmp/message_buffer_test_" + std::to_string(getpid()) + ".json";
+        TEST(ostp::libcc::utils::dump_trace(path).ok());
+        std::ifstream file(path);
+        stringstream contents;
+        contents << file.rdbuf();
+        unlink(path.c_str());
+        const string trace = contents.str();
+        TEST(trace.find("\"MessageBuffer::push\",\"cat\":\"message_buffer\",\"ph\":\"X\"") !=
+             string::npos);
+        TEST(trace.find("\"MessageBuffer::pop\",\"cat\":\"message_buffer\",\"ph\":\"X\"") !=
+             string::npos);
+        const auto start = trace.find("\"ph\":\"s\"");
+        const auto end = trace.find("\"ph\":\"f\"");
+        TEST(start != string::npos && end != string::npos);
+        const auto id_of = [&](std::size_t from) {
+            const auto id = trace.find("\"id\":", from) + 5;
+            return trace.substr(id, trace.find_first_of(",}", id) - id);
+        };
+        TEST(id_of(start) == id_of(end));
+    }
+}
+END_TEST
 
 END_SUITE
@@ -0,0 +1,70 @@
+#include "multicast_buffer.h"
+
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "benchmarking.h"
+#include "message_buffer.h"
+
+using ostp::libcc::data_structures::MessageBuffer;
+using ostp::libcc::data_structures::MulticastBuffer;
+using ostp::libcc::utils::do_not_optimize;
+
+const int consumers = 3;  // Consumers seeing every message.
+
+START_BENCH_SUITE(MulticastBuffer)
+
+// One message per iteration seen by every consumer through one ring.
+START_BENCH(MulticastToThreeConsumers) {
+    MulticastBuffer<uint64_t> buffer(1024);
+    std::vector<std::thread> threads;
+    for (int c = 0; c < consumers; c++) {
+        const int consumer = buffer.add_consumer();
+        threads.emplace_back([&buffer, consumer]() {
+            uint64_t sum = 0;
+            while (buffer.consume(consumer, [&](const uint64_t &m, uint64_t) { sum += m; }).ok()) {
+            }
+            do_not_optimize(sum);
+        });
+    }
+    BENCH_LOOP {
+        (void)buffer.publish_with([&](uint64_t &slot) { slot = _iteration; });
+    }
+    buffer.close();
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+}
+END_BENCH
+
+// The same messages copied into a heap allocation per consumer and pushed to its own buffer.
+START_BENCH(CopyToThreeMessageBuffers) {
+    std::vector<std::unique_ptr<MessageBuffer<std::unique_ptr<uint64_t>>>> buffers;
+    std::vector<std::thread> threads;
+    for (int c = 0; c < consumers; c++) {
+        buffers.push_back(std::make_unique<MessageBuffer<std::unique_ptr<uint64_t>>>());
+        threads.emplace_back([buffer = buffers.back().get()]() {
+            uint64_t sum = 0;
+            for (auto message = buffer->pop(); message.ok(); message = buffer->pop()) {
+                sum += **message;
+            }
+            do_not_optimize(sum);
+        });
+    }
+    BENCH_LOOP {
+        for (auto &buffer : buffers) {
+            (void)buffer->push(std::make_unique<uint64_t>(_iteration));
+        }
+    }
+    for (auto &buffer : buffers) {
+        buffer->close();
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+}
+END_BENCH
+
+END_BENCH_SUITE
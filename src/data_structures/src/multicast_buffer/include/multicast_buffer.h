@@ -0,0 +1,299 @@
+#ifndef LIBCC_DATA_STRUCTURES_MULTICAST_BUFFER_H
+#define LIBCC_DATA_STRUCTURES_MULTICAST_BUFFER_H
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "status.h"
+#include "status_or.h"
+
+namespace ostp::libcc::data_structures {
+
+/// A preallocated ring in which every message is seen by every consumer, after the disruptor.
+///
+/// Producers claim a sequence, build the message in place in its slot and publish it. Each
+/// consumer tracks its own cursor over the same slots and may depend on other consumers, in which
+/// case it only sees a message once they all have released it; a journaler and a replicator can
+/// thus run side by side and gate the business logic. Producers wait for the slowest consumer to
+/// release a slot before reusing it. Nothing is allocated per message and each consumer is
+/// expected to be driven by one thread at a time.
+///
+/// Consumers are added before the first claim. Once closed, no more messages can be claimed and
+/// consumers see the remaining ones before being told the buffer is closed.
+template <typename T>
+class MulticastBuffer {
+   public:
+    /// Creates a buffer with default constructed messages in every slot.
+    ///
+    /// Arguments:
+    ///     capacity: The number of slots, rounded up to a power of two.
+    explicit MulticastBuffer(std::size_t capacity)
+        : mask(std::bit_ceil(std::max<std::size_t>(capacity, 1)) - 1),
+          slots(std::make_unique<T[]>(mask + 1)),
+          published(std::make_unique<std::atomic<uint64_t>[]>(mask + 1)) {
+        for (std::size_t slot = 0; slot <= mask; slot++) {
+            published[slot].store(UNPUBLISHED, std::memory_order_relaxed);
+        }
+    }
+
+    MulticastBuffer(const MulticastBuffer &) = delete;
+    MulticastBuffer &operator=(const MulticastBuffer &) = delete;
+
+    /// Adds a consumer that sees every message after the consumers it depends on.
+    ///
+    /// Arguments:
+    ///     dependencies: The consumers that release each message before this one sees it.
+    ///
+    /// Returns:
+    ///     The identifier of the consumer.
+    ///
+    /// Throws:
+    ///     std::runtime_error if a message was claimed or a dependency does not exist.
+    int add_consumer(const std::vector<int> &dependencies = {}) {
+        if (claimed.load() > 0) {
+            throw std::runtime_error("Consumers must be added before the first claim.");
+        }
+        for (const int dependency : dependencies) {
+            if (dependency < 0 || dependency >= static_cast<int>(consumers.size())) {
+                throw std::runtime_error("Unknown consumer dependency.");
+            }
+        }
+        consumers.push_back(std::make_unique<Consumer>());
+        consumers.back()->dependencies = dependencies;
+        return static_cast<int>(consumers.size()) - 1;
+    }
+
+    /// Claims the next sequence, waiting for every consumer to release its slot.
+    ///
+    /// Returns:
+    ///     OK and the sequence, whose slot must then be built and published.
+    ///     CLOSED if the buffer is closed.
+    utils::StatusOr<uint64_t> claim() {
+        if (closed.load()) {
+            return {utils::Status::CLOSED, "Queue is closed."};
+        }
+        const uint64_t sequence = claimed.fetch_add(1);
+
+        // Wait until the slowest consumer has released the previous message of the slot.
+        if (sequence >= gate.load(std::memory_order_relaxed) + mask + 1) {
+            wait_until([&] {
+                const uint64_t slowest = slowest_cursor();
+                gate.store(slowest, std::memory_order_relaxed);
+                return sequence < slowest + mask + 1;
+            });
+        }
+        return sequence;
+    }
+
+    /// Returns the message in the slot of the specified sequence.
+    ///
+    /// Producers may write it between claim() and publish() and consumers may read it between
+    /// wait_for() returning past it and release().
+    T &at(uint64_t sequence) { return slots[sequence & mask]; }
+    const T &at(uint64_t sequence) const { return slots[sequence & mask]; }
+
+    /// Publishes the message built in the slot of a claimed sequence.
+    ///
+    /// Arguments:
+    ///     sequence: The claimed sequence.
+    void publish(uint64_t sequence) {
+        published[sequence & mask].store(sequence, std::memory_order_release);
+        signal();
+    }
+
+    /// Claims a sequence, builds its message with the specified function and publishes it.
+    ///
+    /// Arguments:
+    ///     build: Callable taking a reference to the message in the slot.
+    ///
+    /// Returns:
+    ///     OK if the message was published.
+    ///     CLOSED if the buffer is closed.
+    template <typename Build>
+    utils::StatusOr<void> publish_with(Build &&build) {
+        utils::StatusOr<uint64_t> sequence = claim();
+        if (!sequence.ok()) {
+            return {sequence.status(), sequence.status_message()};
+        }
+        std::forward<Build>(build)(at(*sequence));
+        publish(*sequence);
+        return {};
+    }
+
+    /// Moves a message into the next slot and publishes it.
+    ///
+    /// Arguments:
+    ///     message: The message to push.
+    ///
+    /// Returns:
+    ///     OK if the message was pushed.
+    ///     CLOSED if the buffer is closed.
+    utils::StatusOr<void> push(T &&message) {
+        return publish_with([&](T &slot) { slot = std::move(message); });
+    }
+
+    /// Waits for the next messages of a consumer.
+    ///
+    /// Arguments:
+    ///     consumer: The identifier of the consumer.
+    ///
+    /// Returns:
+    ///     OK and the end of the sequences available to the consumer, which start at its cursor.
+    ///     CLOSED if the buffer is closed and the consumer saw every message.
+    utils::StatusOr<uint64_t> wait_for(int consumer) {
+        Consumer &self = *consumers[consumer];
+        const uint64_t cursor = self.cursor.load(std::memory_order_relaxed);
+        uint64_t end = cursor;
+        bool drained = false;
+        wait_until([&] {
+            end = available(self, cursor);
+            drained = closed.load() && cursor == claimed.load();
+            return end > cursor || drained;
+        });
+        if (end == cursor) {
+            return {utils::Status::CLOSED, "Queue is closed and empty."};
+        }
+        return end;
+    }
+
+    /// Releases the messages of a consumer before the specified sequence.
+    ///
+    /// Arguments:
+    ///     consumer: The identifier of the consumer.
+    ///     end: The sequence after the last message released.
+    void release(int consumer, uint64_t end) {
+        consumers[consumer]->cursor.store(end, std::memory_order_release);
+        signal();
+    }
+
+    /// Waits for the next messages of a consumer, passes each to a handler and releases them.
+    ///
+    /// Arguments:
+    ///     consumer: The identifier of the consumer.
+    ///     handler: Callable taking each message and its sequence.
+    ///
+    /// Returns:
+    ///     OK if messages were handled.
+    ///     CLOSED if the buffer is closed and the consumer saw every message.
+    template <typename Handler>
+    utils::StatusOr<void> consume(int consumer, Handler &&handler) {
+        utils::StatusOr<uint64_t> end = wait_for(consumer);
+        if (!end.ok()) {
+            return {end.status(), end.status_message()};
+        }
+        for (uint64_t sequence = consumers[consumer]->cursor.load(std::memory_order_relaxed);
+             sequence < *end; sequence++) {
+            handler(std::as_const(slots[sequence & mask]), sequence);
+        }
+        release(consumer, *end);
+        return {};
+    }
+
+    /// Closes the buffer.
+    ///
+    /// If the buffer is already closed, this method does nothing.
+    void close() {
+        closed.store(true);
+        signal();
+    }
+
+    // Getters.
+
+    /// Returns whether the buffer is closed.
+    bool is_closed() const { return closed.load(); }
+
+    /// Returns the number of slots.
+    std::size_t capacity() const { return mask + 1; }
+
+    /// Returns the cursor of a consumer, the number of messages it released.
+    uint64_t cursor(int consumer) const { return consumers[consumer]->cursor.load(); }
+
+   private:
+    /// Sequence of the published array for slots that were never published.
+    static constexpr uint64_t UNPUBLISHED = UINT64_MAX;
+
+    /// Cursor and dependencies of a consumer, alone on its cache line.
+    struct alignas(64) Consumer {
+        std::atomic<uint64_t> cursor{0};
+        std::vector<int> dependencies;
+    };
+
+    /// Returns the end of the sequences from the cursor that are published and released by the
+    /// dependencies of a consumer.
+    uint64_t available(const Consumer &consumer, uint64_t cursor) const {
+        uint64_t limit = claimed.load();
+        for (const int dependency : consumer.dependencies) {
+            limit = std::min(limit, consumers[dependency]->cursor.load(std::memory_order_acquire));
+        }
+        uint64_t end = cursor;
+        while (end < limit && published[end & mask].load(std::memory_order_acquire) == end) {
+            end++;
+        }
+        return end;
+    }
+
+    /// Returns the cursor of the slowest consumer.
+    uint64_t slowest_cursor() const {
+        uint64_t slowest = claimed.load();
+        for (const std::unique_ptr<Consumer> &consumer : consumers) {
+            slowest = std::min(slowest, consumer->cursor.load(std::memory_order_acquire));
+        }
+        return slowest;
+    }
+
+    /// Waits until the condition holds, sleeping between the signals of other threads.
+    template <typename Condition>
+    void wait_until(const Condition &ready) {
+        for (;;) {
+            // Read the generation first so a signal after the check is not missed.
+            const uint32_t seen = generation.load();
+            if (ready()) {
+                return;
+            }
+            generation.wait(seen);
+        }
+    }
+
+    /// Wakes the threads waiting for a publish, a release or the close.
+    void signal() {
+        generation.fetch_add(1);
+        generation.notify_all();
+    }
+
+    // Attributes.
+
+    /// Mask of a sequence giving its slot.
+    const std::size_t mask;
+
+    /// The messages.
+    std::unique_ptr<T[]> slots;
+
+    /// The sequence last published in each slot.
+    std::unique_ptr<std::atomic<uint64_t>[]> published;
+
+    /// The consumers, each with its own cursor.
+    std::vector<std::unique_ptr<Consumer>> consumers;
+
+    /// The number of sequences claimed.
+    alignas(64) std::atomic<uint64_t> claimed{0};
+
+    /// A cursor no consumer is behind, cached by producers.
+    alignas(64) std::atomic<uint64_t> gate{0};
+
+    /// Bumped on every publish, release and close to wake waiting threads.
+    alignas(64) std::atomic<uint32_t> generation{0};
+
+    /// Whether the buffer is closed.
+    std::atomic<bool> closed{false};
+};
+
+}  // namespace ostp::libcc::data_structures
+
+#endif
@@ -0,0 +1,187 @@
+#include "multicast_buffer.h"
+
+#include <atomic>
+#include <cstdint>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "logger.h"
+#include "status.h"
+#include "testing.h"
+
+using ostp::libcc::data_structures::MulticastBuffer;
+using ostp::libcc::utils::log_error;
+using ostp::libcc::utils::Status;
+using std::thread;
+
+START_SUITE(MulticastBuffer_Tests)
+
+START_TEST(RoundsCapacityAndRejectsLateConsumers) {
+    MulticastBuffer<int> buffer(5);
+    TEST(buffer.capacity() == 8);
+
+    // Dependencies must name existing consumers.
+    const int first = buffer.add_consumer();
+    TEST(buffer.add_consumer({first}) == first + 1);
+    bool thrown = false;
+    try {
+        buffer.add_consumer({7});
+    } catch (const std::runtime_error &) {
+        thrown = true;
+    }
+    TEST(thrown);
+
+    // Consumers cannot join once messages are claimed.
+    TEST(buffer.push(1).ok());
+    thrown = false;
+    try {
+        buffer.add_consumer();
+    } catch (const std::runtime_error &) {
+        thrown = true;
+    }
+    TEST(thrown);
+}
+END_TEST
+
+START_TEST(EveryConsumerSeesEveryMessageInOrder) {
+    MulticastBuffer<uint64_t> buffer(4);
+    const int consumers = 3;
+    const uint64_t messages = 1000;
+    for (int c = 0; c < consumers; c++) {
+        buffer.add_consumer();
+    }
+
+    // The ring wraps many times while each consumer reads at its own pace.
+    std::vector<thread> threads;
+    std::vector<uint64_t> counts(consumers, 0);
+    for (int c = 0; c < consumers; c++) {
+        threads.emplace_back([&, c]() {
+            while (buffer
+                       .consume(c,
+                                [&](const uint64_t &message, uint64_t sequence) {
+                                    TEST(message == sequence * 10);
+                                    TEST(sequence == counts[c]);
+                                    counts[c]++;
+                                })
+                       .ok()) {
+            }
+        });
+    }
+    for (uint64_t i = 0; i < messages; i++) {
+        TEST(buffer.publish_with([&](uint64_t &slot) { slot = i * 10; }).ok());
+    }
+    buffer.close();
+    for (thread &t : threads) {
+        t.join();
+    }
+    for (int c = 0; c < consumers; c++) {
+        TEST(counts[c] == messages);
+        TEST(buffer.cursor(c) == messages);
+    }
+}
+END_TEST
+
+START_TEST(ConsumersSeeMessagesAfterTheirDependencies) {
+    MulticastBuffer<int> buffer(8);
+    const int journal = buffer.add_consumer();
+    const int replicate = buffer.add_consumer();
+    const int logic = buffer.add_consumer({journal, replicate});
+    const int messages = 500;
+
+    std::atomic<bool> ordered(true);
+    auto run = [&](int consumer, std::vector<int> dependencies) {
+        return thread([&buffer, &ordered, consumer, dependencies]() {
+            while (buffer
+                       .consume(consumer,
+                                [&](const int &, uint64_t sequence) {
+                                    for (const int dependency : dependencies) {
+                                        if (buffer.cursor(dependency) <= sequence) {
+                                            ordered = false;
+                                        }
+                                    }
+                                })
+                       .ok()) {
+            }
+        });
+    };
+    thread t1 = run(journal, {});
+    thread t2 = run(replicate, {});
+    thread t3 = run(logic, {journal, replicate});
+    for (int i = 0; i < messages; i++) {
+        TEST(buffer.push(int(i)).ok());
+    }
+    buffer.close();
+    t1.join();
+    t2.join();
+    t3.join();
+    TEST(ordered);
+    TEST(buffer.cursor(logic) == messages);
+}
+END_TEST
+
+START_TEST(ConcurrentProducersPublishEverySequence) {
+    MulticastBuffer<int> buffer(16);
+    const int consumer = buffer.add_consumer();
+    const int producers = 4;
+    const int per_producer = 1000;
+
+    std::vector<thread> threads;
+    for (int p = 0; p < producers; p++) {
+        threads.emplace_back([&]() {
+            for (int i = 0; i < per_producer; i++) {
+                TEST(buffer.push(1).ok());
+            }
+        });
+    }
+    long sum = 0;
+    thread reader([&]() {
+        while (buffer.consume(consumer, [&](const int &message, uint64_t) { sum += message; })
+                   .ok()) {
+        }
+    });
+    for (thread &t : threads) {
+        t.join();
+    }
+    buffer.close();
+    reader.join();
+    TEST(sum == producers * per_producer);
+}
+END_TEST
+
+START_TEST(ClaimedMessagesAreBuiltInPlace) {
+    MulticastBuffer<std::vector<int>> buffer(2);
+    const int consumer = buffer.add_consumer();
+
+    // The producer writes into the slot and the consumer reads the same object.
+    auto sequence = buffer.claim();
+    ASSERT(sequence.ok());
+    buffer.at(*sequence).assign({1, 2, 3});
+    const std::vector<int> *slot = &buffer.at(*sequence);
+    buffer.publish(*sequence);
+
+    auto end = buffer.wait_for(consumer);
+    ASSERT(end.ok());
+    TEST(*end == *sequence + 1);
+    TEST(&buffer.at(*sequence) == slot && buffer.at(*sequence).size() == 3);
+    buffer.release(consumer, *end);
+}
+END_TEST
+
+START_TEST(CloseDrainsThenReportsClosed) {
+    MulticastBuffer<int> buffer(4);
+    const int consumer = buffer.add_consumer();
+    TEST(buffer.push(1).ok());
+    buffer.close();
+    TEST(buffer.is_closed());
+
+    // Published messages are still consumed but no more can be claimed.
+    TEST(buffer.push(2).status() == Status::CLOSED);
+    int seen = 0;
+    TEST(buffer.consume(consumer, [&](const int &message, uint64_t) { seen = message; }).ok());
+    TEST(seen == 1);
+    TEST(buffer.wait_for(consumer).status() == Status::CLOSED);
+}
+END_TEST
+
+END_SUITE
@@ -0,0 +1,45 @@
+#include "pipeline.h"
+
+#include <cstdint>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "benchmarking.h"
+
+using ostp::libcc::data_structures::Pipeline;
+using ostp::libcc::data_structures::StageOptions;
+using ostp::libcc::utils::do_not_optimize;
+
+/// Returns the options of a stage pinned to the specified CPU, wrapping around the CPUs present.
+StageOptions on_cpu(unsigned cpu) {
+    StageOptions options;
+    options.cpus = {static_cast<int>(cpu % std::max(std::thread::hardware_concurrency(), 1u))};
+    return options;
+}
+
+/// Runs one message per iteration through three stages, pinned or not.
+void run_pipeline(uint64_t iterations, bool pinned) {
+    Pipeline<uint64_t> pipeline;
+    for (unsigned stage = 0; stage < 3; stage++) {
+        pipeline.add_stage("stage", pinned ? on_cpu(stage) : StageOptions(),
+                           [](uint64_t &&message) { return std::optional(message + 1); });
+    }
+    (void)pipeline.start();
+    for (uint64_t i = 0; i < iterations; i++) {
+        (void)pipeline.push(uint64_t(i));
+    }
+    pipeline.close();
+    pipeline.wait();
+    do_not_optimize(pipeline.stats()[2].processed);
+}
+
+START_BENCH_SUITE(Pipeline)
+
+START_BENCH(ThreeStagesUnpinned) { run_pipeline(_iterations, false); }
+END_BENCH
+
+START_BENCH(ThreeStagesPinned) { run_pipeline(_iterations, true); }
+END_BENCH
+
+END_BENCH_SUITE
@@ -0,0 +1,120 @@
+#ifndef LIBCC_DATA_STRUCTURES_NUMA_ALLOCATOR_H
+#define LIBCC_DATA_STRUCTURES_NUMA_ALLOCATOR_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace ostp::libcc::data_structures {
+
+/// Returns the NUMA node of the specified CPU, or 0 if it cannot be told.
+///
+/// Arguments:
+///     cpu: The index of the CPU.
+int numa_node_of_cpu(int cpu);
+
+/// Returns the number of NUMA nodes with memory, at least 1.
+int numa_node_count();
+
+/// An arena whose memory is placed on one NUMA node.
+///
+/// Memory is mapped in blocks bound to the node with the mbind system call and carved into
+/// power-of-two size classes whose freed chunks are reused, so a container allocating from the
+/// arena keeps its storage on the node. Allocations larger than a block get their own mapping.
+/// Where the node cannot be set, for instance without NUMA support in the kernel, the memory is
+/// used wherever the kernel places it.
+class NumaArena {
+   public:
+    /// Creates an arena placing its memory on the specified node.
+    ///
+    /// Arguments:
+    ///     node: The NUMA node of the memory, or -1 to leave its placement to the kernel.
+    explicit NumaArena(int node) : _node(node) {}
+
+    NumaArena(const NumaArena &) = delete;
+    NumaArena &operator=(const NumaArena &) = delete;
+
+    /// Unmaps every block. Memory still allocated from the arena becomes invalid.
+    ~NumaArena();
+
+    /// Allocates memory of the specified size aligned to at most 64 bytes.
+    ///
+    /// Throws:
+    ///     std::bad_alloc if the memory cannot be mapped.
+    void *allocate(std::size_t size);
+
+    /// Returns memory allocated with the specified size to the arena.
+    void deallocate(void *memory, std::size_t size);
+
+    /// Returns the NUMA node of the memory.
+    int node() const { return _node; }
+
+    /// Returns whether the memory of the arena could be bound to its node.
+    bool bound() const { return _bound.load(); }
+
+    /// Size of the blocks mapped by the arena.
+    static constexpr std::size_t BLOCK_SIZE = std::size_t{1} << 20;
+
+   private:
+    /// Smallest size class, 2^MIN_CLASS bytes.
+    static constexpr std::size_t MIN_CLASS = 4;
+
+    /// Number of size classes up to the block size.
+    static constexpr std::size_t CLASSES = 21 - MIN_CLASS;
+
+    /// Maps memory of the specified size on the node.
+    void *map(std::size_t size);
+
+    const int _node;                                      // NUMA node of the memory.
+    std::atomic<bool> _bound{true};                       // Whether every mapping was bound.
+    std::mutex mutex;                                     // Guards the blocks and free lists.
+    std::vector<void *> blocks;                           // Mapped blocks.
+    std::byte *cursor = nullptr;                          // Next free byte of the last block.
+    std::byte *block_end = nullptr;                       // End of the last block.
+    std::array<std::vector<void *>, CLASSES> free_lists;  // Freed chunks of each size class.
+};
+
+/// A standard allocator drawing from a NumaArena shared by its copies.
+template <typename T>
+class NumaAllocator {
+   public:
+    using value_type = T;
+
+    /// Creates an allocator drawing from the specified arena.
+    ///
+    /// Arguments:
+    ///     arena: The arena of the memory.
+    explicit NumaAllocator(std::shared_ptr<NumaArena> arena) : arena(std::move(arena)) {}
+
+    // Copied rather than moved so a moved-from allocator can still free what it allocated.
+    NumaAllocator(const NumaAllocator &) = default;
+
+    template <typename U>
+    NumaAllocator(const NumaAllocator<U> &other) : arena(other.arena) {}
+
+    T *allocate(std::size_t count) {
+        static_assert(alignof(T) <= 64, "NumaAllocator aligns to at most 64 bytes");
+        return static_cast<T *>(arena->allocate(count * sizeof(T)));
+    }
+
+    void deallocate(T *memory, std::size_t count) { arena->deallocate(memory, count * sizeof(T)); }
+
+    template <typename U>
+    bool operator==(const NumaAllocator<U> &other) const {
+        return arena == other.arena;
+    }
+
+   private:
+    template <typename U>
+    friend class NumaAllocator;
+
+    std::shared_ptr<NumaArena> arena;  // Arena of the memory.
+};
+
+}  // namespace ostp::libcc::data_structures
+
+#endif
@@ -0,0 +1,262 @@
+#ifndef LIBCC_DATA_STRUCTURES_PIPELINE_H
+#define LIBCC_DATA_STRUCTURES_PIPELINE_H
+
+#include <pthread.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "message_buffer.h"
+#include "numa_allocator.h"
+#include "status.h"
+#include "status_or.h"
+
+namespace ostp::libcc::data_structures {
+
+/// Pins a thread to the specified CPU.
+///
+/// Arguments:
+///     thread: The native handle of the thread.
+///     cpu: The index of the CPU.
+///
+/// Returns:
+///     OK if the thread was pinned.
+///     ERROR if the CPU does not exist or is not allowed.
+utils::StatusOr<void> pin_thread(std::thread::native_handle_type thread, int cpu);
+
+/// How a stage of a Pipeline runs.
+struct StageOptions {
+    /// The number of threads running the stage.
+    int parallelism = 1;
+
+    /// The CPUs the threads are pinned to in turn, or none to leave them unpinned.
+    std::vector<int> cpus;
+};
+
+/// Statistics of a stage of a Pipeline.
+struct StageStats {
+    /// The name of the stage.
+    std::string name;
+
+    /// The number of messages the stage processed.
+    uint64_t processed;
+
+    /// The messages processed per second since the pipeline started.
+    double throughput;
+
+    /// The fraction of the time of its threads the stage spent processing.
+    double utilization;
+
+    /// The number of messages waiting in the input of the stage.
+    int queued;
+
+    /// The NUMA node holding the input of the stage, or -1 if the stage is not pinned.
+    int numa_node;
+};
+
+/// A chain of stages, each run by its own threads and fed by a MessageBuffer.
+///
+/// Each stage processes the messages of its input buffer with a function that returns the message
+/// to pass to the next stage, or nothing to drop it; the results of the last stage are dropped.
+/// The threads of a stage may be pinned to chosen CPUs, and the queue storage of its input buffer
+/// is then allocated on the NUMA node of its first CPU so consumers read local memory; the
+/// storage of unpinned stages is placed by the kernel. Memory the messages point to is placed by
+/// whoever allocates it. On a single node the pipeline behaves the same with local storage
+/// everywhere.
+///
+/// Stages are added before start(). Closing the pipeline lets every stage drain its input before
+/// the next one is closed.
+template <typename T>
+class Pipeline {
+   public:
+    /// Function processing a message of a stage.
+    using StageFunction = std::function<std::optional<T>(T &&)>;
+
+    Pipeline() = default;
+    Pipeline(const Pipeline &) = delete;
+    Pipeline &operator=(const Pipeline &) = delete;
+
+    /// Closes the pipeline and waits for it to drain.
+    ~Pipeline() {
+        close();
+        wait();
+    }
+
+    /// Adds a stage after the previous ones.
+    ///
+    /// Arguments:
+    ///     name: The name of the stage in its statistics.
+    ///     options: The threads of the stage and their CPUs.
+    ///     function: The function processing each message.
+    ///
+    /// Throws:
+    ///     std::runtime_error if the pipeline started or the parallelism is not positive.
+    void add_stage(const std::string &name, const StageOptions &options, StageFunction function) {
+        if (started) {
+            throw std::runtime_error("Stages must be added before the pipeline starts.");
+        }
+        if (options.parallelism < 1) {
+            throw std::runtime_error("A stage needs at least one thread.");
+        }
+        const int node = options.cpus.empty() ? -1 : numa_node_of_cpu(options.cpus.front());
+        stages.push_back(std::make_unique<Stage>(name, options, std::move(function), node));
+    }
+
+    /// Starts the threads of every stage, each pinned to its CPU before it takes a message.
+    ///
+    /// Returns:
+    ///     OK if every thread was pinned as requested.
+    ///     ERROR if a thread could not be pinned, in which case it runs unpinned.
+    ///
+    /// Throws:
+    ///     std::runtime_error if the pipeline has no stages or already started.
+    utils::StatusOr<void> start() {
+        if (stages.empty() || started) {
+            throw std::runtime_error("The pipeline has no stages or already started.");
+        }
+        started = true;
+        start_time = std::chrono::steady_clock::now();
+
+        // Each thread pins itself before it pops a message or touches memory, and reports
+        // whether that worked.
+        std::vector<std::future<bool>> pins;
+        for (std::size_t s = 0; s < stages.size(); s++) {
+            Stage &stage = *stages[s];
+            Stage *next = s + 1 < stages.size() ? stages[s + 1].get() : nullptr;
+            stage.running = stage.options.parallelism;
+            for (int t = 0; t < stage.options.parallelism; t++) {
+                const int cpu = stage.options.cpus.empty()
+                                    ? -1
+                                    : stage.options.cpus[t % stage.options.cpus.size()];
+                std::promise<bool> pin;
+                pins.push_back(pin.get_future());
+                stage.threads.emplace_back([&stage, next, cpu, pin = std::move(pin)]() mutable {
+                    pin.set_value(cpu < 0 || pin_thread(pthread_self(), cpu).ok());
+                    run(stage, next);
+                });
+            }
+        }
+        bool pinned = true;
+        for (std::future<bool> &pin : pins) {
+            pinned = pin.get() && pinned;
+        }
+        if (!pinned) {
+            return {utils::Status::ERROR, "Cannot pin every stage thread."};
+        }
+        return {};
+    }
+
+    /// Pushes a message to the first stage.
+    ///
+    /// Arguments:
+    ///     message: The message to push.
+    ///
+    /// Returns:
+    ///     OK if the message was pushed.
+    ///     CLOSED if the pipeline is closed.
+    utils::StatusOr<void> push(T &&message) {
+        if (stages.empty()) {
+            return {utils::Status::CLOSED, "Queue is closed."};
+        }
+        return stages.front()->input.push(std::move(message));
+    }
+
+    /// Closes the pipeline. Each stage closes the next once it processed its input.
+    void close() {
+        if (!stages.empty()) {
+            stages.front()->input.close();
+        }
+    }
+
+    /// Waits for the threads of every stage to finish.
+    void wait() {
+        for (const std::unique_ptr<Stage> &stage : stages) {
+            for (std::thread &thread : stage->threads) {
+                if (thread.joinable()) {
+                    thread.join();
+                }
+            }
+        }
+    }
+
+    /// Returns the statistics of every stage in order.
+    std::vector<StageStats> stats() const {
+        const double elapsed_ns =
+            started ? std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() -
+                                                                start_time)
+                          .count()
+                    : 0;
+        std::vector<StageStats> result;
+        for (const std::unique_ptr<Stage> &stage : stages) {
+            const uint64_t processed = stage->processed.load(std::memory_order_relaxed);
+            const uint64_t busy_ns = stage->busy_ns.load(std::memory_order_relaxed);
+            const auto [status, size] = stage->input.size();
+            result.push_back({
+                stage->name,
+                processed,
+                elapsed_ns > 0 ? processed * 1e9 / elapsed_ns : 0,
+                elapsed_ns > 0 ? busy_ns / (elapsed_ns * stage->options.parallelism) : 0,
+                std::max(size, 0),
+                stage->arena->node(),
+            });
+        }
+        return result;
+    }
+
+   private:
+    /// A stage, its input and its threads.
+    struct Stage {
+        Stage(const std::string &name, const StageOptions &options, StageFunction function,
+              int node)
+            : name(name), options(options), function(std::move(function)),
+              arena(std::make_shared<NumaArena>(node)), input(NumaAllocator<T>(arena)) {}
+
+        const std::string name;                    // Name in the statistics.
+        const StageOptions options;                // Threads and their CPUs.
+        const StageFunction function;              // Function processing each message.
+        std::shared_ptr<NumaArena> arena;          // Storage of the input on the stage's node.
+        MessageBuffer<T, NumaAllocator<T>> input;  // Messages to process.
+        std::vector<std::thread> threads;          // Threads running the stage.
+        std::atomic<int> running{0};               // Threads still processing.
+        std::atomic<uint64_t> processed{0};        // Messages processed.
+        std::atomic<uint64_t> busy_ns{0};          // Time spent processing.
+    };
+
+    /// Processes the input of a stage until it is closed and empty, then closes the next input
+    /// once every thread of the stage is done.
+    static void run(Stage &stage, Stage *next) {
+        for (auto message = stage.input.pop(); message.ok(); message = stage.input.pop()) {
+            const auto begin = std::chrono::steady_clock::now();
+            std::optional<T> result = stage.function(std::move(*message));
+            const auto end = std::chrono::steady_clock::now();
+            stage.busy_ns.fetch_add(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count(),
+                std::memory_order_relaxed);
+            stage.processed.fetch_add(1, std::memory_order_relaxed);
+            if (result && next != nullptr) {
+                (void)next->input.push(std::move(*result));
+            }
+        }
+        if (stage.running.fetch_sub(1) == 1 && next != nullptr) {
+            next->input.close();
+        }
+    }
+
+    std::vector<std::unique_ptr<Stage>> stages;        // Stages in order.
+    bool started = false;                              // Whether start() was called.
+    std::chrono::steady_clock::time_point start_time;  // When the pipeline started.
+};
+
+}  // namespace ostp::libcc::data_structures
+
+#endif
@@ -0,0 +1,125 @@
+#include "numa_allocator.h"
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+namespace ostp::libcc::data_structures {
+
+// See numa_allocator.h for documentation.
+
+namespace {
+
+/// Policy of mbind preferring a node without failing when it is full, from <numaif.h>.
+constexpr int MPOL_PREFERRED = 1;
+
+/// Returns the size class of an allocation.
+std::size_t size_class(std::size_t size, std::size_t min_class) {
+    return std::max<std::size_t>(std::bit_width(std::max<std::size_t>(size, 1) - 1), min_class) -
+           min_class;
+}
+
+}  // namespace
+
+int numa_node_of_cpu(int cpu) {
+    // The directory of a CPU links to its node as nodeN.
+    std::error_code error;
+    const std::filesystem::path path = "/sys/devices/system/cpu/cpu" + std::to_string(cpu);
+    for (const auto &entry : std::filesystem::directory_iterator(path, error)) {
+        const std::string name = entry.path().filename().string();
+        if (name.size() > 4 && name.starts_with("node") &&
+            name.find_first_not_of("0123456789", 4) == std::string::npos) {
+            return std::stoi(name.substr(4));
+        }
+    }
+    return 0;
+}
+
+int numa_node_count() {
+    std::error_code error;
+    int count = 0;
+    for (const auto &entry :
+         std::filesystem::directory_iterator("/sys/devices/system/node", error)) {
+        const std::string name = entry.path().filename().string();
+        if (name.size() > 4 && name.starts_with("node") &&
+            name.find_first_not_of("0123456789", 4) == std::string::npos) {
+            count++;
+        }
+    }
+    return std::max(count, 1);
+}
+
+NumaArena::~NumaArena() {
+    for (void *block : blocks) {
+        munmap(block, BLOCK_SIZE);
+    }
+}
+
+void *NumaArena::allocate(std::size_t size) {
+    const std::size_t chunk_class = size_class(size, MIN_CLASS);
+    if (chunk_class >= CLASSES) {
+        return map(size);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<void *> &free_list = free_lists[chunk_class];
+    if (!free_list.empty()) {
+        void *chunk = free_list.back();
+        free_list.pop_back();
+        return chunk;
+    }
+
+    // Carve the chunk from the last block, aligned to its size up to a cache line.
+    const std::size_t chunk_size = std::size_t{1} << (chunk_class + MIN_CLASS);
+    const std::size_t alignment = std::min<std::size_t>(chunk_size, 64);
+    std::byte *chunk = cursor == nullptr
+                           ? nullptr
+                           : reinterpret_cast<std::byte *>(
+                                 (reinterpret_cast<uintptr_t>(cursor) + alignment - 1) &
+                                 ~(alignment - 1));
+    if (chunk == nullptr || chunk + chunk_size > block_end) {
+        chunk = static_cast<std::byte *>(map(BLOCK_SIZE));
+        blocks.push_back(chunk);
+        block_end = chunk + BLOCK_SIZE;
+    }
+    cursor = chunk + chunk_size;
+    return chunk;
+}
+
+void NumaArena::deallocate(void *memory, std::size_t size) {
+    const std::size_t chunk_class = size_class(size, MIN_CLASS);
+    if (chunk_class >= CLASSES) {
+        munmap(memory, size);
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    free_lists[chunk_class].push_back(memory);
+}
+
+void *NumaArena::map(std::size_t size) {
+    void *memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) {
+        throw std::bad_alloc();
+    }
+
+    // Bind before the first touch so the pages are faulted in on the node.
+    unsigned long mask[4] = {};
+    const std::size_t bits = sizeof(mask) * 8;
+    if (_node >= 0 && static_cast<std::size_t>(_node) < bits) {
+        mask[_node / (sizeof(unsigned long) * 8)] |= 1UL << (_node % (sizeof(unsigned long) * 8));
+        if (syscall(SYS_mbind, memory, size, MPOL_PREFERRED, mask, bits + 1, 0) != 0) {
+            _bound = false;
+        }
+    } else {
+        _bound = false;
+    }
+    return memory;
+}
+
+}  // namespace ostp::libcc::data_structures
@@ -0,0 +1,23 @@
+#include "pipeline.h"
+
+#include <pthread.h>
+#include <sched.h>
+
+namespace ostp::libcc::data_structures {
+
+// See pipeline.h for documentation.
+
+utils::StatusOr<void> pin_thread(std::thread::native_handle_type thread, int cpu) {
+    if (cpu < 0 || cpu >= CPU_SETSIZE) {
+        return {utils::Status::ERROR, "Invalid CPU."};
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    if (pthread_setaffinity_np(thread, sizeof(set), &set) != 0) {
+        return {utils::Status::ERROR, "Cannot pin the thread to the CPU."};
+    }
+    return {};
+}
+
+}  // namespace ostp::libcc::data_structures
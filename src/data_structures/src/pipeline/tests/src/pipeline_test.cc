@@ -0,0 +1,189 @@
+#include "pipeline.h"
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <atomic>
+#include <deque>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "logger.h"
+#include "message_buffer.h"
+#include "numa_allocator.h"
+#include "status.h"
+#include "testing.h"
+
+using ostp::libcc::data_structures::MessageBuffer;
+using ostp::libcc::data_structures::numa_node_count;
+using ostp::libcc::data_structures::numa_node_of_cpu;
+using ostp::libcc::data_structures::NumaAllocator;
+using ostp::libcc::data_structures::NumaArena;
+using ostp::libcc::data_structures::Pipeline;
+using ostp::libcc::data_structures::StageOptions;
+using ostp::libcc::data_structures::StageStats;
+using ostp::libcc::utils::log_error;
+using ostp::libcc::utils::Status;
+
+/// Returns the first CPU the calling thread may run on.
+int allowed_cpu() {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+            if (CPU_ISSET(cpu, &set)) {
+                return cpu;
+            }
+        }
+    }
+    return sched_getcpu();
+}
+
+START_SUITE(Pipeline_Tests)
+
+START_TEST(ArenaReusesFreedChunks) {
+    NumaArena arena(0);
+    TEST(numa_node_count() >= 1);
+    TEST(numa_node_of_cpu(0) >= 0);
+
+    // Freed chunks of a size class are handed out again.
+    void *first = arena.allocate(100);
+    void *second = arena.allocate(100);
+    TEST(first != second);
+    TEST(reinterpret_cast<uintptr_t>(first) % 64 == 0);
+    arena.deallocate(first, 100);
+    TEST(arena.allocate(120) == first);
+
+    // Allocations larger than a block get their own mapping.
+    void *large = arena.allocate(NumaArena::BLOCK_SIZE * 2);
+    static_cast<char *>(large)[NumaArena::BLOCK_SIZE * 2 - 1] = 1;
+    arena.deallocate(large, NumaArena::BLOCK_SIZE * 2);
+}
+END_TEST
+
+START_TEST(MessageBufferStoresMessagesInTheArena) {
+    auto arena = std::make_shared<NumaArena>(0);
+    MessageBuffer<std::string, NumaAllocator<std::string>> buffer{
+        NumaAllocator<std::string>(arena)};
+    for (int i = 0; i < 1000; i++) {
+        TEST(buffer.push(std::to_string(i)).ok());
+    }
+    for (int i = 0; i < 1000; i++) {
+        auto message = buffer.pop();
+        ASSERT(message.ok());
+        TEST(*message == std::to_string(i));
+    }
+}
+END_TEST
+
+START_TEST(StagesProcessEveryMessageInOrder) {
+    std::vector<int> results;
+    {
+        Pipeline<int> pipeline;
+        pipeline.add_stage("double", {}, [](int &&message) { return std::optional(message * 2); });
+        pipeline.add_stage("drop_odd_tens", {}, [](int &&message) {
+            return (message / 10) % 2 == 1 ? std::nullopt : std::optional(message);
+        });
+        pipeline.add_stage("collect", {}, [&](int &&message) {
+            results.push_back(message);
+            return std::optional(message);
+        });
+        TEST(pipeline.start().ok());
+        for (int i = 0; i < 1000; i++) {
+            TEST(pipeline.push(int(i)).ok());
+        }
+        pipeline.close();
+        pipeline.wait();
+
+        // Each stage counts what it processed, including dropped messages.
+        const std::vector<StageStats> stats = pipeline.stats();
+        ASSERT(stats.size() == 3);
+        TEST(stats[0].name == "double" && stats[0].processed == 1000);
+        TEST(stats[1].processed == 1000);
+        TEST(stats[2].processed == results.size());
+        TEST(stats[2].queued == 0);
+        TEST(pipeline.push(1).status() == Status::CLOSED);
+    }
+
+    ASSERT(results.size() == 500);
+    for (std::size_t i = 1; i < results.size(); i++) {
+        TEST(results[i] > results[i - 1]);
+    }
+}
+END_TEST
+
+START_TEST(ParallelStagesOnPinnedThreads) {
+    std::atomic<long> sum(0);
+    std::atomic<bool> on_cpu(true);
+    const int cpu = allowed_cpu();
+    Pipeline<int> pipeline;
+    StageOptions pinned;
+    pinned.parallelism = 3;
+    pinned.cpus = {cpu};
+    pipeline.add_stage("square", pinned, [&](int &&message) {
+        if (sched_getcpu() != cpu) {
+            on_cpu = false;
+        }
+        return std::optional(message * message);
+    });
+    pipeline.add_stage("sum", {.parallelism = 2, .cpus = {}}, [&](int &&message) {
+        sum += message;
+        return std::optional(message);
+    });
+    TEST(pipeline.start().ok());
+    for (int i = 0; i < 100; i++) {
+        TEST(pipeline.push(int(i)).ok());
+    }
+    pipeline.close();
+    pipeline.wait();
+    TEST(sum == 328350);
+    TEST(on_cpu);
+    TEST(pipeline.stats()[0].numa_node == numa_node_of_cpu(cpu));
+
+    // The input of an unpinned stage is left for the kernel to place.
+    TEST(pipeline.stats()[1].numa_node == -1);
+}
+END_TEST
+
+START_TEST(UnpinnableThreadsStillRun) {
+    int processed = 0;
+    Pipeline<int> pipeline;
+    pipeline.add_stage("count", {.parallelism = 1, .cpus = {CPU_SETSIZE - 1}}, [&](int &&message) {
+        processed++;
+        return std::optional(message);
+    });
+    TEST(pipeline.start().status() == Status::ERROR);
+    TEST(pipeline.push(1).ok());
+    pipeline.close();
+    pipeline.wait();
+    TEST(processed == 1);
+}
+END_TEST
+
+START_TEST(StagesCannotChangeOnceStarted) {
+    Pipeline<int> pipeline;
+    bool thrown = false;
+    try {
+        pipeline.add_stage("none", {.parallelism = 0, .cpus = {}}, [](int &&message) {
+            return std::optional(message);
+        });
+    } catch (const std::runtime_error &) {
+        thrown = true;
+    }
+    TEST(thrown);
+
+    pipeline.add_stage("echo", {}, [](int &&message) { return std::optional(message); });
+    TEST(pipeline.start().ok());
+    thrown = false;
+    try {
+        pipeline.add_stage("late", {}, [](int &&message) { return std::optional(message); });
+    } catch (const std::runtime_error &) {
+        thrown = true;
+    }
+    TEST(thrown);
+}
+END_TEST
+
+END_SUITE
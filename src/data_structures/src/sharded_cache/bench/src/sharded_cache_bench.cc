@@ -0,0 +1,106 @@
+#include "sharded_cache.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "benchmarking.h"
+#include "status_or.h"
+
+using ostp::libcc::data_structures::ShardedCache;
+using ostp::libcc::utils::do_not_optimize;
+using ostp::libcc::utils::StatusOr;
+
+const int key_count = 1 << 20;      // Distinct keys of the workload.
+const int cache_capacity = 1 << 16;  // Entries of the bounded cache.
+const int sample_count = 1 << 16;    // Keys drawn per thread and cycled through.
+const unsigned max_threads = 4;      // Most threads looking up at once.
+
+/// Draws keys following a Zipfian distribution of exponent 0.99, the most popular key first.
+std::vector<uint64_t> zipfian_keys(unsigned seed) {
+    std::vector<double> cumulative(key_count);
+    double sum = 0;
+    for (int k = 0; k < key_count; k++) {
+        sum += 1.0 / std::pow(k + 1, 0.99);
+        cumulative[k] = sum;
+    }
+    std::mt19937_64 rng(seed);
+    std::uniform_real_distribution<double> uniform(0, cumulative.back());
+    std::vector<uint64_t> keys(sample_count);
+    for (uint64_t &key : keys) {
+        key = std::lower_bound(cumulative.begin(), cumulative.end(), uniform(rng)) -
+              cumulative.begin();
+    }
+    return keys;
+}
+
+/// Stands in for the slow store behind the cache.
+StatusOr<uint64_t> fetch(uint64_t key) { return key * 2654435761u; }
+
+/// Zipfian keys of each thread, drawn once before the benchmarks.
+std::vector<std::vector<uint64_t>> thread_keys;
+
+/// Runs the iterations split over threads, each looking up its own Zipfian keys.
+template <typename Lookup>
+void run_threads(uint64_t iterations, unsigned threads, Lookup &&lookup) {
+    const std::vector<std::vector<uint64_t>> &keys = thread_keys;
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < threads; t++) {
+        workers.emplace_back([&, t]() {
+            uint64_t sum = 0;
+            for (uint64_t i = t; i < iterations; i += threads) {
+                sum += lookup(keys[t][i % sample_count]);
+            }
+            do_not_optimize(sum);
+        });
+    }
+    for (std::thread &worker : workers) {
+        worker.join();
+    }
+}
+
+/// Looks up through a bounded sharded cache.
+void sharded(uint64_t iterations, unsigned threads) {
+    ShardedCache<uint64_t, uint64_t> cache(cache_capacity);
+    run_threads(iterations, threads,
+                [&](uint64_t key) { return *cache.get_or_compute(key, fetch); });
+}
+
+/// Looks up through a map behind one mutex that keeps every key.
+void locked_map(uint64_t iterations, unsigned threads) {
+    std::mutex mutex;
+    std::unordered_map<uint64_t, uint64_t> map;
+    run_threads(iterations, threads, [&](uint64_t key) {
+        std::lock_guard<std::mutex> lock(mutex);
+        const auto it = map.find(key);
+        if (it != map.end()) {
+            return it->second;
+        }
+        return map.emplace(key, *fetch(key)).first->second;
+    });
+}
+
+START_BENCH_SUITE(ShardedCache)
+
+for (unsigned t = 0; t < max_threads; t++) {
+    thread_keys.push_back(zipfian_keys(t));
+}
+
+START_BENCH(ZipfianShardedOneThread) { sharded(_iterations, 1); }
+END_BENCH
+
+START_BENCH(ZipfianShardedFourThreads) { sharded(_iterations, max_threads); }
+END_BENCH
+
+START_BENCH(ZipfianLockedMapOneThread) { locked_map(_iterations, 1); }
+END_BENCH
+
+START_BENCH(ZipfianLockedMapFourThreads) { locked_map(_iterations, max_threads); }
+END_BENCH
+
+END_BENCH_SUITE
@@ -0,0 +1,438 @@
+#ifndef LIBCC_DATA_STRUCTURES_SHARDED_CACHE_H
+#define LIBCC_DATA_STRUCTURES_SHARDED_CACHE_H
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "metrics.h"
+#include "status.h"
+#include "status_or.h"
+
+namespace ostp::libcc::data_structures {
+
+namespace sharded_cache_internal {
+
+/// A lock spinning on a flag, for critical sections a few map operations long. Waiters spin on a
+/// plain load so the cache line stays shared until the lock is released, and yield their CPU
+/// after a while in case the holder was preempted.
+class SpinLock {
+   public:
+    void lock() {
+        while (locked.exchange(true, std::memory_order_acquire)) {
+            for (int spins = 0; locked.load(std::memory_order_relaxed); spins++) {
+                if (spins < MAX_SPINS) {
+#if defined(__x86_64__) || defined(__i386__)
+                    __builtin_ia32_pause();
+#endif
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        }
+    }
+
+    bool try_lock() { return !locked.exchange(true, std::memory_order_acquire); }
+
+    void unlock() { locked.store(false, std::memory_order_release); }
+
+   private:
+    /// Spins before yielding, long enough for a critical section on a running holder.
+    static constexpr int MAX_SPINS = 128;
+
+    std::atomic<bool> locked{false};
+};
+
+}  // namespace sharded_cache_internal
+
+/// Counters of a ShardedCache.
+struct CacheStats {
+    /// Lookups that found their key.
+    uint64_t hits;
+
+    /// Lookups that did not find their key.
+    uint64_t misses;
+
+    /// Misses of get_or_compute that waited for the computation of another thread.
+    uint64_t coalesced;
+
+    /// Entries evicted to make room for others.
+    uint64_t evictions;
+
+    /// Entries in the cache.
+    std::size_t size;
+};
+
+/// A bounded key-value cache split into shards, each guarded by its own spinlock.
+///
+/// Keys are spread over the shards by hash, so threads working on different keys rarely contend.
+/// Each shard holds a fixed number of entries and evicts with CLOCK: a hit sets the referenced
+/// bit of its entry, and making room sweeps a hand over the entries, clearing set bits and
+/// evicting the first entry without one. New entries start unreferenced, so keys seen once leave
+/// before the ones hit again.
+///
+/// get_or_compute() fills misses, for instance from the slow store behind a DefaultTrie whose
+/// default_return means "fetch it", and runs a single computation for concurrent misses on the
+/// same key while the other threads wait for its result.
+template <typename K, typename V, typename Hash = std::hash<K>>
+class ShardedCache {
+   public:
+    /// Constructs an empty cache.
+    ///
+    /// Arguments:
+    ///     capacity: The number of entries, rounded up to fill every shard equally.
+    ///     shards: The number of shards, rounded up to a power of two, or 0 for four per
+    ///         hardware thread, at most one per entry.
+    ///
+    /// Throws:
+    ///     std::runtime_error if the capacity is 0.
+    explicit ShardedCache(std::size_t capacity, std::size_t shards = 0) {
+        if (capacity == 0) {
+            throw std::runtime_error("A cache needs a capacity.");
+        }
+        if (shards == 0) {
+            shards = std::min<std::size_t>(
+                capacity, 4 * std::max(std::thread::hardware_concurrency(), 1u));
+        }
+        _shard_count = std::bit_ceil(shards);
+        shard_bits = std::countr_zero(_shard_count);
+        shard_capacity = (capacity + _shard_count - 1) / _shard_count;
+        this->shards = std::make_unique<Shard[]>(_shard_count);
+        for (std::size_t s = 0; s < _shard_count; s++) {
+            this->shards[s].index.reserve(shard_capacity);
+            this->shards[s].slots.reserve(shard_capacity);
+        }
+    }
+
+    ShardedCache(const ShardedCache &) = delete;
+    ShardedCache &operator=(const ShardedCache &) = delete;
+
+    /// Looks up a key.
+    ///
+    /// Arguments:
+    ///     key: The key to look up.
+    ///
+    /// Returns:
+    ///     OK and a copy of the value if the key is cached.
+    ///     EMPTY if the key is not cached.
+    utils::StatusOr<V> get(const K &key) {
+        Shard &shard = shard_of(key);
+        std::lock_guard<sharded_cache_internal::SpinLock> lock(shard.lock);
+        const auto it = shard.index.find(key);
+        if (it == shard.index.end()) {
+            count(shard.misses);
+            if constexpr (utils::metrics_enabled) {
+                metrics().misses.add();
+            }
+            return {utils::Status::EMPTY, "Key is not cached."};
+        }
+        count(shard.hits);
+        if constexpr (utils::metrics_enabled) {
+            metrics().hits.add();
+        }
+        Entry &entry = *shard.slots[it->second];
+        entry.referenced = true;
+        return entry.value;
+    }
+
+    /// Inserts or replaces the value of a key, evicting another entry if the shard is full.
+    ///
+    /// Arguments:
+    ///     key: The key.
+    ///     value: The value.
+    void put(const K &key, V value) {
+        Shard &shard = shard_of(key);
+        std::lock_guard<sharded_cache_internal::SpinLock> lock(shard.lock);
+        store(shard, key, std::move(value));
+    }
+
+    /// Removes a key.
+    ///
+    /// Arguments:
+    ///     key: The key.
+    ///
+    /// Returns:
+    ///     Whether the key was cached.
+    bool erase(const K &key) {
+        Shard &shard = shard_of(key);
+        std::lock_guard<sharded_cache_internal::SpinLock> lock(shard.lock);
+        const auto it = shard.index.find(key);
+        if (it == shard.index.end()) {
+            return false;
+        }
+        shard.slots[it->second].reset();
+        shard.free_slots.push_back(it->second);
+        shard.index.erase(it);
+        return true;
+    }
+
+    /// Looks up a key, computing and caching its value on a miss.
+    ///
+    /// Only one thread computes the value of a missing key; the others missing it meanwhile wait
+    /// for that result. Failed results are passed to the waiting threads but not cached, and an
+    /// exception of the computation is rethrown in every one of them.
+    ///
+    /// Arguments:
+    ///     key: The key to look up.
+    ///     compute: Called without any lock held as compute(key), returning a StatusOr<V>.
+    ///
+    /// Returns:
+    ///     The cached or computed value, or the failure of the computation.
+    template <typename F>
+    utils::StatusOr<V> get_or_compute(const K &key, F &&compute) {
+        Shard &shard = shard_of(key);
+        Computation own;
+        Computation *running = nullptr;
+        {
+            std::lock_guard<sharded_cache_internal::SpinLock> lock(shard.lock);
+            const auto it = shard.index.find(key);
+            if (it != shard.index.end()) {
+                count(shard.hits);
+                if constexpr (utils::metrics_enabled) {
+                    metrics().hits.add();
+                }
+                Entry &entry = *shard.slots[it->second];
+                entry.referenced = true;
+                return entry.value;
+            }
+            count(shard.misses);
+            if constexpr (utils::metrics_enabled) {
+                metrics().misses.add();
+            }
+
+            // Join the thread already computing the key, or announce the computation.
+            for (const auto &[computing_key, computation] : shard.computing) {
+                if (computing_key == key) {
+                    running = computation;
+                    break;
+                }
+            }
+            if (running != nullptr) {
+                count(shard.coalesced);
+                if constexpr (utils::metrics_enabled) {
+                    metrics().coalesced.add();
+                }
+                std::lock_guard<std::mutex> running_lock(running->mutex);
+                running->waiters++;
+            } else {
+                shard.computing.emplace_back(key, &own);
+            }
+        }
+        if (running != nullptr) {
+            return wait_for(*running);
+        }
+
+        std::optional<utils::StatusOr<V>> result;
+        try {
+            result.emplace(std::invoke(compute, key));
+        } catch (...) {
+            own.error = std::current_exception();
+        }
+        {
+            std::lock_guard<sharded_cache_internal::SpinLock> lock(shard.lock);
+            if (result && result->ok()) {
+                store(shard, key, V(**result));
+            }
+            for (std::size_t c = 0; c < shard.computing.size(); c++) {
+                if (shard.computing[c].second == &own) {
+                    shard.computing[c] = std::move(shard.computing.back());
+                    shard.computing.pop_back();
+                    break;
+                }
+            }
+        }
+
+        // Hand the result to the waiting threads, which copy it before this frame goes away.
+        {
+            std::unique_lock<std::mutex> lock(own.mutex);
+            own.result = result ? &*result : nullptr;
+            own.done = true;
+            if (own.waiters > 0) {
+                own.changed.notify_all();
+                own.changed.wait(lock, [&own] { return own.waiters == 0; });
+            }
+        }
+        if (own.error) {
+            std::rethrow_exception(own.error);
+        }
+        return std::move(*result);
+    }
+
+    // Getters.
+
+    /// Returns the counters summed over the shards.
+    CacheStats stats() const {
+        CacheStats stats{0, 0, 0, 0, 0};
+        for (std::size_t s = 0; s < _shard_count; s++) {
+            Shard &shard = shards[s];
+            stats.hits += shard.hits.load(std::memory_order_relaxed);
+            stats.misses += shard.misses.load(std::memory_order_relaxed);
+            stats.coalesced += shard.coalesced.load(std::memory_order_relaxed);
+            stats.evictions += shard.evictions.load(std::memory_order_relaxed);
+            std::lock_guard<sharded_cache_internal::SpinLock> lock(shard.lock);
+            stats.size += shard.index.size();
+        }
+        return stats;
+    }
+
+    /// Returns the number of entries the cache holds at most.
+    std::size_t capacity() const { return _shard_count * shard_capacity; }
+
+    /// Returns the number of shards.
+    std::size_t shard_count() const { return _shard_count; }
+
+   private:
+    /// A computation of get_or_compute(), living on the stack of the thread running it until
+    /// every thread waiting for it copied its result.
+    struct Computation {
+        std::mutex mutex;                            // Guards the rest.
+        std::condition_variable changed;             // Signals done and the last waiter.
+        int waiters = 0;                             // Threads waiting for the result.
+        bool done = false;                           // Whether the computation finished.
+        const utils::StatusOr<V> *result = nullptr;  // Result, unless it threw.
+        std::exception_ptr error;                    // Exception thrown, if any.
+    };
+
+    /// A cached key and its value.
+    struct Entry {
+        K key;
+        V value;
+        bool referenced;  // Whether the entry was hit since the hand last passed it.
+    };
+
+    /// A shard, aligned so the locks of different shards do not share a cache line.
+    struct alignas(64) Shard {
+        mutable sharded_cache_internal::SpinLock lock;       // Guards the shard.
+        std::unordered_map<K, uint32_t, Hash> index;         // Slot of each cached key.
+        std::vector<std::optional<Entry>> slots;             // Entries, empty once erased.
+        std::vector<uint32_t> free_slots;                    // Slots emptied by erase().
+        std::size_t hand = 0;                                // Next slot the clock looks at.
+        std::vector<std::pair<K, Computation *>> computing;  // Computations running.
+        std::atomic<uint64_t> hits{0};                       // Lookups that found their key.
+        std::atomic<uint64_t> misses{0};                     // Lookups that did not.
+        std::atomic<uint64_t> coalesced{0};                  // Misses waiting for another thread.
+        std::atomic<uint64_t> evictions{0};                  // Entries evicted.
+    };
+
+    /// Metrics shared by every sharded cache.
+    struct Metrics {
+        utils::Counter &hits = utils::MetricsRegistry::global().counter(
+            "libcc_sharded_cache_hits_total", "Lookups that found their key in a cache.");
+        utils::Counter &misses = utils::MetricsRegistry::global().counter(
+            "libcc_sharded_cache_misses_total", "Lookups that did not find their key.");
+        utils::Counter &coalesced = utils::MetricsRegistry::global().counter(
+            "libcc_sharded_cache_coalesced_total", "Misses that waited for another computation.");
+        utils::Counter &evictions = utils::MetricsRegistry::global().counter(
+            "libcc_sharded_cache_evictions_total", "Entries evicted from caches.");
+    };
+
+    /// Returns the metrics, registering them on first use.
+    static Metrics &metrics() {
+        static Metrics metrics;
+        return metrics;
+    }
+
+    /// Waits for the computation of another thread and copies its result.
+    static utils::StatusOr<V> wait_for(Computation &computation) {
+        std::unique_lock<std::mutex> lock(computation.mutex);
+        computation.changed.wait(lock, [&computation] { return computation.done; });
+        std::optional<utils::StatusOr<V>> result;
+        if (!computation.error) {
+            result.emplace(*computation.result);
+        }
+        const std::exception_ptr error = computation.error;
+        if (--computation.waiters == 0) {
+            computation.changed.notify_all();
+        }
+        lock.unlock();
+        if (error) {
+            std::rethrow_exception(error);
+        }
+        return std::move(*result);
+    }
+
+    /// Increments a counter of a locked shard, which only the holder of its lock writes.
+    static void count(std::atomic<uint64_t> &counter) {
+        counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    /// Returns the shard of a key, chosen by the high bits of its mixed hash so the low bits the
+    /// maps of the shards use stay spread.
+    Shard &shard_of(const K &key) {
+        if (shard_bits == 0) {
+            return shards[0];
+        }
+        const uint64_t mixed = static_cast<uint64_t>(hash(key)) * 0x9e3779b97f4a7c15ull;
+        return shards[mixed >> (64 - shard_bits)];
+    }
+
+    /// Inserts or replaces the value of a key in a locked shard.
+    void store(Shard &shard, const K &key, V &&value) {
+        const auto it = shard.index.find(key);
+        if (it != shard.index.end()) {
+            Entry &entry = *shard.slots[it->second];
+            entry.value = std::move(value);
+            entry.referenced = true;
+            return;
+        }
+
+        uint32_t slot;
+        if (!shard.free_slots.empty()) {
+            slot = shard.free_slots.back();
+            shard.free_slots.pop_back();
+        } else if (shard.slots.size() < shard_capacity) {
+            slot = static_cast<uint32_t>(shard.slots.size());
+            shard.slots.emplace_back();
+        } else {
+            slot = evict(shard);
+        }
+        shard.slots[slot].emplace(Entry{key, std::move(value), false});
+        shard.index.emplace(key, slot);
+    }
+
+    /// Evicts the first unreferenced entry of a full shard from the hand on.
+    ///
+    /// Returns:
+    ///     The slot of the evicted entry.
+    uint32_t evict(Shard &shard) {
+        while (true) {
+            const uint32_t slot = static_cast<uint32_t>(shard.hand);
+            shard.hand = shard.hand + 1 == shard_capacity ? 0 : shard.hand + 1;
+            Entry &entry = *shard.slots[slot];
+            if (entry.referenced) {
+                entry.referenced = false;
+                continue;
+            }
+            shard.index.erase(entry.key);
+            shard.slots[slot].reset();
+            count(shard.evictions);
+            if constexpr (utils::metrics_enabled) {
+                metrics().evictions.add();
+            }
+            return slot;
+        }
+    }
+
+    std::unique_ptr<Shard[]> shards;  // Shards of the cache.
+    std::size_t _shard_count;         // Number of shards, a power of two.
+    int shard_bits;                   // Log2 of the number of shards.
+    std::size_t shard_capacity;       // Entries of each shard.
+    Hash hash;                        // Hash of the keys.
+};
+
+}  // namespace ostp::libcc::data_structures
+
+#endif
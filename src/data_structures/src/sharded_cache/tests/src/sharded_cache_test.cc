@@ -0,0 +1,152 @@
+#include "sharded_cache.h"
+
+#include <atomic>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "logger.h"
+#include "status.h"
+#include "status_or.h"
+#include "testing.h"
+
+using ostp::libcc::data_structures::CacheStats;
+using ostp::libcc::data_structures::ShardedCache;
+using ostp::libcc::utils::log_error;
+using ostp::libcc::utils::Status;
+using ostp::libcc::utils::StatusOr;
+
+START_SUITE(ShardedCache_Tests)
+
+START_TEST(PutGetAndErase) {
+    ShardedCache<std::string, int> cache(100);
+    TEST(cache.capacity() >= 100);
+    TEST(cache.get("a").status() == Status::EMPTY);
+    cache.put("a", 1);
+    cache.put("b", 2);
+    cache.put("a", 3);
+    TEST(*cache.get("a") == 3);
+    TEST(*cache.get("b") == 2);
+    TEST(cache.erase("a"));
+    TEST(!cache.erase("a"));
+    TEST(cache.get("a").status() == Status::EMPTY);
+
+    const CacheStats stats = cache.stats();
+    TEST(stats.hits == 2);
+    TEST(stats.misses == 2);
+    TEST(stats.size == 1);
+}
+END_TEST
+
+START_TEST(ClockEvictsUnreferencedEntriesFirst) {
+    ShardedCache<int, int> cache(3, 1);
+    cache.put(1, 1);
+    cache.put(2, 2);
+    cache.put(3, 3);
+    TEST(cache.get(1).ok());
+
+    // The hand skips the entry hit since it last passed and evicts the next one.
+    cache.put(4, 4);
+    TEST(cache.get(1).ok());
+    TEST(cache.get(2).status() == Status::EMPTY);
+    TEST(cache.get(3).ok() && cache.get(4).ok());
+    TEST(cache.stats().evictions == 1);
+
+    // Erased slots are reused before evicting.
+    TEST(cache.erase(3));
+    cache.put(5, 5);
+    TEST(cache.stats().evictions == 1);
+    TEST(cache.stats().size == 3);
+}
+END_TEST
+
+START_TEST(SizeStaysWithinCapacity) {
+    ShardedCache<int, int> cache(1000, 8);
+    TEST(cache.shard_count() == 8);
+    for (int i = 0; i < 100000; i++) {
+        cache.put(i, i);
+    }
+    const CacheStats stats = cache.stats();
+    TEST(stats.size <= cache.capacity());
+    TEST(stats.size + stats.evictions == 100000);
+}
+END_TEST
+
+START_TEST(ConcurrentMissesComputeOnce) {
+    ShardedCache<int, std::string> cache(16);
+    const int waiters = 7;
+    std::atomic<int> computations(0);
+    std::atomic<bool> release(false);
+    const auto compute = [&](int key) -> StatusOr<std::string> {
+        computations++;
+        while (!release) {
+            std::this_thread::yield();
+        }
+        return std::to_string(key);
+    };
+
+    std::vector<std::thread> threads;
+    std::atomic<int> correct(0);
+    for (int t = 0; t < waiters + 1; t++) {
+        threads.emplace_back([&]() {
+            auto value = cache.get_or_compute(42, compute);
+            correct += value.ok() && *value == "42";
+        });
+    }
+
+    // Let the computation finish once every other thread waits for it.
+    while (cache.stats().coalesced < waiters) {
+        std::this_thread::yield();
+    }
+    release = true;
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+    TEST(computations == 1);
+    TEST(correct == waiters + 1);
+
+    // The value is then cached.
+    TEST(*cache.get_or_compute(42, compute) == "42");
+    TEST(computations == 1);
+    TEST(cache.stats().hits == 1);
+}
+END_TEST
+
+START_TEST(FailedComputationsAreNotCached) {
+    ShardedCache<int, int> cache(16);
+    int computations = 0;
+    const auto fail = [&](int) -> StatusOr<int> {
+        computations++;
+        return {Status::ERROR, "Store unavailable."};
+    };
+    TEST(cache.get_or_compute(1, fail).status() == Status::ERROR);
+    TEST(cache.get_or_compute(1, fail).status() == Status::ERROR);
+    TEST(computations == 2);
+
+    // A throwing computation leaves nothing behind either.
+    bool thrown = false;
+    try {
+        (void)cache.get_or_compute(1, [](int) -> StatusOr<int> {
+            throw std::runtime_error("Store crashed.");
+        });
+    } catch (const std::runtime_error &) {
+        thrown = true;
+    }
+    TEST(thrown);
+    TEST(*cache.get_or_compute(1, [](int key) -> StatusOr<int> { return key + 1; }) == 2);
+}
+END_TEST
+
+START_TEST(ZeroCapacityIsRejected) {
+    bool thrown = false;
+    try {
+        ShardedCache<int, int> cache(0);
+    } catch (const std::runtime_error &) {
+        thrown = true;
+    }
+    TEST(thrown);
+}
+END_TEST
+
+END_SUITE
@@ -0,0 +1,95 @@
+#include "sharded_trie.h"
+
+#include <cstdint>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "benchmarking.h"
+#include "default_trie.h"
+
+using ostp::libcc::data_structures::DefaultTrie;
+using ostp::libcc::data_structures::ShardedTrie;
+using ostp::libcc::utils::do_not_optimize;
+
+const int no_match = -1;          // Default return of the tries.
+const int word_count = 1 << 16;   // Words inserted by each thread and cycled through.
+const unsigned max_threads = 4;   // Most threads inserting at once.
+
+/// Generates the specified number of random lowercase words of 4 to 16 letters.
+std::vector<std::string> random_words(int count, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> length(4, 16);
+    std::uniform_int_distribution<int> letter('a', 'z');
+    std::vector<std::string> words(count);
+    for (std::string &word : words) {
+        word.resize(length(rng));
+        for (char &c : word) {
+            c = static_cast<char>(letter(rng));
+        }
+    }
+    return words;
+}
+
+/// Words of each thread, drawn once before the benchmarks.
+std::vector<std::vector<std::string>> thread_words;
+
+/// Runs the iterations split over threads, each inserting its own words.
+template <typename Insert>
+void run_threads(uint64_t iterations, unsigned threads, Insert &&insert) {
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < threads; t++) {
+        workers.emplace_back([&, t]() {
+            const std::vector<std::string> &words = thread_words[t];
+            for (uint64_t i = t; i < iterations; i += threads) {
+                const std::string &word = words[(i / threads) % word_count];
+                insert(word, static_cast<int>(i));
+            }
+        });
+    }
+    for (std::thread &worker : workers) {
+        worker.join();
+    }
+}
+
+/// Inserts into a sharded trie.
+void sharded(uint64_t iterations, unsigned threads) {
+    ShardedTrie<char, int> trie(no_match);
+    run_threads(iterations, threads, [&](const std::string &word, int value) {
+        trie.insert(word.data(), word.size(), value);
+    });
+    do_not_optimize(trie.size());
+}
+
+/// Inserts into a single trie behind one mutex.
+void locked(uint64_t iterations, unsigned threads) {
+    std::mutex mutex;
+    DefaultTrie<char, int> trie(no_match);
+    run_threads(iterations, threads, [&](const std::string &word, int value) {
+        std::lock_guard<std::mutex> lock(mutex);
+        trie.insert(word.data(), word.size(), value);
+    });
+    do_not_optimize(trie.size());
+}
+
+START_BENCH_SUITE(ShardedTrie)
+
+for (unsigned t = 0; t < max_threads; t++) {
+    thread_words.push_back(random_words(word_count, t + 1));
+}
+
+START_BENCH(InsertShardedOneThread) { sharded(_iterations, 1); }
+END_BENCH
+
+START_BENCH(InsertShardedFourThreads) { sharded(_iterations, max_threads); }
+END_BENCH
+
+START_BENCH(InsertLockedOneThread) { locked(_iterations, 1); }
+END_BENCH
+
+START_BENCH(InsertLockedFourThreads) { locked(_iterations, max_threads); }
+END_BENCH
+
+END_BENCH_SUITE
@@ -0,0 +1,157 @@
+#ifndef LIBCC_DATA_STRUCTURES_SHARDED_TRIE_H
+#define LIBCC_DATA_STRUCTURES_SHARDED_TRIE_H
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <vector>
+
+#include "default_trie.h"
+
+namespace ostp::libcc::data_structures {
+
+/// A DefaultTrie split into shards that threads can insert into concurrently.
+///
+/// Keys are spread over the shards by their first two symbols, so each shard is a DefaultTrie
+/// holding whole branches below the root, with its own nodes and result slots, behind its own
+/// reader-writer lock. Writers to different shards never wait for each other and readers of a
+/// shard only wait for its writers. The number of entries is kept in one counter, updated by
+/// each insert and remove while it holds its shard, so size() is exact without locking.
+///
+/// The API matches DefaultTrie: lookups are exact matches, returning the default return for
+/// keys the trie does not hold.
+template <class K, class R>
+class ShardedTrie {
+   public:
+    /// Constructs an empty trie.
+    ///
+    /// Arguments:
+    ///     default_return: The default return for no matches.
+    ///     shards: The number of shards, rounded up to a power of two, or 0 for four per
+    ///         hardware thread.
+    explicit ShardedTrie(const R default_return, std::size_t shards = 0) {
+        if (shards == 0) {
+            shards = 4 * std::max(std::thread::hardware_concurrency(), 1u);
+        }
+        _shard_count = std::bit_ceil(shards);
+        shard_bits = std::countr_zero(_shard_count);
+        this->shards.reserve(_shard_count);
+        for (std::size_t s = 0; s < _shard_count; s++) {
+            this->shards.push_back(std::make_unique<Shard>(default_return));
+        }
+    }
+
+    ShardedTrie(const ShardedTrie &) = delete;
+    ShardedTrie &operator=(const ShardedTrie &) = delete;
+
+    /// Inserts the specified entry with the specified return, replacing its return if the trie
+    /// already holds it.
+    ///
+    /// Arguments:
+    ///     entry: The entry to add to the trie.
+    ///     entry_len: The length of the entry.
+    ///     entry_return: The return for the entry.
+    void insert(const K entry[], const int entry_len, const R entry_return) {
+        Shard &shard = shard_of(entry, entry_len);
+        std::unique_lock<std::shared_mutex> lock(shard.lock);
+        const int before = shard.trie.size();
+        shard.trie.insert(entry, entry_len, entry_return);
+        _size.fetch_add(shard.trie.size() - before, std::memory_order_relaxed);
+    }
+
+    /// Removes the specified entry if the trie holds it.
+    ///
+    /// Arguments:
+    ///     entry: The entry to remove from the trie.
+    ///     entry_len: The length of the entry.
+    void remove(const K entry[], const int entry_len) {
+        Shard &shard = shard_of(entry, entry_len);
+        std::unique_lock<std::shared_mutex> lock(shard.lock);
+        const int before = shard.trie.size();
+        shard.trie.remove(entry, entry_len);
+        _size.fetch_add(shard.trie.size() - before, std::memory_order_relaxed);
+    }
+
+    /// Returns the return for the specified entry or the default return if the trie does not
+    /// hold it.
+    ///
+    /// Arguments:
+    ///     entry: The entry to get the return for.
+    ///     entry_len: The length of the entry.
+    R get(const K entry[], const int entry_len) const {
+        const Shard &shard = shard_of(entry, entry_len);
+        std::shared_lock<std::shared_mutex> lock(shard.lock);
+        return shard.trie.get(entry, entry_len);
+    }
+
+    /// Returns whether the trie holds the specified entry.
+    ///
+    /// Arguments:
+    ///     entry: The entry to check for.
+    ///     entry_len: The length of the entry.
+    bool contains(const K entry[], const int entry_len) const {
+        const Shard &shard = shard_of(entry, entry_len);
+        std::shared_lock<std::shared_mutex> lock(shard.lock);
+        return shard.trie.contains(entry, entry_len);
+    }
+
+    /// Updates the default return for no matches, one shard at a time.
+    ///
+    /// Arguments:
+    ///     default_return: The new default return for no matches.
+    void update_default_return(const R default_return) {
+        for (const std::unique_ptr<Shard> &shard : shards) {
+            std::unique_lock<std::shared_mutex> lock(shard->lock);
+            shard->trie.update_default_return(default_return);
+        }
+    }
+
+    // Getters.
+
+    /// Returns the number of entries in the trie.
+    int size() const { return _size.load(std::memory_order_relaxed); }
+
+    /// Returns the number of shards.
+    std::size_t shard_count() const { return _shard_count; }
+
+   private:
+    /// A shard, aligned so the locks of different shards do not share a cache line.
+    struct alignas(64) Shard {
+        explicit Shard(const R default_return) : trie(default_return) {}
+
+        mutable std::shared_mutex lock;  // Guards the trie.
+        DefaultTrie<K, R> trie;          // Entries of the shard.
+    };
+
+    /// Returns the shard of an entry, chosen by the high bits of the mixed hash of its first two
+    /// symbols.
+    Shard &shard_of(const K entry[], const int entry_len) const {
+        if (shard_bits == 0) {
+            return *shards[0];
+        }
+        uint64_t hash = 0;
+        if (entry_len > 0) {
+            hash = std::hash<K>{}(entry[0]) + 1;
+        }
+        if (entry_len > 1) {
+            hash = hash * 0xff51afd7ed558ccdull + std::hash<K>{}(entry[1]);
+        }
+        return *shards[(hash * 0x9e3779b97f4a7c15ull) >> (64 - shard_bits)];
+    }
+
+    std::vector<std::unique_ptr<Shard>> shards;  // Shards of the trie.
+    std::size_t _shard_count;                    // Number of shards, a power of two.
+    int shard_bits;                              // Bits of the shard index.
+    std::atomic<int> _size{0};                   // Number of entries.
+};
+
+}  // namespace ostp::libcc::data_structures
+
+#endif
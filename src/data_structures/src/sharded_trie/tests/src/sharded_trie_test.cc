@@ -0,0 +1,156 @@
+#include "sharded_trie.h"
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "logger.h"
+#include "testing.h"
+
+using ostp::libcc::data_structures::ShardedTrie;
+using ostp::libcc::utils::log_error;
+
+const int no_match = -1;
+const int thread_count = 4;
+const int keys_per_thread = 5000;
+
+/// Returns a key unique to a thread and an index, spelled in lowercase letters.
+std::string key_of(int thread, int index) {
+    std::string key(1, static_cast<char>('a' + thread));
+    for (int rest = index; rest > 0; rest /= 26) {
+        key += static_cast<char>('a' + rest % 26);
+    }
+    return key;
+}
+
+START_SUITE(ShardedTrie_Tests)
+
+START_TEST(ShardedTrie_InsertGetRemove) {
+    ShardedTrie<char, int> trie(no_match, 8);
+    TEST(trie.shard_count() == 8);
+    TEST(trie.get("", 0) == no_match);
+
+    trie.insert("", 0, 0);
+    trie.insert("ab", 2, 1);
+    trie.insert("abc", 3, 2);
+    trie.insert("b", 1, 3);
+    trie.insert("ab", 2, 4);
+    TEST(trie.size() == 4);
+    TEST(trie.get("", 0) == 0);
+    TEST(trie.get("ab", 2) == 4);
+    TEST(trie.get("abc", 3) == 2);
+    TEST(trie.get("a", 1) == no_match);
+    TEST(trie.contains("b", 1) && !trie.contains("bc", 2));
+
+    trie.remove("ab", 2);
+    trie.remove("ab", 2);
+    trie.remove("zz", 2);
+    TEST(trie.size() == 3);
+    TEST(!trie.contains("ab", 2) && trie.get("abc", 3) == 2);
+
+    trie.update_default_return(-2);
+    TEST(trie.get("ab", 2) == -2);
+}
+END_TEST
+
+START_TEST(ShardedTrie_RoundsShardsUp) {
+    ShardedTrie<char, int> one(no_match, 1);
+    TEST(one.shard_count() == 1);
+    one.insert("a", 1, 1);
+    TEST(one.get("a", 1) == 1);
+
+    ShardedTrie<char, int> odd(no_match, 5);
+    TEST(odd.shard_count() == 8);
+    ShardedTrie<char, int> automatic(no_match);
+    TEST(automatic.shard_count() >= 4);
+}
+END_TEST
+
+START_TEST(ShardedTrie_ConcurrentInsertsAreAllKept) {
+    ShardedTrie<char, int> trie(no_match);
+
+    // Each thread inserts its own keys and the same shared ones.
+    std::vector<std::thread> threads;
+    for (int t = 0; t < thread_count; t++) {
+        threads.emplace_back([&trie, t]() {
+            for (int i = 0; i < keys_per_thread; i++) {
+                const std::string key = key_of(t, i);
+                trie.insert(key.data(), key.size(), t * keys_per_thread + i);
+                const std::string shared = key_of(thread_count, i % 100);
+                trie.insert(shared.data(), shared.size(), i % 100);
+            }
+        });
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+
+    TEST(trie.size() == thread_count * keys_per_thread + 100);
+    for (int t = 0; t < thread_count; t++) {
+        for (int i = 0; i < keys_per_thread; i++) {
+            const std::string key = key_of(t, i);
+            TEST(trie.get(key.data(), key.size()) == t * keys_per_thread + i);
+        }
+    }
+}
+END_TEST
+
+START_TEST(ShardedTrie_ReadersRunAlongsideWriters) {
+    ShardedTrie<char, int> trie(no_match);
+    for (int i = 0; i < keys_per_thread; i++) {
+        const std::string key = key_of(0, i);
+        trie.insert(key.data(), key.size(), i);
+    }
+
+    // Writers remove the even keys of the first thread and add keys of their own while
+    // readers check that keys are either absent or hold their return.
+    std::atomic<bool> writing(true);
+    std::atomic<int> wrong(0);
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 2; r++) {
+        readers.emplace_back([&]() {
+            while (writing.load()) {
+                for (int i = 0; i < keys_per_thread; i += 7) {
+                    const std::string key = key_of(0, i);
+                    const int found = trie.get(key.data(), key.size());
+                    if (found != i && found != no_match) {
+                        wrong++;
+                    }
+                }
+            }
+        });
+    }
+    std::vector<std::thread> writers;
+    for (int t = 1; t < thread_count; t++) {
+        writers.emplace_back([&trie, t]() {
+            for (int i = 2 * (t - 1); i < keys_per_thread; i += 2 * (thread_count - 1)) {
+                const std::string key = key_of(0, i);
+                trie.remove(key.data(), key.size());
+            }
+            for (int i = 0; i < keys_per_thread; i++) {
+                const std::string key = key_of(t, i);
+                trie.insert(key.data(), key.size(), i);
+            }
+        });
+    }
+    for (std::thread &writer : writers) {
+        writer.join();
+    }
+    writing = false;
+    for (std::thread &reader : readers) {
+        reader.join();
+    }
+
+    TEST(wrong == 0);
+    int kept = 0;
+    for (int i = 0; i < keys_per_thread; i++) {
+        const std::string key = key_of(0, i);
+        kept += trie.contains(key.data(), key.size());
+    }
+    TEST(kept == keys_per_thread / 2);
+    TEST(trie.size() == kept + (thread_count - 1) * keys_per_thread);
+}
+END_TEST
+
+END_SUITE
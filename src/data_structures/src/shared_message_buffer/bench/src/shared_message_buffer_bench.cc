@@ -0,0 +1,47 @@
+#include "shared_message_buffer.h"
+
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include "benchmarking.h"
+
+using ostp::libcc::data_structures::SharedMessageBuffer;
+using ostp::libcc::utils::do_not_optimize;
+
+const std::size_t message_size = 64;  // Size of the benchmarked messages.
+
+START_BENCH_SUITE(SharedMessageBuffer)
+
+const std::string name = "/libcc_shared_message_buffer_bench_" + std::to_string(getpid());
+auto buffer = SharedMessageBuffer::create(name, 1024, message_size);
+(void)SharedMessageBuffer::unlink(name);
+if (!buffer.ok()) {
+    return 1;
+}
+const std::byte message[message_size] = {};
+
+START_BENCH(PushPop) {
+    BENCH_LOOP {
+        (void)buffer->push(message, message_size);
+        do_not_optimize(*buffer->pop());
+    }
+}
+END_BENCH
+
+START_BENCH(ReservePublishAcquireRelease) {
+    BENCH_LOOP {
+        auto reserved = buffer->reserve(sizeof(uint64_t));
+        std::memcpy(reserved->data(), &_iteration, sizeof(uint64_t));
+        buffer->publish(*reserved);
+
+        auto acquired = buffer->acquire();
+        do_not_optimize(*acquired->data());
+        buffer->release(*acquired);
+    }
+}
+END_BENCH
+
+END_BENCH_SUITE
@@ -0,0 +1,225 @@
+#ifndef LIBCC_DATA_STRUCTURES_SHARED_MESSAGE_BUFFER_H
+#define LIBCC_DATA_STRUCTURES_SHARED_MESSAGE_BUFFER_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "status.h"
+#include "status_or.h"
+
+namespace ostp::libcc::data_structures {
+
+namespace shared_message_buffer_internal {
+
+/// Layout of the shared memory segment, defined in shared_message_buffer.cc.
+struct Segment;
+
+}  // namespace shared_message_buffer_internal
+
+/// A slot of a SharedMessageBuffer claimed by reserve() or acquire().
+///
+/// Its data lives in the shared memory segment, so a producer writes a message in place and a
+/// consumer reads it in place. The slot must be handed back with publish() or release().
+class SharedSlot {
+   public:
+    /// Returns the data of the message.
+    std::byte *data() const { return _data; }
+
+    /// Returns the size of the message in bytes.
+    std::size_t size() const { return _size; }
+
+   private:
+    friend class SharedMessageBuffer;
+
+    SharedSlot(std::byte *data, std::size_t size, uint64_t position)
+        : _data(data), _size(size), position(position) {}
+
+    std::byte *_data;   // Data of the message in the segment.
+    std::size_t _size;  // Size of the message in bytes.
+    uint64_t position;  // Position of the slot in the ring.
+};
+
+/// A message buffer shared between processes through a named POSIX shared memory segment.
+///
+/// The segment holds a bounded ring of fixed-size slots, each holding one message of up to the
+/// slot size, and only positions and offsets, so every process may map it at its own address.
+/// Producers and consumers claim slots with a compare-and-swap on the ring positions and sleep on
+/// futexes in the segment when the ring is full or empty, so a wakeup crosses processes without
+/// any other channel.
+///
+/// push(), pop() and close() behave as in MessageBuffer, except that push() blocks while the
+/// ring is full. Messages cross without copies through reserve() and publish() on the producer
+/// side and acquire() and release() on the consumer side.
+///
+/// Each claimed slot records the process holding it before the ring position moves past it. A
+/// process blocked on a slot that a dead process claimed reclaims it: a claim whose position was
+/// not taken yet passes to the next producer or consumer, a message whose producer died is
+/// skipped and a message whose consumer died is dropped. A dead process is only noticed once it
+/// is reaped.
+class SharedMessageBuffer {
+   public:
+    /// Creates a shared memory segment holding an empty buffer and maps it.
+    ///
+    /// Arguments:
+    ///     name: The name of the segment, starting with a slash.
+    ///     slot_count: The number of slots in the ring, rounded up to a power of two.
+    ///     slot_size: The largest size of a message in bytes.
+    ///
+    /// Returns:
+    ///     OK and the buffer if the segment was created.
+    ///     ERROR if the arguments are invalid or the segment exists or cannot be created.
+    static utils::StatusOr<SharedMessageBuffer> create(const std::string &name,
+                                                       std::size_t slot_count,
+                                                       std::size_t slot_size);
+
+    /// Maps the buffer of an existing shared memory segment.
+    ///
+    /// Arguments:
+    ///     name: The name of the segment.
+    ///
+    /// Returns:
+    ///     OK and the buffer if the segment was mapped.
+    ///     ERROR if the segment does not exist or does not hold a buffer.
+    static utils::StatusOr<SharedMessageBuffer> open(const std::string &name);
+
+    /// Removes the name of a shared memory segment. Mapped buffers stay usable.
+    ///
+    /// Arguments:
+    ///     name: The name of the segment.
+    ///
+    /// Returns:
+    ///     OK if the name was removed.
+    ///     ERROR if there is no segment with that name.
+    static utils::StatusOr<void> unlink(const std::string &name);
+
+    SharedMessageBuffer(SharedMessageBuffer &&other) noexcept;
+    SharedMessageBuffer &operator=(SharedMessageBuffer &&other) noexcept;
+    SharedMessageBuffer(const SharedMessageBuffer &) = delete;
+    SharedMessageBuffer &operator=(const SharedMessageBuffer &) = delete;
+
+    /// Unmaps the segment.
+    ~SharedMessageBuffer();
+
+    /// Copies a message into the buffer.
+    ///
+    /// Blocks while the ring is full.
+    ///
+    /// Arguments:
+    ///     data: The message.
+    ///     size: The size of the message in bytes.
+    ///
+    /// Returns:
+    ///     OK if the message was pushed.
+    ///     CLOSED if the buffer is closed.
+    ///     ERROR if the message is larger than a slot.
+    utils::StatusOr<void> push(const void *data, std::size_t size);
+
+    /// Pops a message from the buffer into a vector.
+    ///
+    /// If the buffer is empty but not closed, this method blocks until a message is pushed or the
+    /// buffer is closed.
+    ///
+    /// Returns:
+    ///     OK and the message if a message was popped, even if the buffer is closed.
+    ///     CLOSED if the buffer is closed and empty.
+    utils::StatusOr<std::vector<std::byte>> pop();
+
+    /// Pops a message from the buffer with a timeout.
+    ///
+    /// As in MessageBuffer, the buffer is closed if the timeout is reached.
+    ///
+    /// Arguments:
+    ///     timeout: The timeout in milliseconds.
+    ///
+    /// Returns:
+    ///     OK and the message if a message was popped, even if the buffer is closed.
+    ///     TIMEOUT if the timeout was reached.
+    ///     CLOSED if the buffer is closed and empty.
+    utils::StatusOr<std::vector<std::byte>> pop(int timeout);
+
+    /// Claims a slot to write a message of the specified size in place.
+    ///
+    /// Blocks while the ring is full. The message is seen by consumers once published.
+    ///
+    /// Arguments:
+    ///     size: The size of the message in bytes.
+    ///
+    /// Returns:
+    ///     OK and the slot if one was claimed.
+    ///     CLOSED if the buffer is closed.
+    ///     ERROR if the message is larger than a slot.
+    utils::StatusOr<SharedSlot> reserve(std::size_t size);
+
+    /// Publishes the message written in a slot claimed by reserve().
+    ///
+    /// Arguments:
+    ///     slot: The slot holding the message.
+    void publish(const SharedSlot &slot);
+
+    /// Claims the slot of the next message to read it in place.
+    ///
+    /// If the buffer is empty but not closed, this method blocks until a message is published or
+    /// the buffer is closed.
+    ///
+    /// Returns:
+    ///     OK and the slot if a message was claimed, even if the buffer is closed.
+    ///     CLOSED if the buffer is closed and empty.
+    utils::StatusOr<SharedSlot> acquire();
+
+    /// Claims the slot of the next message with a timeout. Unlike pop(), the buffer stays open.
+    ///
+    /// Arguments:
+    ///     timeout: The timeout in milliseconds.
+    ///
+    /// Returns:
+    ///     OK and the slot if a message was claimed, even if the buffer is closed.
+    ///     TIMEOUT if the timeout was reached.
+    ///     CLOSED if the buffer is closed and empty.
+    utils::StatusOr<SharedSlot> acquire(int timeout);
+
+    /// Hands back a slot claimed by acquire() once its message is read.
+    ///
+    /// Arguments:
+    ///     slot: The slot of the message.
+    void release(const SharedSlot &slot);
+
+    /// Closes the buffer for every process, waking the blocked ones.
+    ///
+    /// If the buffer is already closed, this method does nothing.
+    void close();
+
+    // Getters.
+
+    /// Returns whether the buffer is closed.
+    bool is_closed() const;
+
+    /// Returns whether no message is published or being written.
+    bool empty() const;
+
+    /// Returns the number of slots in the ring.
+    std::size_t slot_count() const;
+
+    /// Returns the largest size of a message in bytes.
+    std::size_t slot_size() const;
+
+   private:
+    SharedMessageBuffer(shared_message_buffer_internal::Segment *segment, std::size_t mapped_size)
+        : segment(segment), mapped_size(mapped_size) {}
+
+    /// Claims the slot of the next message, waiting until the deadline if there is one.
+    utils::StatusOr<SharedSlot> acquire_until(
+        const std::chrono::steady_clock::time_point *deadline);
+
+    /// Returns the address of the slot at the specified position.
+    std::byte *slot_at(uint64_t position) const;
+
+    shared_message_buffer_internal::Segment *segment;  // Mapped segment.
+    std::size_t mapped_size;                            // Size of the mapping in bytes.
+};
+
+}  // namespace ostp::libcc::data_structures
+
+#endif
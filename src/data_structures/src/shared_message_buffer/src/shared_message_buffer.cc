@@ -0,0 +1,509 @@
+#include "shared_message_buffer.h"
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <linux/futex.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <thread>
+#include <utility>
+
+#include "shared_message_buffer_testing.h"
+
+namespace ostp::libcc::data_structures {
+
+// See shared_message_buffer.h for documentation.
+
+using utils::Status;
+using utils::StatusOr;
+
+namespace shared_message_buffer_internal {
+
+/// Header of the segment, followed by the slots. Every field is a value or an offset, never a
+/// pointer, so it reads the same at any mapping address.
+struct Segment {
+    std::atomic<uint32_t> magic;  // Set last once the segment is initialized.
+    uint32_t version;
+    uint64_t slot_count;
+    uint64_t slot_size;
+    uint64_t slot_stride;
+
+    alignas(64) std::atomic<uint64_t> enqueue_position;  // Next position producers claim.
+    alignas(64) std::atomic<uint64_t> dequeue_position;  // Next position consumers claim.
+
+    alignas(64) std::atomic<uint32_t> published;  // Futex word bumped when messages appear.
+    std::atomic<uint32_t> consumers_waiting;      // Consumers sleeping on published.
+
+    alignas(64) std::atomic<uint32_t> released;  // Futex word bumped when slots are freed.
+    std::atomic<uint32_t> producers_waiting;     // Producers sleeping on released.
+
+    alignas(64) std::atomic<uint32_t> closed;
+};
+
+#ifdef LIBCC_SHARED_MESSAGE_BUFFER_TESTING
+void (*claim_hook)() = nullptr;
+#endif
+
+}  // namespace shared_message_buffer_internal
+
+#ifdef LIBCC_SHARED_MESSAGE_BUFFER_TESTING
+using shared_message_buffer_internal::claim_hook;
+#endif
+using shared_message_buffer_internal::Segment;
+
+namespace {
+
+constexpr uint32_t MAGIC = 0x6c69626d;  // "libm"
+constexpr uint32_t VERSION = 2;
+
+/// How often a blocked process checks whether the process holding its slot died.
+constexpr std::chrono::milliseconds RECOVERY_INTERVAL(50);
+
+/// What is happening to a slot.
+enum SlotState : uint32_t { FREE, WRITING, READY, READING };
+
+/// Size published in a slot given up by a dead producer, which consumers skip.
+constexpr uint64_t NO_MESSAGE = UINT64_MAX;
+
+/// Header of a slot, followed by the message.
+///
+/// As in Vyukov's bounded queue, the sequence of the slot at position p is p when the slot is free
+/// for that position, p + 1 once its message is published and p + slot count once it is read.
+///
+/// A process claims a slot by swapping its identifier into the claim before it moves the ring
+/// position past the slot, and only the holder of the claim moves it. A claim held by a dead
+/// process is therefore taken over if the position still points at the slot, and given up by
+/// the other side of the ring if it does not.
+struct alignas(64) Slot {
+    std::atomic<uint64_t> sequence;
+    std::atomic<uint64_t> claim;  // Process writing or reading the slot and the slot state.
+    std::atomic<uint64_t> size;   // Size of the published message.
+};
+
+/// Returns the claim of a slot by the specified process in the specified state.
+constexpr uint64_t claim_of(int32_t pid, SlotState state) {
+    return uint64_t{static_cast<uint32_t>(pid)} << 32 | state;
+}
+
+/// Returns the process holding a claim.
+constexpr int32_t owner_of(uint64_t claim) { return static_cast<int32_t>(claim >> 32); }
+
+/// Returns the state of a slot from its claim.
+constexpr SlotState state_of(uint64_t claim) { return static_cast<SlotState>(claim & 0xffffffff); }
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free &&
+                  std::atomic<uint64_t>::is_always_lock_free &&
+                  sizeof(std::atomic<uint32_t>) == sizeof(uint32_t),
+              "Shared atomics must be lock free to work across processes");
+
+/// Offset of the first slot from the start of the segment.
+constexpr std::size_t SLOTS_OFFSET = (sizeof(Segment) + 63) / 64 * 64;
+
+/// Returns the size of the segment holding the specified slots.
+std::size_t segment_size(uint64_t slot_count, uint64_t slot_stride) {
+    return SLOTS_OFFSET + slot_count * slot_stride;
+}
+
+/// Sleeps while a futex word holds the specified value, for at most the timeout.
+void futex_wait(std::atomic<uint32_t> &word, uint32_t value, std::chrono::nanoseconds timeout) {
+    const timespec time{static_cast<time_t>(timeout.count() / 1000000000),
+                        static_cast<long>(timeout.count() % 1000000000)};
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word), FUTEX_WAIT, value, &time, nullptr, 0);
+}
+
+/// Wakes up to the specified number of processes sleeping on a futex word.
+void futex_wake(std::atomic<uint32_t> &word, int count) {
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word), FUTEX_WAKE, count, nullptr, nullptr,
+            0);
+}
+
+/// Bumps a futex word and wakes its sleepers if there are any.
+void notify(std::atomic<uint32_t> &word, const std::atomic<uint32_t> &waiters, int count) {
+    word.fetch_add(1);
+    if (waiters.load() > 0) {
+        futex_wake(word, count);
+    }
+}
+
+/// Sleeps on a futex word until the condition may hold or the timeout passes.
+template <class Condition>
+void wait_on(std::atomic<uint32_t> &word, std::atomic<uint32_t> &waiters,
+             const Condition &ready, std::chrono::nanoseconds timeout) {
+    // Read the word before checking so a signal between the check and the sleep is not missed.
+    const uint32_t value = word.load();
+    waiters.fetch_add(1);
+    if (!ready()) {
+        futex_wait(word, value, timeout);
+    }
+    waiters.fetch_sub(1);
+}
+
+/// Identifier of this process, or 0 until read again after a fork.
+std::atomic<int32_t> cached_pid(0);
+
+/// Returns the identifier of this process without the system call of getpid() on every claim.
+int32_t current_pid() {
+    static const bool registered = [] {
+        pthread_atfork(nullptr, nullptr, [] { cached_pid.store(0); });
+        return true;
+    }();
+    (void)registered;
+    int32_t pid = cached_pid.load(std::memory_order_relaxed);
+    if (pid == 0) {
+        pid = static_cast<int32_t>(getpid());
+        cached_pid.store(pid, std::memory_order_relaxed);
+    }
+    return pid;
+}
+
+/// Returns whether the specified process is known to have exited.
+bool process_dead(int32_t pid) { return pid > 0 && kill(pid, 0) == -1 && errno == ESRCH; }
+
+/// Returns the slot at the specified address.
+Slot &slot_header(std::byte *address) { return *reinterpret_cast<Slot *>(address); }
+
+/// Returns the message of the slot at the specified address.
+std::byte *slot_data(std::byte *address) { return address + sizeof(Slot); }
+
+/// Maps a segment and returns its address or nullptr.
+Segment *map_segment(int fd, std::size_t size) {
+    void *address = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    return address == MAP_FAILED ? nullptr : static_cast<Segment *>(address);
+}
+
+}  // namespace
+
+StatusOr<SharedMessageBuffer> SharedMessageBuffer::create(const std::string &name,
+                                                          std::size_t slot_count,
+                                                          std::size_t slot_size) {
+    if (slot_count == 0 || slot_size == 0 || slot_count > (std::size_t{1} << 32)) {
+        return {Status::ERROR, "Invalid slot count or size."};
+    }
+    const uint64_t count = std::bit_ceil(slot_count);
+    const uint64_t stride = sizeof(Slot) + (slot_size + 63) / 64 * 64;
+    const std::size_t size = segment_size(count, stride);
+
+    const int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd == -1) {
+        return {Status::ERROR, "Cannot create the shared memory segment."};
+    }
+    if (ftruncate(fd, static_cast<off_t>(size)) == -1) {
+        ::close(fd);
+        shm_unlink(name.c_str());
+        return {Status::ERROR, "Cannot size the shared memory segment."};
+    }
+    Segment *segment = map_segment(fd, size);
+    ::close(fd);
+    if (segment == nullptr) {
+        shm_unlink(name.c_str());
+        return {Status::ERROR, "Cannot map the shared memory segment."};
+    }
+
+    // The segment is zero filled, so only the sequences need setting before the magic number.
+    std::construct_at(segment);
+    segment->version = VERSION;
+    segment->slot_count = count;
+    segment->slot_size = slot_size;
+    segment->slot_stride = stride;
+    std::byte *slots = reinterpret_cast<std::byte *>(segment) + SLOTS_OFFSET;
+    for (uint64_t position = 0; position < count; position++) {
+        Slot *slot = std::construct_at(reinterpret_cast<Slot *>(slots + position * stride));
+        slot->sequence.store(position, std::memory_order_relaxed);
+    }
+    segment->magic.store(MAGIC, std::memory_order_release);
+    return SharedMessageBuffer(segment, size);
+}
+
+StatusOr<SharedMessageBuffer> SharedMessageBuffer::open(const std::string &name) {
+    const int fd = shm_open(name.c_str(), O_RDWR, 0);
+    if (fd == -1) {
+        return {Status::ERROR, "Cannot open the shared memory segment."};
+    }
+    struct stat status;
+    if (fstat(fd, &status) == -1 || static_cast<std::size_t>(status.st_size) < SLOTS_OFFSET) {
+        ::close(fd);
+        return {Status::ERROR, "The shared memory segment does not hold a message buffer."};
+    }
+    const std::size_t size = static_cast<std::size_t>(status.st_size);
+    Segment *segment = map_segment(fd, size);
+    ::close(fd);
+    if (segment == nullptr) {
+        return {Status::ERROR, "Cannot map the shared memory segment."};
+    }
+
+    if (segment->magic.load(std::memory_order_acquire) != MAGIC ||
+        segment->version != VERSION ||
+        segment_size(segment->slot_count, segment->slot_stride) != size) {
+        munmap(segment, size);
+        return {Status::ERROR, "The shared memory segment does not hold a message buffer."};
+    }
+    return SharedMessageBuffer(segment, size);
+}
+
+StatusOr<void> SharedMessageBuffer::unlink(const std::string &name) {
+    if (shm_unlink(name.c_str()) == -1) {
+        return {Status::ERROR, "Cannot unlink the shared memory segment."};
+    }
+    return {};
+}
+
+SharedMessageBuffer::SharedMessageBuffer(SharedMessageBuffer &&other) noexcept
+    : segment(std::exchange(other.segment, nullptr)),
+      mapped_size(std::exchange(other.mapped_size, 0)) {}
+
+SharedMessageBuffer &SharedMessageBuffer::operator=(SharedMessageBuffer &&other) noexcept {
+    if (this != &other) {
+        if (segment != nullptr) {
+            munmap(segment, mapped_size);
+        }
+        segment = std::exchange(other.segment, nullptr);
+        mapped_size = std::exchange(other.mapped_size, 0);
+    }
+    return *this;
+}
+
+SharedMessageBuffer::~SharedMessageBuffer() {
+    if (segment != nullptr) {
+        munmap(segment, mapped_size);
+    }
+}
+
+StatusOr<void> SharedMessageBuffer::push(const void *data, std::size_t size) {
+    StatusOr<SharedSlot> slot = reserve(size);
+    if (!slot.ok()) {
+        return {slot.status(), slot.status_message()};
+    }
+    std::memcpy(slot->data(), data, size);
+    publish(*slot);
+    return {};
+}
+
+StatusOr<std::vector<std::byte>> SharedMessageBuffer::pop() {
+    StatusOr<SharedSlot> slot = acquire_until(nullptr);
+    if (!slot.ok()) {
+        return {slot.status(), slot.status_message()};
+    }
+    std::vector<std::byte> message(slot->data(), slot->data() + slot->size());
+    release(*slot);
+    return message;
+}
+
+StatusOr<std::vector<std::byte>> SharedMessageBuffer::pop(int timeout) {
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout);
+    StatusOr<SharedSlot> slot = acquire_until(&deadline);
+    if (slot.status() == Status::TIMEOUT) {
+        close();
+    }
+    if (!slot.ok()) {
+        return {slot.status(), slot.status_message()};
+    }
+    std::vector<std::byte> message(slot->data(), slot->data() + slot->size());
+    release(*slot);
+    return message;
+}
+
+StatusOr<SharedSlot> SharedMessageBuffer::reserve(std::size_t size) {
+    if (size > segment->slot_size) {
+        return {Status::ERROR, "Message is larger than a slot."};
+    }
+    const int32_t pid = current_pid();
+    for (;;) {
+        if (segment->closed.load() != 0) {
+            return {Status::CLOSED, "Queue is closed."};
+        }
+
+        uint64_t position = segment->enqueue_position.load(std::memory_order_relaxed);
+        std::byte *address = slot_at(position);
+        Slot &slot = slot_header(address);
+        const uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+        const int64_t lag = static_cast<int64_t>(sequence - position);
+
+        if (lag == 0) {
+            // The slot is free for this position. Wait while a live producer claimed it without
+            // taking the position yet, and take the claim over if that producer died.
+            uint64_t claim = slot.claim.load();
+            if (state_of(claim) == WRITING) {
+                if (segment->enqueue_position.load() != position) {
+                    continue;
+                }
+                if (!process_dead(owner_of(claim))) {
+                    std::this_thread::yield();
+                    continue;
+                }
+            } else if (state_of(claim) != FREE) {
+                continue;
+            }
+            if (slot.claim.compare_exchange_strong(claim, claim_of(pid, WRITING))) {
+#ifdef LIBCC_SHARED_MESSAGE_BUFFER_TESTING
+                if (claim_hook != nullptr) {
+                    claim_hook();
+                }
+#endif
+                if (!segment->enqueue_position.compare_exchange_strong(position, position + 1)) {
+                    // The slot moved on to a later position since it was read, so hand the claim
+                    // back to the producers of that position.
+                    slot.claim.store(claim);
+                    continue;
+                }
+                return SharedSlot(slot_data(address), size, position);
+            }
+        } else if (lag < 0) {
+            // The ring is full, so wait for the slot to be read.
+            wait_on(
+                segment->released, segment->producers_waiting,
+                [&] {
+                    return slot.sequence.load() != sequence || segment->closed.load() != 0;
+                },
+                RECOVERY_INTERVAL);
+
+            // Free the slot if its reader died after taking its position, dropping the message.
+            uint64_t claim = slot.claim.load();
+            if (slot.sequence.load() == sequence && state_of(claim) == READING &&
+                process_dead(owner_of(claim)) && segment->dequeue_position.load() >= sequence &&
+                slot.claim.compare_exchange_strong(claim, claim_of(0, FREE))) {
+                slot.sequence.store(position, std::memory_order_release);
+                notify(segment->released, segment->producers_waiting, INT_MAX);
+            }
+        }
+    }
+}
+
+void SharedMessageBuffer::publish(const SharedSlot &slot) {
+    Slot &header = slot_header(slot_at(slot.position));
+    header.size.store(slot.size(), std::memory_order_relaxed);
+    header.claim.store(claim_of(0, READY));
+    header.sequence.store(slot.position + 1, std::memory_order_release);
+    notify(segment->published, segment->consumers_waiting, 1);
+}
+
+StatusOr<SharedSlot> SharedMessageBuffer::acquire() { return acquire_until(nullptr); }
+
+StatusOr<SharedSlot> SharedMessageBuffer::acquire(int timeout) {
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout);
+    return acquire_until(&deadline);
+}
+
+StatusOr<SharedSlot> SharedMessageBuffer::acquire_until(
+    const std::chrono::steady_clock::time_point *deadline) {
+    const int32_t pid = current_pid();
+    for (;;) {
+        uint64_t position = segment->dequeue_position.load(std::memory_order_relaxed);
+        std::byte *address = slot_at(position);
+        Slot &slot = slot_header(address);
+        const uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+        const int64_t lag = static_cast<int64_t>(sequence - (position + 1));
+
+        if (lag == 0) {
+            // The message is published. Wait while a live consumer claimed it without taking the
+            // position yet, and take the claim over if that consumer died.
+            uint64_t claim = slot.claim.load();
+            if (state_of(claim) == READING) {
+                if (segment->dequeue_position.load() != position) {
+                    continue;
+                }
+                if (!process_dead(owner_of(claim))) {
+                    std::this_thread::yield();
+                    continue;
+                }
+            } else if (state_of(claim) != READY) {
+                continue;
+            }
+            if (slot.claim.compare_exchange_strong(claim, claim_of(pid, READING))) {
+#ifdef LIBCC_SHARED_MESSAGE_BUFFER_TESTING
+                if (claim_hook != nullptr) {
+                    claim_hook();
+                }
+#endif
+                if (!segment->dequeue_position.compare_exchange_strong(position, position + 1)) {
+                    // The slot moved on to a later position since it was read, so hand the claim
+                    // back to the consumers of that position.
+                    slot.claim.store(claim);
+                    continue;
+                }
+
+                // Skip the slots given up by dead producers.
+                const uint64_t size = slot.size.load(std::memory_order_relaxed);
+                if (size == NO_MESSAGE) {
+                    release(SharedSlot(slot_data(address), 0, position));
+                    continue;
+                }
+                return SharedSlot(slot_data(address), size, position);
+            }
+        } else if (lag < 0) {
+            // Nothing is published here, and once closed nothing will be unless already claimed.
+            auto drained = [&] {
+                return segment->closed.load() != 0 &&
+                       segment->enqueue_position.load() == position;
+            };
+            if (drained()) {
+                return {Status::CLOSED, "Queue is closed and empty."};
+            }
+
+            std::chrono::nanoseconds timeout = RECOVERY_INTERVAL;
+            if (deadline != nullptr) {
+                const auto now = std::chrono::steady_clock::now();
+                if (now >= *deadline) {
+                    return {Status::TIMEOUT, "Timeout reached."};
+                }
+                timeout = std::min<std::chrono::nanoseconds>(timeout, *deadline - now);
+            }
+            wait_on(
+                segment->published, segment->consumers_waiting,
+                [&] { return slot.sequence.load() != sequence || drained(); }, timeout);
+
+            // Give up the slot if its writer died after taking its position, so the consumers
+            // skip it.
+            uint64_t claim = slot.claim.load();
+            if (slot.sequence.load() == position && state_of(claim) == WRITING &&
+                process_dead(owner_of(claim)) && segment->enqueue_position.load() > position &&
+                slot.claim.compare_exchange_strong(claim, claim_of(0, READY))) {
+                slot.size.store(NO_MESSAGE, std::memory_order_relaxed);
+                slot.sequence.store(position + 1, std::memory_order_release);
+                notify(segment->published, segment->consumers_waiting, INT_MAX);
+            }
+        }
+    }
+}
+
+void SharedMessageBuffer::release(const SharedSlot &slot) {
+    Slot &header = slot_header(slot_at(slot.position));
+    header.claim.store(claim_of(0, FREE));
+    header.sequence.store(slot.position + segment->slot_count, std::memory_order_release);
+    notify(segment->released, segment->producers_waiting, 1);
+}
+
+void SharedMessageBuffer::close() {
+    if (segment->closed.exchange(1) == 0) {
+        notify(segment->published, segment->consumers_waiting, INT_MAX);
+        notify(segment->released, segment->producers_waiting, INT_MAX);
+    }
+}
+
+bool SharedMessageBuffer::is_closed() const { return segment->closed.load() != 0; }
+
+bool SharedMessageBuffer::empty() const {
+    return segment->enqueue_position.load() == segment->dequeue_position.load();
+}
+
+std::size_t SharedMessageBuffer::slot_count() const { return segment->slot_count; }
+
+std::size_t SharedMessageBuffer::slot_size() const { return segment->slot_size; }
+
+std::byte *SharedMessageBuffer::slot_at(uint64_t position) const {
+    return reinterpret_cast<std::byte *>(segment) + SLOTS_OFFSET +
+           (position & (segment->slot_count - 1)) * segment->slot_stride;
+}
+
+}  // namespace ostp::libcc::data_structures
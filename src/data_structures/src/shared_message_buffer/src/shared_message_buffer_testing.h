@@ -0,0 +1,18 @@
+#ifndef LIBCC_DATA_STRUCTURES_SHARED_MESSAGE_BUFFER_TESTING_H
+#define LIBCC_DATA_STRUCTURES_SHARED_MESSAGE_BUFFER_TESTING_H
+
+// Fault injection for the crash recovery tests, only compiled into their build of the buffer.
+
+#ifdef LIBCC_SHARED_MESSAGE_BUFFER_TESTING
+
+namespace ostp::libcc::data_structures::shared_message_buffer_internal {
+
+/// Called by reserve() and acquire() between claiming a slot and taking its position, so tests
+/// can crash a process there. Null unless set by a test.
+extern void (*claim_hook)();
+
+}  // namespace ostp::libcc::data_structures::shared_message_buffer_internal
+
+#endif
+
+#endif
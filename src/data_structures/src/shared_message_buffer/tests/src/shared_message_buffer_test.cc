@@ -0,0 +1,336 @@
+#include "shared_message_buffer.h"
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "logger.h"
+#include "shared_message_buffer_testing.h"
+#include "status.h"
+#include "testing.h"
+
+using ostp::libcc::data_structures::SharedMessageBuffer;
+using ostp::libcc::data_structures::SharedSlot;
+using ostp::libcc::data_structures::shared_message_buffer_internal::claim_hook;
+using ostp::libcc::utils::log_error;
+using ostp::libcc::utils::Status;
+using std::string;
+using std::thread;
+
+/// Returns a segment name unique to this process and call.
+string segment_name() {
+    static std::atomic<int> next(0);
+    return "/libcc_shared_message_buffer_test_" + std::to_string(getpid()) + "_" +
+           std::to_string(next++);
+}
+
+/// Returns a popped message as a string.
+string as_string(const std::vector<std::byte> &message) {
+    return string(reinterpret_cast<const char *>(message.data()), message.size());
+}
+
+START_SUITE(SharedMessageBuffer_Tests)
+
+START_TEST(CreatesAndOpensSegments) {
+    const string name = segment_name();
+    auto created = SharedMessageBuffer::create(name, 3, 100);
+    ASSERT(created.ok());
+    TEST(created->slot_count() == 4);
+    TEST(created->slot_size() == 100);
+    TEST(created->empty() && !created->is_closed());
+
+    // The name is taken until unlinked and the segment can be mapped again under it.
+    TEST(SharedMessageBuffer::create(name, 4, 100).status() == Status::ERROR);
+    auto opened = SharedMessageBuffer::open(name);
+    ASSERT(opened.ok());
+    TEST(opened->slot_count() == 4 && opened->slot_size() == 100);
+
+    // Both mappings see the same messages.
+    TEST(created->push("abc", 3).ok());
+    auto message = opened->pop();
+    ASSERT(message.ok());
+    TEST(as_string(*message) == "abc");
+
+    TEST(SharedMessageBuffer::unlink(name).ok());
+    TEST(SharedMessageBuffer::open(name).status() == Status::ERROR);
+    TEST(SharedMessageBuffer::unlink(name).status() == Status::ERROR);
+    TEST(SharedMessageBuffer::create(name, 0, 100).status() == Status::ERROR);
+}
+END_TEST
+
+START_TEST(MessagesAreDeliveredInOrder) {
+    const string name = segment_name();
+    auto buffer = SharedMessageBuffer::create(name, 4, 16);
+    ASSERT(buffer.ok());
+    (void)SharedMessageBuffer::unlink(name);
+
+    // Messages of any size up to a slot go through, including across the end of the ring.
+    for (int i = 0; i < 10; i++) {
+        const string message(i, static_cast<char>('a' + i));
+        TEST(buffer->push(message.data(), message.size()).ok());
+        auto popped = buffer->pop();
+        ASSERT(popped.ok());
+        TEST(as_string(*popped) == message);
+    }
+    TEST(buffer->push("01234567890123456", 17).status() == Status::ERROR);
+    TEST(buffer->empty());
+}
+END_TEST
+
+START_TEST(CloseDrainsThenReportsClosed) {
+    const string name = segment_name();
+    auto buffer = SharedMessageBuffer::create(name, 4, 16);
+    ASSERT(buffer.ok());
+    (void)SharedMessageBuffer::unlink(name);
+
+    TEST(buffer->push("a", 1).ok());
+    TEST(buffer->push("b", 1).ok());
+    buffer->close();
+    TEST(buffer->is_closed());
+
+    // Pushed messages are still popped but no more can be pushed.
+    TEST(buffer->push("c", 1).status() == Status::CLOSED);
+    TEST(as_string(*buffer->pop()) == "a");
+    TEST(as_string(*buffer->pop()) == "b");
+    TEST(buffer->pop().status() == Status::CLOSED);
+}
+END_TEST
+
+START_TEST(CloseUnblocksPop) {
+    const string name = segment_name();
+    auto buffer = SharedMessageBuffer::create(name, 4, 16);
+    ASSERT(buffer.ok());
+    (void)SharedMessageBuffer::unlink(name);
+
+    auto t1 = thread([&]() { TEST(buffer->pop().status() == Status::CLOSED); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    buffer->close();
+    t1.join();
+}
+END_TEST
+
+START_TEST(PopWithTimeoutCanTimeOut) {
+    const string name = segment_name();
+    auto buffer = SharedMessageBuffer::create(name, 4, 16);
+    ASSERT(buffer.ok());
+    (void)SharedMessageBuffer::unlink(name);
+
+    // acquire() leaves the buffer open on timeout while pop() closes it, as MessageBuffer does.
+    TEST(buffer->acquire(5).status() == Status::TIMEOUT);
+    TEST(!buffer->is_closed());
+    TEST(buffer->pop(5).status() == Status::TIMEOUT);
+    TEST(buffer->is_closed());
+}
+END_TEST
+
+START_TEST(FullRingBlocksPush) {
+    const string name = segment_name();
+    auto buffer = SharedMessageBuffer::create(name, 2, 16);
+    ASSERT(buffer.ok());
+    (void)SharedMessageBuffer::unlink(name);
+
+    TEST(buffer->push("a", 1).ok());
+    TEST(buffer->push("b", 1).ok());
+
+    // The third push waits for a slot to be read.
+    std::atomic<bool> pushed(false);
+    auto t1 = thread([&]() {
+        TEST(buffer->push("c", 1).ok());
+        pushed = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    TEST(!pushed);
+    TEST(as_string(*buffer->pop()) == "a");
+    t1.join();
+    TEST(as_string(*buffer->pop()) == "b");
+    TEST(as_string(*buffer->pop()) == "c");
+}
+END_TEST
+
+START_TEST(ConcurrentProducersAndConsumersDeliverEveryMessage) {
+    const string name = segment_name();
+    auto buffer = SharedMessageBuffer::create(name, 8, sizeof(int));
+    ASSERT(buffer.ok());
+    (void)SharedMessageBuffer::unlink(name);
+
+    const int producers = 4;
+    const int per_producer = 2000;
+    std::atomic<long> sum(0);
+    std::vector<thread> threads;
+    for (int p = 0; p < producers; p++) {
+        threads.emplace_back([&, p]() {
+            for (int i = 0; i < per_producer; i++) {
+                const int value = p * per_producer + i;
+                TEST(buffer->push(&value, sizeof(value)).ok());
+            }
+        });
+    }
+    for (int c = 0; c < 2; c++) {
+        threads.emplace_back([&]() {
+            for (auto message = buffer->pop(); message.ok(); message = buffer->pop()) {
+                int value;
+                std::memcpy(&value, message->data(), sizeof(value));
+                sum += value;
+            }
+        });
+    }
+    for (int p = 0; p < producers; p++) {
+        threads[p].join();
+    }
+    buffer->close();
+    for (std::size_t t = producers; t < threads.size(); t++) {
+        threads[t].join();
+    }
+
+    const long total = producers * per_producer;
+    TEST(sum == total * (total - 1) / 2);
+}
+END_TEST
+
+START_SERIAL_TEST(MessagesCrossProcessesInPlace) {
+    const string name = segment_name();
+    auto buffer = SharedMessageBuffer::create(name, 4, 64);
+    ASSERT(buffer.ok());
+
+    // The child maps the segment by name at its own address and writes in place.
+    const pid_t child = fork();
+    if (child == 0) {
+        auto producer = SharedMessageBuffer::open(name);
+        for (int i = 0; producer.ok() && i < 100; i++) {
+            auto slot = producer->reserve(sizeof(int));
+            if (!slot.ok()) {
+                _exit(1);
+            }
+            std::memcpy(slot->data(), &i, sizeof(i));
+            producer->publish(*slot);
+        }
+        _exit(producer.ok() ? 0 : 1);
+    }
+
+    // The parent reads in place.
+    for (int i = 0; i < 100; i++) {
+        auto slot = buffer->acquire(5000);
+        ASSERT(slot.ok());
+        int value;
+        ASSERT(slot->size() == sizeof(value));
+        std::memcpy(&value, slot->data(), sizeof(value));
+        TEST(value == i);
+        buffer->release(*slot);
+    }
+    int status;
+    TEST(waitpid(child, &status, 0) == child && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    TEST(SharedMessageBuffer::unlink(name).ok());
+}
+END_TEST
+
+START_SERIAL_TEST(RecoversFromCrashedProducer) {
+    const string name = segment_name();
+    auto buffer = SharedMessageBuffer::create(name, 4, 16);
+    ASSERT(buffer.ok());
+    (void)SharedMessageBuffer::unlink(name);
+
+    // The child dies holding a slot it never publishes.
+    const pid_t child = fork();
+    if (child == 0) {
+        auto slot = buffer->reserve(1);
+        _exit(slot.ok() ? 0 : 1);
+    }
+    int status;
+    TEST(waitpid(child, &status, 0) == child && WEXITSTATUS(status) == 0);
+
+    // The abandoned slot is skipped.
+    TEST(buffer->push("a", 1).ok());
+    auto message = buffer->pop(5000);
+    ASSERT(message.ok());
+    TEST(as_string(*message) == "a");
+    TEST(buffer->empty());
+}
+END_TEST
+
+START_SERIAL_TEST(TakesOverClaimOfCrashedProducer) {
+    const string name = segment_name();
+    auto buffer = SharedMessageBuffer::create(name, 4, 16);
+    ASSERT(buffer.ok());
+    (void)SharedMessageBuffer::unlink(name);
+
+    // The child dies after claiming a slot but before taking its position.
+    const pid_t child = fork();
+    if (child == 0) {
+        claim_hook = [] { _exit(0); };
+        (void)buffer->reserve(1);
+        _exit(1);
+    }
+    int status;
+    TEST(waitpid(child, &status, 0) == child && WEXITSTATUS(status) == 0);
+
+    // The next producer takes the slot over and nothing is skipped.
+    TEST(buffer->push("a", 1).ok());
+    TEST(buffer->push("b", 1).ok());
+    auto message = buffer->pop(5000);
+    ASSERT(message.ok());
+    TEST(as_string(*message) == "a");
+    TEST(as_string(*buffer->pop()) == "b");
+    TEST(buffer->empty());
+}
+END_TEST
+
+START_SERIAL_TEST(RecoversFromCrashedConsumer) {
+    const string name = segment_name();
+    auto buffer = SharedMessageBuffer::create(name, 2, 16);
+    ASSERT(buffer.ok());
+    (void)SharedMessageBuffer::unlink(name);
+    TEST(buffer->push("a", 1).ok());
+    TEST(buffer->push("b", 1).ok());
+
+    // The child dies holding the slot of the first message.
+    const pid_t child = fork();
+    if (child == 0) {
+        auto slot = buffer->acquire();
+        _exit(slot.ok() ? 0 : 1);
+    }
+    int status;
+    TEST(waitpid(child, &status, 0) == child && WEXITSTATUS(status) == 0);
+
+    // Its slot is freed for the producer, dropping the message.
+    TEST(as_string(*buffer->pop()) == "b");
+    TEST(buffer->push("c", 1).ok());
+    TEST(buffer->push("d", 1).ok());
+    TEST(as_string(*buffer->pop()) == "c");
+    TEST(as_string(*buffer->pop()) == "d");
+}
+END_TEST
+
+START_SERIAL_TEST(TakesOverClaimOfCrashedConsumer) {
+    const string name = segment_name();
+    auto buffer = SharedMessageBuffer::create(name, 2, 16);
+    ASSERT(buffer.ok());
+    (void)SharedMessageBuffer::unlink(name);
+    TEST(buffer->push("a", 1).ok());
+    TEST(buffer->push("b", 1).ok());
+
+    // The child dies after claiming the first message but before taking its position.
+    const pid_t child = fork();
+    if (child == 0) {
+        claim_hook = [] { _exit(0); };
+        (void)buffer->acquire();
+        _exit(1);
+    }
+    int status;
+    TEST(waitpid(child, &status, 0) == child && WEXITSTATUS(status) == 0);
+
+    // The next consumer takes the message over and the producer can reuse its slot.
+    TEST(as_string(*buffer->pop()) == "a");
+    TEST(buffer->push("c", 1).ok());
+    TEST(as_string(*buffer->pop()) == "b");
+    TEST(as_string(*buffer->pop()) == "c");
+    TEST(buffer->empty());
+}
+END_TEST
+
+END_SUITE
@@ -0,0 +1,58 @@
+#include "static_trie.h"
+
+#include <array>
+#include <string_view>
+
+#include "benchmarking.h"
+#include "default_trie.h"
+
+using ostp::libcc::data_structures::DefaultTrie;
+using ostp::libcc::data_structures::StaticTrie;
+using ostp::libcc::data_structures::StaticTrieEntry;
+using ostp::libcc::utils::do_not_optimize;
+
+const int no_match = -1;
+
+/// HTTP methods and their codes.
+constexpr std::array<StaticTrieEntry<int>, 9> methods = {{
+    {"GET", 0},
+    {"HEAD", 1},
+    {"POST", 2},
+    {"PUT", 3},
+    {"DELETE", 4},
+    {"CONNECT", 5},
+    {"OPTIONS", 6},
+    {"TRACE", 7},
+    {"PATCH", 8},
+}};
+
+/// Request methods looked up, including misses.
+constexpr std::array<std::string_view, 12> requests = {
+    "GET", "POST", "GET", "PUT", "PATCH", "GET", "DELETE", "OPTIONS", "BREW", "HEAD", "GE", "get",
+};
+
+START_BENCH_SUITE(StaticTrie)
+
+constexpr StaticTrie<[] { return methods; }> static_trie(no_match);
+DefaultTrie<char, int> default_trie(no_match);
+for (const auto &[key, value] : methods) {
+    default_trie.insert(key.data(), key.size(), value);
+}
+
+START_BENCH(StaticTrieGet) {
+    BENCH_LOOP {
+        const std::string_view request = requests[_iteration % requests.size()];
+        do_not_optimize(static_trie.get(request.data(), request.size()));
+    }
+}
+END_BENCH
+
+START_BENCH(DefaultTrieGet) {
+    BENCH_LOOP {
+        const std::string_view request = requests[_iteration % requests.size()];
+        do_not_optimize(default_trie.get(request.data(), request.size()));
+    }
+}
+END_BENCH
+
+END_BENCH_SUITE
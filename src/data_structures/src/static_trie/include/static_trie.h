@@ -0,0 +1,209 @@
+#ifndef LIBCC_DATA_STRUCTURES_STATIC_TRIE_H
+#define LIBCC_DATA_STRUCTURES_STATIC_TRIE_H
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+
+namespace ostp::libcc::data_structures {
+
+/// A key and its value in a StaticTrie.
+template <class R>
+struct StaticTrieEntry {
+    std::string_view key;
+    R value;
+};
+
+namespace static_trie_internal {
+
+/// Index of the entry of a node that ends no key.
+inline constexpr int NO_ENTRY = -1;
+
+/// Node of a static trie. Its edges are contiguous in the edge table.
+struct Node {
+    std::size_t first_edge;
+    std::size_t edge_count;
+    int entry;
+};
+
+/// Edge from a node to a child labelled with the next character of the keys below it.
+struct Edge {
+    char label;
+    std::size_t child;
+};
+
+/// Nodes and edges of a static trie, the edge of node n being at index n - 1.
+template <std::size_t NODES>
+struct Tables {
+    std::array<Node, NODES> nodes;
+    std::array<Edge, NODES> edges;
+};
+
+/// Returns the entries sorted by key.
+///
+/// Throws:
+///     std::logic_error if a key appears twice, which fails the constant evaluation.
+template <class R, std::size_t N>
+constexpr std::array<StaticTrieEntry<R>, N> sort_entries(
+    std::array<StaticTrieEntry<R>, N> entries) {
+    std::sort(entries.begin(), entries.end(),
+              [](const auto &a, const auto &b) { return a.key < b.key; });
+    for (std::size_t i = 1; i < N; i++) {
+        if (entries[i].key == entries[i - 1].key) {
+            throw std::logic_error("Duplicate key in StaticTrie");
+        }
+    }
+    return entries;
+}
+
+/// Returns the length of the longest common prefix of two keys.
+constexpr std::size_t common_prefix(std::string_view a, std::string_view b) {
+    std::size_t length = 0;
+    while (length < a.size() && length < b.size() && a[length] == b[length]) {
+        length++;
+    }
+    return length;
+}
+
+/// Returns the number of distinct prefixes, including the empty one, of sorted keys.
+template <class R, std::size_t N>
+constexpr std::size_t count_nodes(const std::array<StaticTrieEntry<R>, N> &entries) {
+    std::size_t nodes = 1;
+    for (std::size_t i = 0; i < N; i++) {
+        const std::size_t shared = i > 0 ? common_prefix(entries[i - 1].key, entries[i].key) : 0;
+        nodes += entries[i].key.size() - shared;
+    }
+    return nodes;
+}
+
+/// Builds the trie of sorted keys breadth-first so the children of each node are contiguous.
+template <std::size_t NODES, class R, std::size_t N>
+constexpr Tables<NODES> build(const std::array<StaticTrieEntry<R>, N> &entries) {
+    // Each node covers the range of keys starting with its prefix.
+    struct Range {
+        std::size_t depth;
+        std::size_t begin;
+        std::size_t end;
+    };
+    std::array<Range, NODES> ranges{};
+    Tables<NODES> tables{};
+    ranges[0] = {0, 0, N};
+    std::size_t count = 1;
+
+    for (std::size_t node = 0; node < count; node++) {
+        const auto [depth, begin, end] = ranges[node];
+        std::size_t i = begin;
+
+        // A key equal to the prefix sorts before the longer ones.
+        tables.nodes[node] = {count - 1, 0, NO_ENTRY};
+        if (i < end && entries[i].key.size() == depth) {
+            tables.nodes[node].entry = static_cast<int>(i++);
+        }
+
+        // Add a child for each run of keys sharing the next character.
+        while (i < end) {
+            const char label = entries[i].key[depth];
+            std::size_t j = i;
+            while (j < end && entries[j].key[depth] == label) {
+                j++;
+            }
+            tables.edges[count - 1] = {label, count};
+            tables.nodes[node].edge_count++;
+            ranges[count++] = {depth + 1, i, j};
+            i = j;
+        }
+    }
+    return tables;
+}
+
+}  // namespace static_trie_internal
+
+/// Trie of a fixed set of string keys built entirely at compile time.
+///
+/// It offers the get() and contains() of DefaultTrie<char, R> for keyword tables such as HTTP
+/// methods or command verbs, which are known when compiling and never change. The entries come
+/// from a lambda returning a std::array of StaticTrieEntry; their trie is laid out in constant
+/// tables and each node's lookup is a chain of comparisons against its edge labels, instantiated
+/// per node, so a lookup allocates nothing and the trie costs nothing at startup.
+///
+///     constexpr StaticTrie<[] {
+///         return std::array{StaticTrieEntry<int>{"GET", 1}, StaticTrieEntry<int>{"PUT", 2}};
+///     }> methods(0);
+///     static_assert(methods.get("PUT") == 2);
+template <auto MakeEntries>
+class StaticTrie {
+   private:
+    using Entry = typename decltype(MakeEntries())::value_type;
+    using R = decltype(Entry::value);
+
+    static constexpr auto entries = static_trie_internal::sort_entries(MakeEntries());
+    static constexpr std::size_t NODES = static_trie_internal::count_nodes(entries);
+    static constexpr auto tables = static_trie_internal::build<NODES>(entries);
+
+    R default_return;  // Default return for no matches.
+
+   public:
+    /// Constructs a trie with the specified default return for no matches.
+    ///
+    /// Arguments:
+    ///     default_return: The default return for no matches.
+    constexpr explicit StaticTrie(const R default_return) : default_return(default_return) {}
+
+    /// Returns the number of entries in the trie.
+    static constexpr int size() { return static_cast<int>(entries.size()); }
+
+    /// Returns the return of the specified entry or the default return if there is none.
+    ///
+    /// Arguments:
+    ///     entry: The entry to get the return for.
+    ///     entry_len: The length of the entry.
+    constexpr R get(const char entry[], const int entry_len) const {
+        const int index = find<0>(entry, entry_len);
+        return index == static_trie_internal::NO_ENTRY ? default_return : entries[index].value;
+    }
+    constexpr R get(std::string_view entry) const {
+        return get(entry.data(), static_cast<int>(entry.size()));
+    }
+
+    /// Returns whether the trie contains the specified entry.
+    ///
+    /// Arguments:
+    ///     entry: The entry to check for.
+    ///     entry_len: The length of the entry.
+    constexpr bool contains(const char entry[], const int entry_len) const {
+        return find<0>(entry, entry_len) != static_trie_internal::NO_ENTRY;
+    }
+    constexpr bool contains(std::string_view entry) const {
+        return contains(entry.data(), static_cast<int>(entry.size()));
+    }
+
+   private:
+    /// Returns the index of the entry matching the rest of a key from the specified node.
+    template <std::size_t Node>
+    static constexpr int find(const char *rest, int rest_len) {
+        if (rest_len <= 0) {
+            return tables.nodes[Node].entry;
+        }
+        return find_child<Node>(rest, rest_len,
+                                std::make_index_sequence<tables.nodes[Node].edge_count>{});
+    }
+
+    /// Compares the next character with each edge label of a node and descends the matching one.
+    template <std::size_t Node, std::size_t... Edges>
+    static constexpr int find_child(const char *rest, int rest_len, std::index_sequence<Edges...>) {
+        constexpr std::size_t first = tables.nodes[Node].first_edge;
+        int index = static_trie_internal::NO_ENTRY;
+        // Only the assignment to index matters, the value of the fold is discarded.
+        (void)((rest[0] == tables.edges[first + Edges].label &&
+                (index = find<tables.edges[first + Edges].child>(rest + 1, rest_len - 1), true)) ||
+               ...);
+        return index;
+    }
+};
+
+}  // namespace ostp::libcc::data_structures
+
+#endif
@@ -0,0 +1,71 @@
+#include "static_trie.h"
+
+#include <array>
+#include <string>
+
+#include "logger.h"
+#include "testing.h"
+
+using ostp::libcc::data_structures::StaticTrie;
+using ostp::libcc::data_structures::StaticTrieEntry;
+
+const int no_match = -1;
+
+/// HTTP methods, including keys that are prefixes of others.
+constexpr StaticTrie<[] {
+    return std::array{
+        StaticTrieEntry<int>{"GET", 0},    StaticTrieEntry<int>{"HEAD", 1},
+        StaticTrieEntry<int>{"POST", 2},   StaticTrieEntry<int>{"PUT", 3},
+        StaticTrieEntry<int>{"DELETE", 4}, StaticTrieEntry<int>{"PATCH", 5},
+        StaticTrieEntry<int>{"P", 6},      StaticTrieEntry<int>{"", 7},
+    };
+}> methods(no_match);
+
+// Lookups are constant expressions.
+static_assert(methods.size() == 8);
+static_assert(methods.get("GET") == 0);
+static_assert(methods.get("PATCH") == 5);
+static_assert(methods.get("P") == 6);
+static_assert(methods.get("") == 7);
+static_assert(methods.get("PA") == no_match);
+static_assert(methods.contains("DELETE"));
+static_assert(!methods.contains("DELETES"));
+
+START_SUITE(StaticTrie_Tests)
+
+START_TEST(GetsEveryEntry) {
+    const std::array<std::string, 8> keys = {"GET", "HEAD", "POST", "PUT",
+                                             "DELETE", "PATCH", "P", ""};
+    for (int i = 0; i < static_cast<int>(keys.size()); i++) {
+        TEST(methods.get(keys[i].data(), keys[i].size()) == i);
+        TEST(methods.contains(keys[i].data(), keys[i].size()));
+    }
+}
+END_TEST
+
+START_TEST(ReturnsDefaultForMisses) {
+    for (const std::string key : {"get", "GE", "GETS", "HEADER", "OPTIONS", "X", "PO"}) {
+        TEST(methods.get(key) == no_match);
+        TEST(!methods.contains(key));
+    }
+}
+END_TEST
+
+START_TEST(LengthBoundsTheLookup) {
+    // Only the first entry_len characters are looked up.
+    const char buffer[] = "PUTX";
+    TEST(methods.get(buffer, 3) == 3);
+    TEST(methods.get(buffer, 1) == 6);
+    TEST(methods.get(buffer, 0) == 7);
+}
+END_TEST
+
+START_TEST(EmptyTrieHasNoMatch) {
+    constexpr StaticTrie<[] { return std::array<StaticTrieEntry<char>, 0>{}; }> empty('?');
+    TEST(empty.size() == 0);
+    TEST(empty.get("") == '?');
+    TEST(!empty.contains("a"));
+}
+END_TEST
+
+END_SUITE
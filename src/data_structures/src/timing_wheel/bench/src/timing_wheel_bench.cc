@@ -0,0 +1,46 @@
+#include "timing_wheel.h"
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "benchmarking.h"
+#include "message_buffer.h"
+
+using ostp::libcc::data_structures::MessageBuffer;
+using ostp::libcc::data_structures::TimerHandle;
+using ostp::libcc::data_structures::TimingWheel;
+using ostp::libcc::utils::do_not_optimize;
+using std::chrono::milliseconds;
+
+START_BENCH_SUITE(TimingWheel)
+
+// One timer scheduled and cancelled per iteration, as for a request timeout.
+START_BENCH(ScheduleAndCancel) {
+    MessageBuffer<uint64_t> buffer;
+    TimingWheel<uint64_t> wheel(buffer, milliseconds(1));
+    const auto origin = wheel.origin();
+    BENCH_LOOP {
+        const auto deadline = origin + milliseconds(1000 + _iteration % 100000);
+        const TimerHandle handle = wheel.schedule_at(deadline, uint64_t(_iteration));
+        do_not_optimize(wheel.cancel(handle));
+    }
+}
+END_BENCH
+
+// One timer per iteration spread over a minute, all expired and delivered.
+START_BENCH(ScheduleAndExpire) {
+    MessageBuffer<uint64_t> buffer;
+    TimingWheel<uint64_t> wheel(buffer, milliseconds(1));
+    const auto origin = wheel.origin();
+    BENCH_LOOP {
+        wheel.schedule_at(origin + milliseconds(1 + _iteration % 60000), uint64_t(_iteration));
+    }
+    do_not_optimize(wheel.advance(origin + milliseconds(60000)));
+    while (!buffer.empty()) {
+        do_not_optimize(*buffer.pop());
+    }
+}
+END_BENCH
+
+END_BENCH_SUITE
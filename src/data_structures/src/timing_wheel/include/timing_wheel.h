@@ -0,0 +1,372 @@
+#ifndef LIBCC_DATA_STRUCTURES_TIMING_WHEEL_H
+#define LIBCC_DATA_STRUCTURES_TIMING_WHEEL_H
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "message_buffer.h"
+#include "status.h"
+#include "status_or.h"
+
+namespace ostp::libcc::data_structures {
+
+/// Handle of a timer scheduled on a TimingWheel, used to cancel it.
+struct TimerHandle {
+    uint32_t index;       // Index of the timer in the slab.
+    uint32_t generation;  // Generation of the slab entry when the timer was scheduled.
+};
+
+/// A hierarchical timing wheel delivering messages to a MessageBuffer at their deadlines.
+///
+/// Time is cut into ticks of a configurable resolution. The wheel has four levels of 256 slots;
+/// a timer due within 256 ticks sits in the slot of its tick on the first level, and later ones
+/// sit on the level whose slots span their distance, moving down a level each time the level
+/// below wraps around. Timers live in a slab whose free entries are reused and are linked into
+/// their slot by index, so scheduling and cancelling take constant time and hold millions of
+/// timers without an allocation each. Timers further than 2^32 ticks away wait on the last level
+/// and are placed again each time it wraps around.
+///
+/// A single driver thread started with start() advances the wheel every tick and pushes the
+/// messages expired in that tick to the target buffer as one batch. Without it the wheel can be
+/// advanced by hand with advance(). Scheduling and cancelling may happen from any thread.
+template <typename T>
+class TimingWheel {
+   public:
+    using Clock = std::chrono::steady_clock;
+
+    /// Creates a wheel whose first tick starts now.
+    ///
+    /// Arguments:
+    ///     target: The buffer receiving the expired messages, which must outlive the wheel.
+    ///     tick: The resolution of the wheel.
+    ///
+    /// Throws:
+    ///     std::runtime_error if the tick is not positive.
+    explicit TimingWheel(MessageBuffer<T> &target,
+                         std::chrono::nanoseconds tick = std::chrono::milliseconds(1))
+        : target(target), tick(tick), _origin(Clock::now()) {
+        if (tick.count() <= 0) {
+            throw std::runtime_error("The tick of a timing wheel must be positive.");
+        }
+        heads.fill(NONE);
+    }
+
+    TimingWheel(const TimingWheel &) = delete;
+    TimingWheel &operator=(const TimingWheel &) = delete;
+
+    /// Stops the driver thread. Pending timers are dropped.
+    ~TimingWheel() { stop(); }
+
+    /// Schedules a message to be delivered at a deadline.
+    ///
+    /// A deadline already passed is delivered at the next tick.
+    ///
+    /// Arguments:
+    ///     deadline: When to deliver the message.
+    ///     message: The message to deliver.
+    ///
+    /// Returns:
+    ///     The handle of the timer.
+    TimerHandle schedule_at(Clock::time_point deadline, T &&message) {
+        const auto since_origin = deadline - _origin;
+        const uint64_t due =
+            since_origin.count() <= 0
+                ? 0
+                : static_cast<uint64_t>((since_origin + tick - Clock::duration(1)) / tick);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        uint32_t index;
+        if (free_entries.empty()) {
+            index = static_cast<uint32_t>(entries.size());
+            entries.emplace_back();
+        } else {
+            index = free_entries.back();
+            free_entries.pop_back();
+        }
+        Entry &entry = entries[index];
+        entry.message.emplace(std::move(message));
+        entry.due = std::max(due, current + 1);
+        link(index);
+        pending++;
+        return {index, entry.generation};
+    }
+
+    /// Schedules a message to be delivered after a delay.
+    ///
+    /// Arguments:
+    ///     delay: How long to wait before delivering the message.
+    ///     message: The message to deliver.
+    ///
+    /// Returns:
+    ///     The handle of the timer.
+    TimerHandle schedule_after(std::chrono::nanoseconds delay, T &&message) {
+        return schedule_at(Clock::now() + delay, std::move(message));
+    }
+
+    /// Cancels a timer.
+    ///
+    /// Arguments:
+    ///     handle: The handle of the timer.
+    ///
+    /// Returns:
+    ///     Whether the timer was pending, and its message is now dropped.
+    bool cancel(TimerHandle handle) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (handle.index >= entries.size() ||
+            entries[handle.index].generation != handle.generation ||
+            !entries[handle.index].message) {
+            return false;
+        }
+        unlink(handle.index);
+        free_entry(handle.index);
+        pending--;
+        return true;
+    }
+
+    /// Delivers the messages of every tick up to the specified time.
+    ///
+    /// Arguments:
+    ///     now: The time to advance to.
+    ///
+    /// Returns:
+    ///     The number of messages delivered, including ones the closed target refused.
+    std::size_t advance(Clock::time_point now) {
+        const auto since_origin = now - _origin;
+        if (since_origin.count() < 0) {
+            return 0;
+        }
+        const uint64_t last = static_cast<uint64_t>(since_origin / tick);
+        std::size_t delivered = 0;
+        std::unique_lock<std::mutex> lock(mutex);
+        while (current < last) {
+            skip_empty_ticks(last);
+            if (current < last) {
+                expire_next_tick();
+            }
+
+            // Deliver without holding the lock once caught up, or once the batch grows large.
+            if (!batch.empty() && (batch.size() >= MAX_BATCH || current == last)) {
+                delivered += batch.size();
+                std::vector<T> ready;
+                ready.swap(batch);
+                lock.unlock();
+                // A closed target leaves the batch as it was, so drop its messages here.
+                (void)target.push_batch(ready);
+                ready.clear();
+                lock.lock();
+                if (batch.empty() && batch.capacity() < ready.capacity()) {
+                    batch.swap(ready);
+                }
+            }
+        }
+        return delivered;
+    }
+
+    /// Starts the driver thread advancing the wheel every tick.
+    ///
+    /// Throws:
+    ///     std::runtime_error if the driver is already running.
+    void start() {
+        std::lock_guard<std::mutex> lock(driver_mutex);
+        if (driver.joinable()) {
+            throw std::runtime_error("The timing wheel driver is already running.");
+        }
+        stopping = false;
+        driver = std::thread([this]() { drive(); });
+    }
+
+    /// Stops the driver thread if it runs.
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(driver_mutex);
+            stopping = true;
+        }
+        wake_driver.notify_all();
+        if (driver.joinable()) {
+            driver.join();
+        }
+    }
+
+    // Getters.
+
+    /// Returns the number of pending timers.
+    std::size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return pending;
+    }
+
+    /// Returns the start of the first tick.
+    Clock::time_point origin() const { return _origin; }
+
+    /// Returns the resolution of the wheel.
+    std::chrono::nanoseconds resolution() const { return tick; }
+
+   private:
+    /// Bits of the slot index on each level.
+    static constexpr int SLOT_BITS = 8;
+
+    /// Number of slots on each level.
+    static constexpr uint64_t SLOTS = uint64_t{1} << SLOT_BITS;
+
+    /// Number of levels.
+    static constexpr int LEVELS = 4;
+
+    /// Index of no entry.
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    /// Largest number of messages delivered at once while catching up on many ticks.
+    static constexpr std::size_t MAX_BATCH = 4096;
+
+    /// A timer in the slab, linked into the list of its slot.
+    struct Entry {
+        std::optional<T> message;  // Message to deliver, empty while the entry is free.
+        uint64_t due = 0;          // Tick at which the message is delivered.
+        uint32_t generation = 0;   // Bumped each time the entry is freed.
+        uint32_t slot = 0;         // Slot whose list holds the entry.
+        uint32_t previous = NONE;  // Previous entry in the list of the slot.
+        uint32_t next = NONE;      // Next entry in the list of the slot.
+    };
+
+    /// Links an entry into the slot of its due tick relative to the current tick.
+    void link(uint32_t index) {
+        Entry &entry = entries[index];
+        const uint64_t distance = entry.due - current;
+        int level = 0;
+        while (level < LEVELS - 1 && distance >= (uint64_t{1} << (SLOT_BITS * (level + 1)))) {
+            level++;
+        }
+
+        // Beyond the last level, wait in the last slot it reaches before the due tick.
+        const uint64_t horizon = current + (uint64_t{1} << (SLOT_BITS * LEVELS)) - 1;
+        const uint64_t placed = std::min(entry.due, horizon);
+        const uint32_t slot =
+            static_cast<uint32_t>(level * SLOTS + ((placed >> (SLOT_BITS * level)) & (SLOTS - 1)));
+
+        entry.slot = slot;
+        level_sizes[level]++;
+        entry.previous = NONE;
+        entry.next = heads[slot];
+        if (heads[slot] != NONE) {
+            entries[heads[slot]].previous = index;
+        }
+        heads[slot] = index;
+    }
+
+    /// Unlinks an entry from the list of its slot.
+    void unlink(uint32_t index) {
+        Entry &entry = entries[index];
+        level_sizes[entry.slot / SLOTS]--;
+        if (entry.previous != NONE) {
+            entries[entry.previous].next = entry.next;
+        } else {
+            heads[entry.slot] = entry.next;
+        }
+        if (entry.next != NONE) {
+            entries[entry.next].previous = entry.previous;
+        }
+    }
+
+    /// Returns an entry to the slab, invalidating its handles.
+    void free_entry(uint32_t index) {
+        Entry &entry = entries[index];
+        entry.message.reset();
+        entry.generation++;
+        free_entries.push_back(index);
+    }
+
+    /// Moves the current tick forward, without going past the last tick, over the ticks in which
+    /// nothing expires or moves down a level: while the lowest levels hold no timer, only the
+    /// wrap around of the first level holding one matters.
+    void skip_empty_ticks(uint64_t last) {
+        int empty_levels = 0;
+        while (empty_levels < LEVELS && level_sizes[empty_levels] == 0) {
+            empty_levels++;
+        }
+        if (empty_levels == LEVELS) {
+            current = last;
+        } else if (empty_levels > 0) {
+            const uint64_t span = uint64_t{1} << (SLOT_BITS * empty_levels);
+            current = std::min(last, current | (span - 1));
+        }
+    }
+
+    /// Advances to the next tick, moving down the timers of the levels that wrap around and
+    /// moving the messages due in the tick to the batch.
+    void expire_next_tick() {
+        current++;
+        for (int level = 1; level < LEVELS; level++) {
+            if ((current & ((uint64_t{1} << (SLOT_BITS * level)) - 1)) != 0) {
+                break;
+            }
+            const uint32_t slot = static_cast<uint32_t>(
+                level * SLOTS + ((current >> (SLOT_BITS * level)) & (SLOTS - 1)));
+            uint32_t index = heads[slot];
+            heads[slot] = NONE;
+            while (index != NONE) {
+                const uint32_t next = entries[index].next;
+                level_sizes[level]--;
+                link(index);
+                index = next;
+            }
+        }
+
+        const uint32_t slot = static_cast<uint32_t>(current & (SLOTS - 1));
+        uint32_t index = heads[slot];
+        heads[slot] = NONE;
+        while (index != NONE) {
+            const uint32_t next = entries[index].next;
+            level_sizes[0]--;
+            batch.push_back(std::move(*entries[index].message));
+            free_entry(index);
+            pending--;
+            index = next;
+        }
+    }
+
+    /// Advances the wheel every tick until stopped.
+    void drive() {
+        std::unique_lock<std::mutex> lock(driver_mutex);
+        Clock::time_point next_tick = Clock::now() + tick;
+        while (!stopping) {
+            if (wake_driver.wait_until(lock, next_tick, [this] { return stopping; })) {
+                break;
+            }
+            lock.unlock();
+            advance(Clock::now());
+            lock.lock();
+            next_tick += tick;
+        }
+    }
+
+    MessageBuffer<T> &target;                       // Buffer receiving expired messages.
+    const std::chrono::nanoseconds tick;            // Resolution of the wheel.
+    const Clock::time_point _origin;                // Start of the first tick.
+
+    mutable std::mutex mutex;                       // Guards the wheel.
+    std::vector<Entry> entries;                     // Slab of timers.
+    std::vector<uint32_t> free_entries;             // Free entries of the slab.
+    std::array<uint32_t, LEVELS * SLOTS> heads;     // First entry of each slot.
+    std::array<std::size_t, LEVELS> level_sizes{};  // Number of timers on each level.
+    uint64_t current = 0;                           // Last tick expired.
+    std::size_t pending = 0;                        // Number of pending timers.
+    std::vector<T> batch;                           // Messages expired and not yet delivered.
+
+    std::mutex driver_mutex;                        // Guards the driver state.
+    std::condition_variable wake_driver;            // Wakes the driver to stop.
+    std::thread driver;                             // Driver thread.
+    bool stopping = false;                          // Whether the driver should stop.
+};
+
+}  // namespace ostp::libcc::data_structures
+
+#endif
@@ -0,0 +1,142 @@
+#include "timing_wheel.h"
+
+#include <chrono>
+#include <stdexcept>
+#include <vector>
+
+#include "logger.h"
+#include "message_buffer.h"
+#include "status.h"
+#include "testing.h"
+
+using ostp::libcc::data_structures::MessageBuffer;
+using ostp::libcc::data_structures::TimerHandle;
+using ostp::libcc::data_structures::TimingWheel;
+using ostp::libcc::utils::log_error;
+using ostp::libcc::utils::Status;
+using std::chrono::milliseconds;
+
+/// Returns the messages in the buffer without blocking.
+std::vector<int> drain(MessageBuffer<int> &buffer) {
+    std::vector<int> messages;
+    while (!buffer.empty()) {
+        messages.push_back(*buffer.pop());
+    }
+    return messages;
+}
+
+START_SUITE(TimingWheel_Tests)
+
+START_TEST(TimersExpireInOrderAcrossLevels) {
+    MessageBuffer<int> buffer;
+    TimingWheel<int> wheel(buffer, milliseconds(1));
+    const auto origin = wheel.origin();
+
+    // One timer on each level, and one past the range of the last level.
+    const std::vector<long> ticks = {5, 300, 70000, 20000000, 5000000000};
+    for (std::size_t i = ticks.size(); i-- > 0;) {
+        wheel.schedule_at(origin + milliseconds(ticks[i]), static_cast<int>(i));
+    }
+    TEST(wheel.size() == ticks.size());
+
+    // Each timer is delivered in the tick it is due, not before.
+    for (std::size_t i = 0; i < ticks.size(); i++) {
+        TEST(wheel.advance(origin + milliseconds(ticks[i] - 1)) == 0);
+        TEST(buffer.empty());
+        TEST(wheel.advance(origin + milliseconds(ticks[i])) == 1);
+        TEST(drain(buffer) == std::vector<int>{static_cast<int>(i)});
+    }
+    TEST(wheel.size() == 0);
+}
+END_TEST
+
+START_TEST(TimersOfATickAreDeliveredAsOneBatch) {
+    MessageBuffer<int> buffer;
+    TimingWheel<int> wheel(buffer, milliseconds(1));
+    const auto origin = wheel.origin();
+    for (int i = 0; i < 1000; i++) {
+        wheel.schedule_at(origin + milliseconds(1000 + i % 2), int(i));
+    }
+    TEST(wheel.advance(origin + milliseconds(1000)) == 500);
+    TEST(buffer.size().second == 500);
+    TEST(wheel.advance(origin + milliseconds(2000)) == 500);
+    TEST(buffer.size().second == 1000);
+}
+END_TEST
+
+START_TEST(CancelledTimersAreNotDelivered) {
+    MessageBuffer<int> buffer;
+    TimingWheel<int> wheel(buffer, milliseconds(1));
+    const auto origin = wheel.origin();
+    const TimerHandle first = wheel.schedule_at(origin + milliseconds(10), 1);
+    const TimerHandle second = wheel.schedule_at(origin + milliseconds(10), 2);
+    const TimerHandle third = wheel.schedule_at(origin + milliseconds(100000), 3);
+    TEST(wheel.cancel(first));
+    TEST(!wheel.cancel(first));
+    TEST(wheel.cancel(third));
+    TEST(wheel.size() == 1);
+
+    // A reused entry does not answer to the handle of its previous timer.
+    const TimerHandle fourth = wheel.schedule_at(origin + milliseconds(20), 4);
+    TEST(fourth.index == third.index);
+    TEST(!wheel.cancel(third));
+
+    wheel.advance(origin + milliseconds(100000));
+    TEST((drain(buffer) == std::vector<int>{2, 4}));
+    TEST(!wheel.cancel(second));
+    TEST(!wheel.cancel({1000, 0}));
+}
+END_TEST
+
+START_TEST(PastDeadlinesExpireAtTheNextTick) {
+    MessageBuffer<int> buffer;
+    TimingWheel<int> wheel(buffer, milliseconds(1));
+    const auto origin = wheel.origin();
+    wheel.advance(origin + milliseconds(50));
+    wheel.schedule_at(origin - milliseconds(10), 1);
+    wheel.schedule_at(origin + milliseconds(20), 2);
+    TEST(wheel.advance(origin + milliseconds(50)) == 0);
+    TEST(wheel.advance(origin + milliseconds(51)) == 2);
+    TEST(buffer.size().second == 2);
+}
+END_TEST
+
+START_TEST(DriverDeliversToWaitingConsumers) {
+    MessageBuffer<int> buffer;
+    TimingWheel<int> wheel(buffer, milliseconds(1));
+    wheel.start();
+    const auto begin = TimingWheel<int>::Clock::now();
+    wheel.schedule_after(milliseconds(20), 7);
+    auto message = buffer.pop(5000);
+    ASSERT(message.ok());
+    TEST(*message == 7);
+    TEST(TimingWheel<int>::Clock::now() - begin >= milliseconds(20));
+
+    bool thrown = false;
+    try {
+        wheel.start();
+    } catch (const std::runtime_error &) {
+        thrown = true;
+    }
+    TEST(thrown);
+    wheel.stop();
+}
+END_TEST
+
+START_TEST(ClosedTargetDropsExpiredMessages) {
+    MessageBuffer<int> buffer;
+    TimingWheel<int> wheel(buffer, milliseconds(1));
+    wheel.schedule_at(wheel.origin() + milliseconds(3), 1);
+    wheel.schedule_at(wheel.origin() + milliseconds(5), 2);
+    buffer.close();
+    TEST(wheel.advance(wheel.origin() + milliseconds(3)) == 1);
+
+    // Refused messages are not delivered again by later advances.
+    TEST(wheel.advance(wheel.origin() + milliseconds(5)) == 1);
+    TEST(wheel.advance(wheel.origin() + milliseconds(7)) == 0);
+    TEST(wheel.size() == 0);
+    TEST(buffer.pop().status() == Status::CLOSED);
+}
+END_TEST
+
+END_SUITE
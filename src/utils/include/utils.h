@@ -1,9 +1,12 @@
 #ifndef UTILS_H
 #define UTILS_H
 
+#include "benchmarking.h"
 #include "logger.h"
+#include "metrics.h"
 #include "status_or.h"
 #include "status.h"
 #include "testing.h"
+#include "tracing.h"
 
 #endif
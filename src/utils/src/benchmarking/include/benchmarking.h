@@ -0,0 +1,362 @@
+#ifndef LIBCC_BENCHMARKING_H
+#define LIBCC_BENCHMARKING_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "logger.h"
+
+namespace ostp::libcc::utils {
+
+/// Prevents the compiler from optimizing away the computation of the specified value.
+template <typename T>
+inline void do_not_optimize(T const &value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+/// Prevents the compiler from optimizing away the specified value and assuming it is unchanged.
+template <typename T>
+    requires(!std::is_const_v<T> && std::is_trivially_copyable_v<T>)
+inline void do_not_optimize(T &value) {
+    asm volatile("" : "+r,m"(value) : : "memory");
+}
+
+/// Forces every pending write to memory to be considered observable.
+inline void clobber_memory() { asm volatile("" : : : "memory"); }
+
+/// Hardware counters of the calling thread read through perf_event_open.
+///
+/// Counting is unavailable on platforms other than Linux and when the kernel denies access, in
+/// which case available() is false and every counter reads zero.
+class PerfCounters {
+   public:
+    /// Number of counters read.
+    static constexpr int COUNT = 4;
+
+    /// Names of the counters in the order they are read.
+    static constexpr const char *NAMES[COUNT] = {"cycles", "instructions", "cache_misses",
+                                                 "branch_misses"};
+
+    /// Opens the counters.
+    PerfCounters() {
+#ifdef __linux__
+        const uint64_t configs[COUNT] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+                                         PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+        for (int i = 0; i < COUNT; i++) {
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.size = sizeof(attr);
+            attr.config = configs[i];
+            attr.disabled = i == 0;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_GROUP;
+            _fds[i] = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1,
+                                               i == 0 ? -1 : _fds[0], 0));
+            if (_fds[i] < 0) {
+                close_all();
+                return;
+            }
+        }
+#endif
+    }
+
+    /// Closes the counters.
+    ~PerfCounters() { close_all(); }
+
+    PerfCounters(const PerfCounters &) = delete;
+    PerfCounters &operator=(const PerfCounters &) = delete;
+
+    /// Returns whether the counters could be opened.
+    bool available() const { return _fds[0] >= 0; }
+
+    /// Resets and starts counting.
+    void start() {
+#ifdef __linux__
+        if (available()) {
+            ioctl(_fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+            ioctl(_fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        }
+#endif
+    }
+
+    /// Stops counting and reads the counters.
+    ///
+    /// Arguments:
+    ///     values: array of COUNT values to write the counters to.
+    void stop(uint64_t *values) {
+        std::fill(values, values + COUNT, 0);
+#ifdef __linux__
+        if (available()) {
+            ioctl(_fds[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+            uint64_t data[COUNT + 1];
+            if (read(_fds[0], data, sizeof(data)) == static_cast<ssize_t>(sizeof(data))) {
+                std::copy(data + 1, data + 1 + COUNT, values);
+            }
+        }
+#endif
+    }
+
+   private:
+    /// Closes every open counter.
+    void close_all() {
+#ifdef __linux__
+        for (int &fd : _fds) {
+            if (fd >= 0) {
+                close(fd);
+            }
+            fd = -1;
+        }
+#endif
+    }
+
+    int _fds[COUNT] = {-1, -1, -1, -1};  // Descriptors of the counters, the first leads the group.
+};
+
+/// Statistics of one benchmark.
+struct BenchmarkResult {
+    /// Name of the benchmark.
+    std::string name;
+
+    /// Number of iterations timed in each sample.
+    uint64_t iterations;
+
+    /// Number of samples.
+    int samples;
+
+    /// Mean, median, 99th percentile, minimum and maximum time per iteration in nanoseconds
+    /// across the samples.
+    double mean_ns, median_ns, p99_ns, min_ns, max_ns;
+
+    /// Iterations per second derived from the mean.
+    double ops_per_sec;
+
+    /// Whether the hardware counters were read.
+    bool has_counters;
+
+    /// Hardware counters per iteration in the order of PerfCounters::NAMES.
+    double counters[PerfCounters::COUNT];
+};
+
+/// Runs benchmarks and reports their statistics.
+///
+/// Each benchmark body receives a number of iterations to run. The suite first calibrates that
+/// number until one call takes at least the minimum sample time, runs warm-up calls and then
+/// times the configured number of samples. Results are logged and, if requested, appended as
+/// JSON lines to a file so they can be compared across runs.
+///
+/// Command line options:
+///     --filter=<text>      only runs the benchmarks whose name contains the text.
+///     --json=<path>        appends one JSON object per benchmark to the file.
+///     --samples=<n>        number of timed samples (default 50).
+///     --min-time-ms=<n>    minimum duration of a sample in milliseconds (default 5).
+///     --perf               reads hardware counters through perf_event_open.
+class BenchmarkSuite {
+   public:
+    /// Constructs a suite parsing its options from the command line.
+    ///
+    /// Arguments:
+    ///     name: the name of the suite.
+    ///     argc: the number of command line arguments.
+    ///     argv: the command line arguments.
+    BenchmarkSuite(std::string name, int argc, char **argv) : _name(std::move(name)) {
+        for (int i = 1; i < argc; i++) {
+            std::string_view arg(argv[i]);
+            if (arg.starts_with("--filter=")) {
+                _filter = arg.substr(9);
+            } else if (arg.starts_with("--json=")) {
+                _json_path = arg.substr(7);
+            } else if (arg.starts_with("--samples=")) {
+                _samples = std::max(1, std::atoi(argv[i] + 10));
+            } else if (arg.starts_with("--min-time-ms=")) {
+                _min_sample_time = std::chrono::milliseconds(std::atoi(argv[i] + 14));
+            } else if (arg == "--perf") {
+                _perf = true;
+            }
+        }
+    }
+
+    /// Runs a benchmark unless it is filtered out.
+    ///
+    /// Arguments:
+    ///     name: the name of the benchmark.
+    ///     body: callable taking the number of iterations to run as a uint64_t.
+    template <typename F>
+    void run(const std::string &name, F &&body) {
+        if (!_filter.empty() && name.find(_filter) == std::string::npos) {
+            return;
+        }
+
+        // Calibrate the number of iterations of a sample, which also warms up caches.
+        uint64_t iterations = 1;
+        while (time(body, iterations) < _min_sample_time && iterations < (uint64_t{1} << 40)) {
+            iterations *= 2;
+        }
+        for (int i = 0; i < WARMUP_SAMPLES; i++) {
+            time(body, iterations);
+        }
+
+        // Time the samples, reading the counters around all of them.
+        PerfCounters counters_reader;
+        const bool has_counters = _perf && counters_reader.available();
+        uint64_t counters[PerfCounters::COUNT];
+        std::vector<double> per_op(_samples);
+        if (has_counters) {
+            counters_reader.start();
+        }
+        for (double &sample : per_op) {
+            sample = std::chrono::duration<double, std::nano>(time(body, iterations)).count() /
+                     iterations;
+        }
+        counters_reader.stop(counters);
+
+        BenchmarkResult result{name, iterations, _samples, 0, 0, 0, 0, 0, 0, has_counters, {}};
+        std::sort(per_op.begin(), per_op.end());
+        for (double sample : per_op) {
+            result.mean_ns += sample / per_op.size();
+        }
+        result.median_ns = per_op[per_op.size() / 2];
+        result.p99_ns = per_op[std::min(per_op.size() - 1, per_op.size() * 99 / 100)];
+        result.min_ns = per_op.front();
+        result.max_ns = per_op.back();
+        result.ops_per_sec = result.mean_ns > 0 ? 1e9 / result.mean_ns : 0;
+        for (int i = 0; i < PerfCounters::COUNT; i++) {
+            result.counters[i] = static_cast<double>(counters[i]) / (iterations * _samples);
+        }
+        report(result);
+        _results.push_back(std::move(result));
+    }
+
+    /// Returns the results of the benchmarks run so far.
+    const std::vector<BenchmarkResult> &results() const { return _results; }
+
+    /// Writes the machine-readable results if requested.
+    ///
+    /// Returns:
+    ///     the exit code of the benchmark program.
+    int finish() {
+        if (_json_path.empty()) {
+            return 0;
+        }
+        FILE *file = fopen(_json_path.c_str(), "a");
+        if (file == nullptr) {
+            LOG_ERROR(_name, "Cannot open {}", _json_path);
+            return 1;
+        }
+        for (const BenchmarkResult &result : _results) {
+            fprintf(file,
+                    "{\"suite\":\"%s\",\"name\":\"%s\",\"iterations\":%llu,\"samples\":%d,"
+                    "\"mean_ns\":%.3f,\"median_ns\":%.3f,\"p99_ns\":%.3f,\"min_ns\":%.3f,"
+                    "\"max_ns\":%.3f,\"ops_per_sec\":%.1f",
+                    json_escape(_name).c_str(), json_escape(result.name).c_str(),
+                    static_cast<unsigned long long>(result.iterations), result.samples,
+                    result.mean_ns, result.median_ns, result.p99_ns, result.min_ns, result.max_ns,
+                    result.ops_per_sec);
+            if (result.has_counters) {
+                for (int i = 0; i < PerfCounters::COUNT; i++) {
+                    fprintf(file, ",\"%s_per_op\":%.3f", PerfCounters::NAMES[i],
+                            result.counters[i]);
+                }
+            }
+            fprintf(file, "}\n");
+        }
+        fclose(file);
+        return 0;
+    }
+
+   private:
+    /// Number of untimed calls after calibration.
+    static constexpr int WARMUP_SAMPLES = 3;
+
+    /// Times one call of the body.
+    template <typename F>
+    static std::chrono::nanoseconds time(F &body, uint64_t iterations) {
+        const auto start = std::chrono::steady_clock::now();
+        body(iterations);
+        clobber_memory();
+        return std::chrono::steady_clock::now() - start;
+    }
+
+    /// Escapes quotes, backslashes and control characters for a JSON string.
+    static std::string json_escape(std::string_view text) {
+        std::string escaped;
+        escaped.reserve(text.size());
+        for (char c : text) {
+            if (c == '"' || c == '\\') {
+                escaped += '\\';
+                escaped += c;
+            } else if (static_cast<unsigned char>(c) < 0x20) {
+                char code[7];
+                snprintf(code, sizeof(code), "\\u%04x", static_cast<unsigned char>(c));
+                escaped += code;
+            } else {
+                escaped += c;
+            }
+        }
+        return escaped;
+    }
+
+        /// Rounds a statistic to two decimals for display.
+    static double round2(double value) { return std::round(value * 100) / 100; }
+
+    /// Logs the statistics of a benchmark.
+    void report(const BenchmarkResult &result) {
+        LOG_INFO(_name, "{}: mean {} ns, median {} ns, p99 {} ns, {} ops/s", result.name,
+                 round2(result.mean_ns), round2(result.median_ns), round2(result.p99_ns),
+                 static_cast<uint64_t>(result.ops_per_sec), kv("iterations", result.iterations));
+        if (result.has_counters) {
+            LOG_INFO(_name, "{}: per op", result.name, kv("cycles", round2(result.counters[0])),
+                     kv("instructions", round2(result.counters[1])),
+                     kv("cache_misses", round2(result.counters[2])),
+                     kv("branch_misses", round2(result.counters[3])));
+        }
+    }
+
+    std::string _name;                                          // Name of the suite.
+    std::string _filter;                                        // Filter on benchmark names.
+    std::string _json_path;                                     // Machine-readable output.
+    int _samples = 50;                                          // Timed samples per benchmark.
+    std::chrono::nanoseconds _min_sample_time = std::chrono::milliseconds(5);  // Sample length.
+    bool _perf = false;                                         // Whether to read counters.
+    std::vector<BenchmarkResult> _results;                      // Results so far.
+};
+
+}  // namespace ostp::libcc::utils
+
+/// Starts a benchmark program named after the suite; setup code may follow.
+#define START_BENCH_SUITE(name)       \
+    int main(int argc, char **argv) { \
+        ostp::libcc::utils::BenchmarkSuite _bench_suite(#name, argc, argv);
+
+/// Starts a benchmark whose body runs _iterations iterations, usually through BENCH_LOOP.
+#define START_BENCH(name) _bench_suite.run(#name, [&](uint64_t _iterations)
+
+/// Loops over the iterations of a benchmark with the index in _iteration.
+#define BENCH_LOOP for (uint64_t _iteration = 0; _iteration < _iterations; _iteration++)
+
+/// Ends a benchmark.
+#define END_BENCH );
+
+/// Ends the benchmark program, writing the machine-readable results if requested.
+#define END_BENCH_SUITE           \
+    return _bench_suite.finish(); \
+    }
+
+#endif
@@ -0,0 +1,66 @@
+#include <unistd.h>
+
+#include <chrono>
+#include <memory>
+#include <string>
+
+#include "benchmarking.h"
+#include "log_sink.h"
+#include "logger.h"
+
+using ostp::libcc::utils::ConsoleSink;
+using ostp::libcc::utils::FileSink;
+using ostp::libcc::utils::kv;
+using ostp::libcc::utils::LogSink;
+using ostp::libcc::utils::MemorySink;
+using ostp::libcc::utils::MmapFileSink;
+using ostp::libcc::utils::RotatingFileSink;
+
+const std::string path = "/tmp/logger_bench_" + std::to_string(getpid());
+
+/// Logs the specified number of lines through a sink and restores the console for the report.
+void log_lines(const std::shared_ptr<LogSink> &sink, uint64_t lines) {
+    ostp::libcc::utils::set_log_sinks({sink});
+    for (uint64_t i = 0; i < lines; i++) {
+        LOG_INFO("bench", "line {} of the benchmark", i, kv("sink", "bench"));
+    }
+    ostp::libcc::utils::flush_logs();
+    ostp::libcc::utils::set_log_sinks({std::make_shared<ConsoleSink>()});
+}
+
+START_BENCH_SUITE(Logger)
+
+auto memory = std::make_shared<MemorySink>(4096);
+auto file = std::make_shared<FileSink>(path + "_file");
+auto rotating =
+    std::make_shared<RotatingFileSink>(path + "_rotating", 16 << 20, std::chrono::seconds(0), 1);
+auto mmap = std::make_shared<MmapFileSink>(path + "_mmap");
+
+START_BENCH(MemorySink) { log_lines(memory, _iterations); }
+END_BENCH
+
+START_BENCH(FileSink) { log_lines(file, _iterations); }
+END_BENCH
+
+START_BENCH(RotatingFileSink) { log_lines(rotating, _iterations); }
+END_BENCH
+
+START_BENCH(MmapFileSink) { log_lines(mmap, _iterations); }
+END_BENCH
+
+START_BENCH(DisabledLevel) {
+    ostp::libcc::utils::set_log_level(ostp::libcc::utils::LogLevel::WARN);
+    BENCH_LOOP { LOG_INFO("bench", "filtered line {}", _iteration); }
+    ostp::libcc::utils::set_log_level(ostp::libcc::utils::LogLevel::INFO);
+}
+END_BENCH
+
+memory.reset();
+file.reset();
+rotating.reset();
+mmap.reset();
+for (const char *suffix : {"_file", "_rotating", "_rotating.1", "_mmap"}) {
+    unlink((path + suffix).c_str());
+}
+
+END_BENCH_SUITE
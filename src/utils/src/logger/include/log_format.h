@@ -0,0 +1,283 @@
+#ifndef LOG_FORMAT_H
+#define LOG_FORMAT_H
+
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace ostp::libcc::utils
+{
+    /// Key-value pair attached to a log message.
+    ///
+    /// Fields only reference their key and string values so they must not outlive the log call
+    /// they are passed to.
+    struct LogField
+    {
+        /// Type of the value of a field.
+        enum class Type : uint8_t
+        {
+            INT,
+            UINT,
+            DOUBLE,
+            BOOL,
+            STRING
+        };
+
+        /// Key of the field.
+        std::string_view key;
+
+        /// Type of the value of the field.
+        Type type;
+
+        /// Value of the field for the numeric and boolean types.
+        union
+        {
+            int64_t i;
+            uint64_t u;
+            double d;
+            bool b;
+        };
+
+        /// Value of the field for the string type.
+        std::string_view s;
+    };
+
+    /// Creates a field with the specified key and value.
+    ///
+    /// Arguments:
+    ///     key: the key of the field.
+    ///     value: an integer, floating point, boolean or string value.
+    ///
+    /// Returns:
+    ///     the field.
+    template <typename T>
+    LogField kv(std::string_view key, const T &value)
+    {
+        LogField field{key, LogField::Type::INT, {}, {}};
+        if constexpr (std::is_same_v<T, bool>)
+        {
+            field.type = LogField::Type::BOOL;
+            field.b = value;
+        }
+        else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>)
+        {
+            field.type = LogField::Type::INT;
+            field.i = value;
+        }
+        else if constexpr (std::is_integral_v<T>)
+        {
+            field.type = LogField::Type::UINT;
+            field.u = value;
+        }
+        else if constexpr (std::is_floating_point_v<T>)
+        {
+            field.type = LogField::Type::DOUBLE;
+            field.d = value;
+        }
+        else
+        {
+            static_assert(std::is_convertible_v<const T &, std::string_view>,
+                          "Field values must be integers, floating points, booleans or strings");
+            field.type = LogField::Type::STRING;
+            field.s = std::string_view(value);
+        }
+        return field;
+    }
+
+    /// Fixed-capacity character buffer that silently truncates what does not fit.
+    class FormatBuffer
+    {
+    public:
+        /// Constructs a buffer writing into the specified storage.
+        ///
+        /// Arguments:
+        ///     data: the storage of the buffer.
+        ///     capacity: the size of the storage.
+        FormatBuffer(char *data, std::size_t capacity) : _data(data), _capacity(capacity) {}
+
+        /// Appends the specified characters.
+        void append(const char *data, std::size_t len)
+        {
+            if (len > _capacity - _len)
+            {
+                len = _capacity - _len;
+            }
+            std::memcpy(_data + _len, data, len);
+            _len += len;
+        }
+
+        /// Appends the specified string.
+        void append(std::string_view str) { append(str.data(), str.size()); }
+
+        /// Appends the specified character.
+        void append(char c)
+        {
+            if (_len < _capacity)
+            {
+                _data[_len++] = c;
+            }
+        }
+
+        /// Returns the written characters.
+        std::string_view view() const { return std::string_view(_data, _len); }
+
+    private:
+        char *_data;           // Storage of the buffer.
+        std::size_t _capacity; // Size of the storage.
+        std::size_t _len = 0;  // Number of characters written.
+    };
+
+    namespace log_format_internal
+    {
+        /// Appends the result of std::to_chars for the specified value.
+        template <typename T>
+        void append_chars(FormatBuffer &out, T value)
+        {
+            char digits[32];
+            auto [end, error] = std::to_chars(digits, digits + sizeof(digits), value);
+            if (error == std::errc())
+            {
+                out.append(digits, end - digits);
+            }
+        }
+
+        /// Appends the textual representation of a format argument.
+        template <typename T>
+        void append_arg(FormatBuffer &out, const T &arg)
+        {
+            if constexpr (std::is_same_v<T, bool>)
+            {
+                out.append(arg ? std::string_view("true") : std::string_view("false"));
+            }
+            else if constexpr (std::is_same_v<T, char>)
+            {
+                out.append(arg);
+            }
+            else if constexpr (std::is_arithmetic_v<T>)
+            {
+                append_chars(out, arg);
+            }
+            else if constexpr (std::is_convertible_v<const T &, const char *>)
+            {
+                const char *str = arg;
+                out.append(str == nullptr ? std::string_view("(null)") : std::string_view(str));
+            }
+            else if constexpr (std::is_convertible_v<const T &, std::string_view>)
+            {
+                out.append(std::string_view(arg));
+            }
+            else if constexpr (std::is_pointer_v<T>)
+            {
+                out.append("0x", 2);
+                char digits[16];
+                auto [end, error] = std::to_chars(digits, digits + sizeof(digits),
+                                                  reinterpret_cast<uintptr_t>(arg), 16);
+                out.append(digits, end - digits);
+            }
+            else
+            {
+                static_assert(std::is_arithmetic_v<T>,
+                              "Format arguments must be arithmetic, strings or pointers");
+            }
+        }
+
+        /// Copies the format string from the specified position to the next placeholder.
+        ///
+        /// "{{" and "}}" are written as single braces.
+        ///
+        /// Arguments:
+        ///     out: the buffer to write to.
+        ///     fmt: the format of the message.
+        ///     pos: the position to start copying from.
+        ///     found: set to whether a placeholder was reached.
+        ///
+        /// Returns:
+        ///     the position after the placeholder or the size of the format if there is none.
+        inline std::size_t append_until_placeholder(FormatBuffer &out, std::string_view fmt,
+                                                    std::size_t pos, bool &found)
+        {
+            found = false;
+            while (pos < fmt.size())
+            {
+                const char c = fmt[pos];
+                if ((c == '{' || c == '}') && pos + 1 < fmt.size() && fmt[pos + 1] == c)
+                {
+                    out.append(c);
+                    pos += 2;
+                }
+                else if (c == '{' && pos + 1 < fmt.size() && fmt[pos + 1] == '}')
+                {
+                    found = true;
+                    return pos + 2;
+                }
+                else
+                {
+                    out.append(c);
+                    pos++;
+                }
+            }
+            return pos;
+        }
+
+        /// Consumes one argument as either a field or the value of the next placeholder.
+        template <typename T>
+        void consume(FormatBuffer &out, LogField *fields, std::size_t &field_count,
+                     std::string_view fmt, std::size_t &pos, const T &arg)
+        {
+            if constexpr (std::is_same_v<T, LogField>)
+            {
+                fields[field_count++] = arg;
+            }
+            else if (pos < fmt.size())
+            {
+                bool found;
+                pos = append_until_placeholder(out, fmt, pos, found);
+                if (found)
+                {
+                    append_arg(out, arg);
+                }
+            }
+        }
+
+    } // namespace log_format_internal
+
+    /// Formats a message replacing each "{}" in the format with the next argument.
+    ///
+    /// Arguments of type LogField are not formatted and are collected as fields instead.
+    /// Arguments beyond the placeholders are ignored and placeholders beyond the arguments are
+    /// written verbatim. Nothing is allocated: the output is truncated to the buffer capacity.
+    ///
+    /// Arguments:
+    ///     out: the buffer to write the message to.
+    ///     fields: storage for at least as many fields as arguments.
+    ///     fmt: the format of the message.
+    ///     args: the arguments and fields of the message.
+    ///
+    /// Returns:
+    ///     the number of fields collected.
+    template <typename... Args>
+    std::size_t format_message(FormatBuffer &out, [[maybe_unused]] LogField *fields,
+                               std::string_view fmt, const Args &...args)
+    {
+        std::size_t field_count = 0;
+        std::size_t pos = 0;
+        (log_format_internal::consume(out, fields, field_count, fmt, pos, args), ...);
+        while (pos < fmt.size())
+        {
+            bool found;
+            pos = log_format_internal::append_until_placeholder(out, fmt, pos, found);
+            if (found)
+            {
+                out.append("{}", 2);
+            }
+        }
+        return field_count;
+    }
+
+} // namespace ostp::libcc::utils
+
+#endif
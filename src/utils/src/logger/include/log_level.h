@@ -0,0 +1,36 @@
+#ifndef LOG_LEVEL_H
+#define LOG_LEVEL_H
+
+#include <cstdint>
+
+// Minimum level compiled into the log macros. Statements below it are removed at compile time
+// together with the evaluation of their arguments. 0 keeps every level and 4 removes them all.
+#ifndef LOG_MIN_LEVEL
+#define LOG_MIN_LEVEL 0
+#endif
+
+namespace ostp::libcc::utils
+{
+    /// Severity of a log message in increasing order.
+    enum class LogLevel : uint8_t
+    {
+        INFO = 0,
+        OK = 1,
+        WARN = 2,
+        ERROR = 3
+    };
+
+    /// Returns whether messages of the specified level survive the compile-time filter.
+    constexpr bool log_compiled([[maybe_unused]] LogLevel level)
+    {
+#if LOG_MIN_LEVEL == 0
+        // Comparing would always be true, which compilers warn about.
+        return true;
+#else
+        return static_cast<int>(level) >= LOG_MIN_LEVEL;
+#endif
+    }
+
+} // namespace ostp::libcc::utils
+
+#endif
@@ -0,0 +1,260 @@
+#ifndef LOG_SINK_H
+#define LOG_SINK_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "log_level.h"
+
+namespace ostp::libcc::utils
+{
+    /// Output format of a log sink.
+    enum class LogFormat
+    {
+        /// "[sender] message key=value" lines.
+        TEXT,
+
+        /// One JSON object per line with the level, sender, message and fields as members.
+        JSON_LINES
+    };
+
+    /// Destination of log lines.
+    ///
+    /// The logger renders each message in the format of every sink, with the ANSI color of its
+    /// level if the sink asks for it, and hands the line to write(). Sinks may be called from
+    /// several threads at once and must synchronize themselves. After writing a batch of lines
+    /// the asynchronous logger calls flush(). Records pending when the process crashes go to
+    /// write_from_signal() instead.
+    class LogSink
+    {
+    public:
+        /// Constructs a sink.
+        ///
+        /// Arguments:
+        ///     format: the format of the lines written to the sink.
+        ///     colored: whether text lines are wrapped in the color of their level.
+        LogSink(LogFormat format, bool colored) : _format(format), _colored(colored) {}
+
+        /// Destructor.
+        virtual ~LogSink() = default;
+
+        /// Writes a rendered line, terminated by a new line.
+        ///
+        /// Arguments:
+        ///     level: the level of the message.
+        ///     line: the rendered message.
+        virtual void write(LogLevel level, std::string_view line) = 0;
+
+        /// Makes every written line durable or visible.
+        virtual void flush() = 0;
+
+        /// Writes a rendered line from a fatal signal handler.
+        ///
+        /// Must not block, allocate or use stdio, so a sink busy in another call drops the line.
+        /// The default drops every line.
+        ///
+        /// Arguments:
+        ///     level: the level of the message.
+        ///     line: the rendered message.
+        virtual void write_from_signal(LogLevel, std::string_view) {}
+
+        /// Returns the format of the lines written to the sink.
+        LogFormat format() const { return _format; }
+
+        /// Returns whether text lines are wrapped in the color of their level.
+        bool colored() const { return _colored; }
+
+    private:
+        const LogFormat _format; // Format of the lines written to the sink.
+        const bool _colored;     // Whether text lines are colored.
+    };
+
+    /// Sink writing each level to its console stream: INFO and OK messages to INFO_STREAM, WARN
+    /// messages to WARN_STREAM and ERROR messages to ERROR_STREAM.
+    ///
+    /// This is the sink the logger starts with.
+    class ConsoleSink : public LogSink
+    {
+    public:
+        /// Constructs a console sink.
+        ///
+        /// Arguments:
+        ///     format: the format of the lines.
+        ///     colored: whether text lines are wrapped in the color of their level.
+        explicit ConsoleSink(LogFormat format = LogFormat::TEXT, bool colored = true);
+
+        void write(LogLevel level, std::string_view line) override;
+        void flush() override;
+
+        /// Writes straight to the descriptor of the stream, bypassing its buffer.
+        void write_from_signal(LogLevel level, std::string_view line) override;
+
+    private:
+        int _fds[4]; // Descriptor of the stream of each level, looked up once.
+    };
+
+    /// Sink appending to a file through a user-space buffer.
+    ///
+    /// Lines are written to the file when the buffer fills up, on flush() and on destruction.
+    class FileSink : public LogSink
+    {
+    public:
+        /// Opens the specified file for appending.
+        ///
+        /// Arguments:
+        ///     path: the path of the file.
+        ///     format: the format of the lines.
+        ///     colored: whether text lines are wrapped in the color of their level.
+        ///     buffer_size: the number of bytes buffered before writing to the file.
+        ///
+        /// Throws:
+        ///     std::runtime_error if the file cannot be opened.
+        explicit FileSink(const std::string &path, LogFormat format = LogFormat::TEXT,
+                          bool colored = false, std::size_t buffer_size = 1 << 16);
+
+        /// Writes the buffered lines and closes the file.
+        ~FileSink() override;
+
+        void write(LogLevel level, std::string_view line) override;
+        void flush() override;
+
+        /// Writes the buffered lines and the line to the file unless another call holds the
+        /// mutex. A rotating file is not rotated.
+        void write_from_signal(LogLevel level, std::string_view line) override;
+
+    protected:
+        /// Writes the buffered lines to the file. The caller must hold the mutex.
+        void flush_locked();
+
+        std::mutex _mutex;         // Guards the buffer and the file.
+        int _fd;                   // Descriptor of the file.
+        std::vector<char> _buffer; // Lines not yet written to the file.
+        std::size_t _buffered = 0; // Number of bytes used in the buffer.
+    };
+
+    /// Sink appending to a file that is rotated when it grows past a size or an age.
+    ///
+    /// On rotation the current file is renamed to "<path>.1", the previous "<path>.1" to
+    /// "<path>.2" and so on; the oldest file beyond max_files is deleted.
+    class RotatingFileSink : public FileSink
+    {
+    public:
+        /// Opens the specified file for appending.
+        ///
+        /// Arguments:
+        ///     path: the path of the file.
+        ///     max_bytes: the size after which the file is rotated, or 0 for no limit.
+        ///     max_age: the age after which the file is rotated, or 0 for no limit.
+        ///     max_files: the number of rotated files kept besides the current one.
+        ///     format: the format of the lines.
+        ///     colored: whether text lines are wrapped in the color of their level.
+        ///
+        /// Throws:
+        ///     std::runtime_error if the file cannot be opened.
+        RotatingFileSink(const std::string &path, std::size_t max_bytes,
+                         std::chrono::seconds max_age = std::chrono::seconds(0),
+                         int max_files = 5, LogFormat format = LogFormat::TEXT,
+                         bool colored = false);
+
+        void write(LogLevel level, std::string_view line) override;
+
+    private:
+        /// Renames the files and opens a new one, writing on to the renamed file if that fails.
+        /// The caller must hold the mutex.
+        void rotate_locked();
+
+        const std::string _path;                        // Path of the current file.
+        const std::size_t _max_bytes;                   // Size that triggers a rotation.
+        const std::chrono::seconds _max_age;            // Age that triggers a rotation.
+        const int _max_files;                           // Number of rotated files kept.
+        std::size_t _file_bytes;                        // Size of the current file.
+        std::chrono::steady_clock::time_point _opened; // When the current file was opened.
+    };
+
+    /// Sink appending to a memory-mapped file.
+    ///
+    /// Lines are copied into a shared mapping of the file so writing them takes no system call;
+    /// the mapping grows by a fixed chunk when it fills up and the file is truncated to the
+    /// written size on destruction. Lines that do not fit because the mapping cannot grow are
+    /// dropped, reporting the first failure to ERROR_STREAM.
+    class MmapFileSink : public LogSink
+    {
+    public:
+        /// Creates or truncates the specified file and maps its first chunk.
+        ///
+        /// Arguments:
+        ///     path: the path of the file.
+        ///     chunk_size: the number of bytes the mapping grows by.
+        ///     format: the format of the lines.
+        ///     colored: whether text lines are wrapped in the color of their level.
+        ///
+        /// Throws:
+        ///     std::runtime_error if the chunk size is 0 or the file cannot be created or mapped.
+        explicit MmapFileSink(const std::string &path, std::size_t chunk_size = 1 << 24,
+                              LogFormat format = LogFormat::TEXT, bool colored = false);
+
+        /// Unmaps the file and truncates it to the written size.
+        ~MmapFileSink() override;
+
+        void write(LogLevel level, std::string_view line) override;
+
+        /// Schedules the write-back of the mapping without waiting for it.
+        void flush() override;
+
+        /// Copies the line into the mapping unless another call holds the mutex or the mapping
+        /// has no room left for it.
+        void write_from_signal(LogLevel level, std::string_view line) override;
+
+    private:
+        /// Extends the file and the mapping to hold at least the specified size, leaving them as
+        /// they were if that fails. The caller must hold the mutex.
+        ///
+        /// Returns:
+        ///     0 if the mapping holds the size, or the errno of the failed call.
+        int grow_locked(std::size_t size);
+
+        std::mutex _mutex;          // Guards the mapping.
+        int _fd;                    // Descriptor of the file.
+        const std::size_t _chunk;   // Number of bytes the mapping grows by.
+        char *_data = nullptr;      // Start of the mapping.
+        std::size_t _mapped = 0;    // Size of the mapping.
+        std::size_t _written = 0;   // Number of bytes written.
+        bool _reported = false;     // Whether a failure to grow was reported.
+    };
+
+    /// Sink keeping the last lines in memory, mostly for tests.
+    class MemorySink : public LogSink
+    {
+    public:
+        /// Constructs a sink keeping up to the specified number of lines.
+        ///
+        /// Arguments:
+        ///     capacity: the number of lines kept; older lines are overwritten.
+        ///     format: the format of the lines.
+        ///     colored: whether text lines are wrapped in the color of their level.
+        explicit MemorySink(std::size_t capacity = 1024, LogFormat format = LogFormat::TEXT,
+                            bool colored = false);
+
+        void write(LogLevel level, std::string_view line) override;
+        void flush() override {}
+
+        /// Returns the kept lines from oldest to newest, without their new lines.
+        std::vector<std::string> lines();
+
+        /// Discards every kept line.
+        void clear();
+
+    private:
+        std::mutex _mutex;               // Guards the ring.
+        std::vector<std::string> _lines; // Ring of kept lines.
+        std::size_t _next = 0;           // Number of lines ever written.
+    };
+
+} // namespace ostp::libcc::utils
+
+#endif
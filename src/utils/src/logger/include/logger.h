@@ -1,7 +1,16 @@
 #ifndef LOGGER_H
 #define LOGGER_H
 
+#include <atomic>
+#include <cstddef>
+#include <memory>
 #include <string>
+#include <string_view>
+#include <vector>
+
+#include "log_format.h"
+#include "log_level.h"
+#include "log_sink.h"
 
 namespace ostp::libcc::utils
 {
@@ -33,6 +42,151 @@ namespace ostp::libcc::utils
     ///     sender: The name of the sender of the message.
     void log_error(const std::string &, const std::string &);
 
+    // Filtering and structured logging.
+
+    namespace logger_internal
+    {
+        /// Minimum level written at runtime.
+        extern std::atomic<uint8_t> min_level;
+
+    } // namespace logger_internal
+
+    /// Sets the minimum level written at runtime. Messages below it are discarded before being
+    /// formatted.
+    ///
+    /// Args:
+    ///     level: The new minimum level.
+    void set_log_level(LogLevel level);
+
+    /// Returns the minimum level written at runtime.
+    LogLevel log_level();
+
+    /// Returns whether a message of the specified level would be written.
+    inline bool log_enabled(LogLevel level)
+    {
+        return log_compiled(level) &&
+               static_cast<uint8_t>(level) >=
+                   logger_internal::min_level.load(std::memory_order_relaxed);
+    }
+
+    // Sinks.
+
+    /// Adds a sink that receives every message written from now on.
+    ///
+    /// Args:
+    ///     sink: The sink to add.
+    void add_log_sink(std::shared_ptr<LogSink> sink);
+
+    /// Removes a sink previously added or set.
+    ///
+    /// Args:
+    ///     sink: The sink to remove.
+    void remove_log_sink(const std::shared_ptr<LogSink> &sink);
+
+    /// Replaces every sink of the logger.
+    ///
+    /// The logger starts with a single colored ConsoleSink; passing no sinks discards every
+    /// message.
+    ///
+    /// Args:
+    ///     sinks: The new sinks.
+    void set_log_sinks(std::vector<std::shared_ptr<LogSink>> sinks);
+
+    /// Logs an already formatted message with fields.
+    ///
+    /// Args:
+    ///     level: The level of the message.
+    ///     sender: The name of the sender of the message.
+    ///     msg: The message to log.
+    ///     fields: The fields attached to the message.
+    ///     field_count: The number of fields.
+    void write_log(LogLevel level, std::string_view sender, std::string_view msg,
+                   const LogField *fields, std::size_t field_count);
+
+    /// Formats and logs a message if its level passes the compile-time and runtime filters.
+    ///
+    /// Each "{}" in the format is replaced by the next argument that is not a LogField; LogField
+    /// arguments created with kv() are attached as structured fields. Formatting happens on the
+    /// stack and messages longer than 256 characters are truncated.
+    ///
+    /// Prefer the LOG_* macros, which also skip evaluating the arguments of filtered messages.
+    ///
+    /// Args:
+    ///     sender: The name of the sender of the message.
+    ///     fmt: The format of the message.
+    ///     args: The arguments and fields of the message.
+    template <LogLevel level, typename... Args>
+    void log_fmt(std::string_view sender, std::string_view fmt, const Args &...args)
+    {
+        if constexpr (log_compiled(level))
+        {
+            if (!log_enabled(level))
+            {
+                return;
+            }
+            char storage[256];
+            FormatBuffer msg(storage, sizeof(storage));
+            LogField fields[sizeof...(Args) + 1];
+            const std::size_t field_count = format_message(msg, fields, fmt, args...);
+            write_log(level, sender, msg.view(), fields, field_count);
+        }
+    }
+
+    // Asynchronous mode.
+
+    /// Switches the logger to asynchronous mode.
+    ///
+    /// Log calls copy their sender and message into a fixed-size record in a lock-free ring owned
+    /// by the calling thread and return immediately; a background thread formats the records and
+    /// writes them in batches. Senders longer than 40 bytes are truncated, and so are messages
+    /// whose text and encoded fields exceed 208 bytes; the synchronous mode truncates neither.
+    /// Records of one thread are written in order but records of different threads may
+    /// interleave differently than they were logged. Pending records are flushed at exit.
+    ///
+    /// If the logger is already asynchronous this function does nothing.
+    ///
+    /// Args:
+    ///     ring_capacity: The number of records each thread can have pending before it waits.
+    void start_async_logging(std::size_t ring_capacity = 1024);
+
+    /// Writes every pending record, stops the background thread and switches the logger back to
+    /// synchronous mode.
+    ///
+    /// If the logger is not asynchronous this function does nothing.
+    void stop_async_logging();
+
+    /// Writes every pending record and flushes every sink.
+    ///
+    /// Meant to be called from shutdown paths and custom crash handlers.
+    void flush_logs();
+
+    /// Installs handlers for SIGABRT, SIGBUS, SIGFPE, SIGILL and SIGSEGV that write the pending
+    /// records before the process terminates with the default action of the signal.
+    ///
+    /// The flush is best effort and signal safe: records are rendered on the stack and written
+    /// with LogSink::write_from_signal(), which skips a sink busy in another call. Nothing is
+    /// written if the crashing thread was itself draining records or changing the sinks.
+    void install_crash_flush_handler();
+
 } // namespace ostp::libcc::util
 
+// Logs a formatted message at the specified level. The arguments are only evaluated if the level
+// passes both the compile-time and the runtime filters.
+#define LOG_AT(level, sender, ...)                                          \
+    do                                                                      \
+    {                                                                       \
+        if constexpr (ostp::libcc::utils::log_compiled(level))              \
+        {                                                                   \
+            if (ostp::libcc::utils::log_enabled(level))                     \
+            {                                                               \
+                ostp::libcc::utils::log_fmt<level>(sender, __VA_ARGS__);    \
+            }                                                               \
+        }                                                                   \
+    } while (0)
+
+#define LOG_INFO(sender, ...) LOG_AT(ostp::libcc::utils::LogLevel::INFO, sender, __VA_ARGS__)
+#define LOG_OK(sender, ...) LOG_AT(ostp::libcc::utils::LogLevel::OK, sender, __VA_ARGS__)
+#define LOG_WARN(sender, ...) LOG_AT(ostp::libcc::utils::LogLevel::WARN, sender, __VA_ARGS__)
+#define LOG_ERROR(sender, ...) LOG_AT(ostp::libcc::utils::LogLevel::ERROR, sender, __VA_ARGS__)
+
 #endif
\ No newline at end of file
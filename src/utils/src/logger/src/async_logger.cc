@@ -0,0 +1,225 @@
+#include "async_logger.h"
+
+#include <signal.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "log_record.h"
+#include "log_ring.h"
+#include "logger.h"
+#include "logger_state.h"
+
+namespace ostp::libcc::utils
+{
+    namespace
+    {
+        std::atomic<bool> enabled(false);        // Whether log calls go through the rings.
+        std::atomic<bool> running(false);        // Whether the background thread should run.
+        std::atomic<bool> exit_hook_set(false);  // Whether the exit hook was registered.
+        std::atomic<std::size_t> ring_capacity(1024); // Capacity of rings created from now on.
+        std::thread writer;                      // Background thread writing the records.
+        std::mutex lifecycle_mutex;              // Serializes starting and stopping.
+        std::mutex rings_mutex;                  // Guards the list of rings.
+        std::vector<std::shared_ptr<LogRing>> rings; // Rings of every producing thread.
+        std::mutex drain_mutex;                  // Guards the consumer side of the rings.
+
+        /// Owner of the calling thread's ring that orphans it when the thread exits.
+        struct LocalRing
+        {
+            std::shared_ptr<LogRing> ring;
+
+            ~LocalRing()
+            {
+                if (ring)
+                {
+                    ring->orphan();
+                }
+            }
+        };
+
+        thread_local LocalRing local_ring;
+
+        /// Returns the ring of the calling thread registering it on first use.
+        LogRing &thread_ring()
+        {
+            if (!local_ring.ring)
+            {
+                local_ring.ring =
+                    std::make_shared<LogRing>(ring_capacity.load(std::memory_order_relaxed));
+                std::lock_guard<std::mutex> lock(rings_mutex);
+                rings.push_back(local_ring.ring);
+            }
+            return *local_ring.ring;
+        }
+
+        /// Writes every pending record of every ring.
+        ///
+        /// Arguments:
+        ///     crashing: whether the call comes from a signal handler, in which case locks are
+        ///               only tried, records are written with write_from_signal() and nothing
+        ///               is cleaned up or flushed.
+        ///
+        /// Returns:
+        ///     the number of records written.
+        std::size_t drain_all(bool crashing)
+        {
+            std::unique_lock<std::mutex> drain_lock(drain_mutex, std::defer_lock);
+            std::unique_lock<std::mutex> rings_lock(rings_mutex, std::defer_lock);
+            if (crashing)
+            {
+                if (!drain_lock.try_lock() || !rings_lock.try_lock())
+                {
+                    return 0;
+                }
+            }
+            else
+            {
+                drain_lock.lock();
+                rings_lock.lock();
+            }
+
+            // A crashing thread may have been inside a sink, stdio or a change of the sinks, so
+            // records only go through the signal-safe path then.
+            std::size_t count = 0;
+            for (auto &ring : rings)
+            {
+                count += crashing ? ring->drain(logger_internal::dispatch_from_signal)
+                                  : ring->drain(logger_internal::dispatch);
+            }
+
+            // Forget the rings of exited threads once nothing is left in them.
+            if (!crashing)
+            {
+                rings.erase(std::remove_if(rings.begin(), rings.end(),
+                                           [](const std::shared_ptr<LogRing> &ring)
+                                           { return ring->orphaned() && ring->empty(); }),
+                            rings.end());
+            }
+            rings_lock.unlock();
+
+            if (count > 0 && !crashing)
+            {
+                logger_internal::flush_sinks();
+            }
+            return count;
+        }
+
+        /// Body of the background thread.
+        void writer_loop()
+        {
+            while (running.load(std::memory_order_acquire))
+            {
+                if (drain_all(false) == 0)
+                {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+            }
+        }
+
+        /// Flushes pending records and re-raises a fatal signal with its default action.
+        void crash_handler(int signal)
+        {
+            drain_all(true);
+            ::signal(signal, SIG_DFL);
+            ::raise(signal);
+        }
+
+    } // namespace
+
+    // See async_logger.h for documentation.
+    bool async_logging_enabled()
+    {
+        return enabled.load(std::memory_order_relaxed);
+    }
+
+    // See async_logger.h for documentation.
+    void async_enqueue(LogLevel level, std::string_view sender, std::string_view msg,
+                       const LogField *fields, std::size_t field_count)
+    {
+        LogRing &ring = thread_ring();
+        LogRecord *record;
+        while ((record = ring.try_claim()) == nullptr)
+        {
+            // Drain on the calling thread if the background thread has been stopped.
+            if (async_logging_enabled())
+            {
+                std::this_thread::yield();
+            }
+            else
+            {
+                drain_all(false);
+            }
+        }
+        fill_record(*record, level, sender, msg, fields, field_count);
+        ring.publish();
+
+        // If the logger was stopped after the caller chose the asynchronous path, the final drain
+        // of stop_async_logging() may have missed this record, so write it here. The fence pairs
+        // with the one in stop_async_logging(): either the drain sees the record or this thread
+        // sees the logger stopped.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!enabled.load(std::memory_order_relaxed))
+        {
+            drain_all(false);
+        }
+    }
+
+    // See logger.h for documentation.
+    void start_async_logging(std::size_t capacity)
+    {
+        std::lock_guard<std::mutex> lock(lifecycle_mutex);
+        if (enabled.load())
+        {
+            return;
+        }
+        ring_capacity.store(capacity, std::memory_order_relaxed);
+        running.store(true, std::memory_order_release);
+        writer = std::thread(writer_loop);
+        enabled.store(true, std::memory_order_release);
+
+        // Make sure pending records reach their streams when the program exits normally.
+        if (!exit_hook_set.exchange(true))
+        {
+            std::atexit(stop_async_logging);
+        }
+    }
+
+    // See logger.h for documentation.
+    void stop_async_logging()
+    {
+        std::lock_guard<std::mutex> lock(lifecycle_mutex);
+        if (!enabled.load())
+        {
+            return;
+        }
+        enabled.store(false, std::memory_order_release);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        running.store(false, std::memory_order_release);
+        writer.join();
+        drain_all(false);
+    }
+
+    // See logger.h for documentation.
+    void flush_logs()
+    {
+        drain_all(false);
+        logger_internal::flush_sinks();
+    }
+
+    // See logger.h for documentation.
+    void install_crash_flush_handler()
+    {
+        for (int signal : {SIGABRT, SIGBUS, SIGFPE, SIGILL, SIGSEGV})
+        {
+            ::signal(signal, crash_handler);
+        }
+    }
+
+} // namespace ostp::libcc::utils
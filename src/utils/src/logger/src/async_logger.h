@@ -0,0 +1,28 @@
+#ifndef ASYNC_LOGGER_H
+#define ASYNC_LOGGER_H
+
+#include <cstddef>
+#include <string_view>
+
+#include "log_format.h"
+#include "log_level.h"
+
+namespace ostp::libcc::utils
+{
+    /// Returns whether log calls are currently handed to the background thread.
+    bool async_logging_enabled();
+
+    /// Copies a log call into the calling thread's ring for the background thread to write.
+    ///
+    /// Arguments:
+    ///     level: severity of the message.
+    ///     sender: the name of the sender of the message.
+    ///     msg: the formatted message.
+    ///     fields: the fields attached to the message.
+    ///     field_count: the number of fields.
+    void async_enqueue(LogLevel level, std::string_view sender, std::string_view msg,
+                       const LogField *fields, std::size_t field_count);
+
+} // namespace ostp::libcc::utils
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef LEVEL_STYLE_H
+#define LEVEL_STYLE_H
+
+#include <cstdio>
+
+#include "colors.h"
+#include "log_record.h"
+#include "streams.h"
+
+namespace ostp::libcc::utils
+{
+    /// Returns the color used to print messages of the specified level.
+    inline const char *level_color(LogLevel level)
+    {
+        switch (level)
+        {
+        case LogLevel::OK:
+            return GREEN;
+        case LogLevel::WARN:
+            return YELLOW;
+        case LogLevel::ERROR:
+            return RED;
+        default:
+            return NORMAL;
+        }
+    }
+
+    /// Returns the name of the specified level.
+    inline const char *level_name(LogLevel level)
+    {
+        switch (level)
+        {
+        case LogLevel::OK:
+            return "OK";
+        case LogLevel::WARN:
+            return "WARN";
+        case LogLevel::ERROR:
+            return "ERROR";
+        default:
+            return "INFO";
+        }
+    }
+
+    /// Returns the stream messages of the specified level are written to.
+    inline FILE *level_stream(LogLevel level)
+    {
+        switch (level)
+        {
+        case LogLevel::WARN:
+            return WARN_STREAM;
+        case LogLevel::ERROR:
+            return ERROR_STREAM;
+        default:
+            return INFO_STREAM;
+        }
+    }
+
+} // namespace ostp::libcc::utils
+
+#endif
@@ -0,0 +1,208 @@
+#ifndef LOG_RECORD_H
+#define LOG_RECORD_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+#include "log_format.h"
+#include "log_level.h"
+
+namespace ostp::libcc::utils
+{
+    /// Fixed-size binary log record.
+    ///
+    /// The sender, the formatted message and the fields are captured by value so a record can be
+    /// handed to another thread without allocating. The payload stores the message followed by
+    /// the encoded fields; whatever does not fit is truncated. The record spans four cache lines.
+    struct LogRecord
+    {
+        /// Maximum number of bytes stored for the sender.
+        static constexpr std::size_t SENDER_CAPACITY = 40;
+
+        /// Maximum number of bytes stored for the message and the fields.
+        static constexpr std::size_t PAYLOAD_CAPACITY = 208;
+
+        /// Severity of the record.
+        LogLevel level;
+
+        /// Number of bytes of the sender stored in the record.
+        uint8_t sender_len;
+
+        /// Number of fields encoded after the message.
+        uint8_t field_count;
+
+        /// Number of bytes of the message stored in the payload.
+        uint16_t message_len;
+
+        /// Number of bytes used in the payload.
+        uint16_t payload_len;
+
+        /// Sender of the message.
+        char sender[SENDER_CAPACITY];
+
+        /// Message followed by the encoded fields.
+        char payload[PAYLOAD_CAPACITY];
+    };
+
+    static_assert(sizeof(LogRecord) == 256, "LogRecord must span exactly four cache lines");
+
+    /// Log call written synchronously.
+    ///
+    /// Unlike a record, an entry only references the sender, the message and the fields of the
+    /// call, so nothing is copied or truncated before the entry is rendered.
+    struct LogEntry
+    {
+        /// Severity of the entry.
+        LogLevel level;
+
+        /// Sender of the message.
+        std::string_view sender;
+
+        /// Formatted message.
+        std::string_view msg;
+
+        /// Fields attached to the message.
+        const LogField *fields;
+
+        /// Number of fields.
+        std::size_t field_count;
+    };
+
+    /// Returns the sender stored in a record.
+    inline std::string_view sender_of(const LogRecord &record)
+    {
+        return std::string_view(record.sender, record.sender_len);
+    }
+
+    /// Returns the sender of an entry.
+    inline std::string_view sender_of(const LogEntry &entry) { return entry.sender; }
+
+    /// Returns the message stored in a record.
+    inline std::string_view message_of(const LogRecord &record)
+    {
+        return std::string_view(record.payload, record.message_len);
+    }
+
+    /// Returns the message of an entry.
+    inline std::string_view message_of(const LogEntry &entry) { return entry.msg; }
+
+    /// Fills a record with a log call.
+    ///
+    /// Fields are encoded as the key length, the key, the type and the value, with string values
+    /// prefixed by their length. Fields that do not fit entirely are dropped.
+    ///
+    /// Arguments:
+    ///     record: the record to fill.
+    ///     level: the severity of the message.
+    ///     sender: the name of the sender of the message.
+    ///     msg: the message.
+    ///     fields: the fields attached to the message.
+    ///     field_count: the number of fields.
+    inline void fill_record(LogRecord &record, LogLevel level, std::string_view sender,
+                            std::string_view msg, const LogField *fields,
+                            std::size_t field_count)
+    {
+        const std::size_t sender_len = std::min(sender.size(), LogRecord::SENDER_CAPACITY);
+        const std::size_t msg_len = std::min(msg.size(), LogRecord::PAYLOAD_CAPACITY);
+        record.level = level;
+        record.sender_len = static_cast<uint8_t>(sender_len);
+        record.message_len = static_cast<uint16_t>(msg_len);
+        record.field_count = 0;
+        std::memcpy(record.sender, sender.data(), sender_len);
+        std::memcpy(record.payload, msg.data(), msg_len);
+
+        std::size_t len = msg_len;
+        for (std::size_t i = 0; i < field_count; i++)
+        {
+            const LogField &field = fields[i];
+            const std::size_t key_len = std::min<std::size_t>(field.key.size(), UINT8_MAX);
+            const std::size_t value_len =
+                field.type == LogField::Type::STRING
+                    ? 1 + std::min<std::size_t>(field.s.size(), UINT8_MAX)
+                    : (field.type == LogField::Type::BOOL ? 1 : 8);
+            if (len + 2 + key_len + value_len > LogRecord::PAYLOAD_CAPACITY)
+            {
+                break;
+            }
+
+            char *out = record.payload + len;
+            *out++ = static_cast<char>(key_len);
+            std::memcpy(out, field.key.data(), key_len);
+            out += key_len;
+            *out++ = static_cast<char>(field.type);
+            switch (field.type)
+            {
+            case LogField::Type::STRING:
+                *out++ = static_cast<char>(value_len - 1);
+                std::memcpy(out, field.s.data(), value_len - 1);
+                break;
+            case LogField::Type::BOOL:
+                *out = field.b ? 1 : 0;
+                break;
+            default:
+                std::memcpy(out, &field.u, 8);
+                break;
+            }
+            len += 2 + key_len + value_len;
+            record.field_count++;
+        }
+        record.payload_len = static_cast<uint16_t>(len);
+    }
+
+    /// Decodes the fields of a record.
+    ///
+    /// Arguments:
+    ///     record: the record to decode.
+    ///     visit: callable invoked with each field, whose strings point into the record.
+    template <typename F>
+    void for_each_field(const LogRecord &record, F &&visit)
+    {
+        const char *in = record.payload + record.message_len;
+        for (int i = 0; i < record.field_count; i++)
+        {
+            LogField field{};
+            const std::size_t key_len = static_cast<uint8_t>(*in++);
+            field.key = std::string_view(in, key_len);
+            in += key_len;
+            field.type = static_cast<LogField::Type>(*in++);
+            switch (field.type)
+            {
+            case LogField::Type::STRING:
+            {
+                const std::size_t value_len = static_cast<uint8_t>(*in++);
+                field.s = std::string_view(in, value_len);
+                in += value_len;
+                break;
+            }
+            case LogField::Type::BOOL:
+                field.b = *in++ != 0;
+                break;
+            default:
+                std::memcpy(&field.u, in, 8);
+                in += 8;
+                break;
+            }
+            visit(field);
+        }
+    }
+
+    /// Visits the fields of an entry.
+    ///
+    /// Arguments:
+    ///     entry: the entry whose fields to visit.
+    ///     visit: callable invoked with each field.
+    template <typename F>
+    void for_each_field(const LogEntry &entry, F &&visit)
+    {
+        for (std::size_t i = 0; i < entry.field_count; i++)
+        {
+            visit(entry.fields[i]);
+        }
+    }
+
+} // namespace ostp::libcc::utils
+
+#endif
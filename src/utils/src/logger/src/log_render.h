@@ -0,0 +1,175 @@
+#ifndef LOG_RENDER_H
+#define LOG_RENDER_H
+
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <string_view>
+
+#include "colors.h"
+#include "level_style.h"
+#include "log_record.h"
+
+namespace ostp::libcc::utils
+{
+    namespace log_render_internal
+    {
+        /// Appends a string to the output.
+        template <typename Out>
+        void put(Out &out, std::string_view str)
+        {
+            out.append(str.data(), str.size());
+        }
+
+        /// Appends the textual representation of a numeric or boolean field value.
+        template <typename Out>
+        void put_scalar(Out &out, const LogField &field, bool json)
+        {
+            char digits[32];
+            std::to_chars_result result{digits, std::errc()};
+            switch (field.type)
+            {
+            case LogField::Type::INT:
+                result = std::to_chars(digits, digits + sizeof(digits), field.i);
+                break;
+            case LogField::Type::UINT:
+                result = std::to_chars(digits, digits + sizeof(digits), field.u);
+                break;
+            case LogField::Type::DOUBLE:
+                if (json && !std::isfinite(field.d))
+                {
+                    put(out, "null");
+                    return;
+                }
+                result = std::to_chars(digits, digits + sizeof(digits), field.d);
+                break;
+            default:
+                put(out, field.b ? "true" : "false");
+                return;
+            }
+            out.append(digits, result.ptr - digits);
+        }
+
+        /// Appends a string as the contents of a JSON string literal.
+        template <typename Out>
+        void put_json_escaped(Out &out, std::string_view str)
+        {
+            static constexpr char hex[] = "0123456789abcdef";
+            std::size_t start = 0;
+            for (std::size_t i = 0; i < str.size(); i++)
+            {
+                const unsigned char c = str[i];
+                if (c >= 0x20 && c != '"' && c != '\\')
+                {
+                    continue;
+                }
+                out.append(str.data() + start, i - start);
+                start = i + 1;
+                switch (c)
+                {
+                case '"':
+                    put(out, "\\\"");
+                    break;
+                case '\\':
+                    put(out, "\\\\");
+                    break;
+                case '\n':
+                    put(out, "\\n");
+                    break;
+                case '\t':
+                    put(out, "\\t");
+                    break;
+                default:
+                    const char escaped[] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xF]};
+                    out.append(escaped, sizeof(escaped));
+                    break;
+                }
+            }
+            out.append(str.data() + start, str.size() - start);
+        }
+
+    } // namespace log_render_internal
+
+    /// Renders a record or an entry as a "[sender] message key=value" line.
+    ///
+    /// String values containing spaces, quotes or equal signs are quoted.
+    ///
+    /// Arguments:
+    ///     record: the LogRecord or LogEntry to render.
+    ///     colored: whether to wrap the line in the color of its level.
+    ///     out: the output, which must provide append(const char *, std::size_t).
+    template <typename Record, typename Out>
+    void render_text(const Record &record, bool colored, Out &out)
+    {
+        using namespace log_render_internal;
+        if (colored)
+        {
+            put(out, level_color(record.level));
+        }
+        put(out, "[");
+        put(out, sender_of(record));
+        put(out, "] ");
+        put(out, message_of(record));
+        for_each_field(record,
+                       [&out](const LogField &field)
+                       {
+                           put(out, " ");
+                           put(out, field.key);
+                           put(out, "=");
+                           if (field.type != LogField::Type::STRING)
+                           {
+                               put_scalar(out, field, false);
+                           }
+                           else if (field.s.find_first_of(" \"=") == std::string_view::npos)
+                           {
+                               put(out, field.s);
+                           }
+                           else
+                           {
+                               put(out, "\"");
+                               put(out, field.s);
+                               put(out, "\"");
+                           }
+                       });
+        put(out, colored ? "\n" NORMAL : "\n");
+    }
+
+    /// Renders a record or an entry as a single-line JSON object.
+    ///
+    /// Arguments:
+    ///     record: the LogRecord or LogEntry to render.
+    ///     out: the output, which must provide append(const char *, std::size_t).
+    template <typename Record, typename Out>
+    void render_json(const Record &record, Out &out)
+    {
+        using namespace log_render_internal;
+        put(out, "{\"level\":\"");
+        put(out, level_name(record.level));
+        put(out, "\",\"sender\":\"");
+        put_json_escaped(out, sender_of(record));
+        put(out, "\",\"msg\":\"");
+        put_json_escaped(out, message_of(record));
+        put(out, "\"");
+        for_each_field(record,
+                       [&out](const LogField &field)
+                       {
+                           put(out, ",\"");
+                           put_json_escaped(out, field.key);
+                           put(out, "\":");
+                           if (field.type == LogField::Type::STRING)
+                           {
+                               put(out, "\"");
+                               put_json_escaped(out, field.s);
+                               put(out, "\"");
+                           }
+                           else
+                           {
+                               put_scalar(out, field, true);
+                           }
+                       });
+        put(out, "}\n");
+    }
+
+} // namespace ostp::libcc::utils
+
+#endif
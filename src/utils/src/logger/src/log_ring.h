@@ -0,0 +1,101 @@
+#ifndef LOG_RING_H
+#define LOG_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+#include "log_record.h"
+
+namespace ostp::libcc::utils
+{
+    /// Lock-free single-producer single-consumer ring of log records.
+    ///
+    /// Each producing thread owns one ring and the background thread of the asynchronous logger
+    /// is its only consumer. The capacity is always a power of two so positions wrap with a mask.
+    class LogRing
+    {
+    public:
+        /// Constructs a ring able to hold at least the specified number of records.
+        ///
+        /// Arguments:
+        ///     capacity: minimum number of records the ring can hold.
+        explicit LogRing(std::size_t capacity)
+        {
+            std::size_t rounded = 1;
+            while (rounded < capacity)
+            {
+                rounded <<= 1;
+            }
+            _mask = rounded - 1;
+            _records = std::make_unique<LogRecord[]>(rounded);
+        }
+
+        /// Returns a slot for the next record or nullptr if the ring is full.
+        ///
+        /// Only the owning thread may call this method and a returned slot must be followed by
+        /// publish().
+        LogRecord *try_claim()
+        {
+            const std::size_t tail = _tail.load(std::memory_order_relaxed);
+            if (tail - _cached_head > _mask)
+            {
+                _cached_head = _head.load(std::memory_order_acquire);
+                if (tail - _cached_head > _mask)
+                {
+                    return nullptr;
+                }
+            }
+            return &_records[tail & _mask];
+        }
+
+        /// Makes the record returned by the last call to try_claim() visible to the consumer.
+        void publish()
+        {
+            _tail.store(_tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+
+        /// Consumes every published record in order.
+        ///
+        /// Arguments:
+        ///     consume: callable invoked with a const reference to each record.
+        ///
+        /// Returns:
+        ///     the number of records consumed.
+        template <typename F>
+        std::size_t drain(F &&consume)
+        {
+            const std::size_t head = _head.load(std::memory_order_relaxed);
+            const std::size_t tail = _tail.load(std::memory_order_acquire);
+            for (std::size_t i = head; i != tail; i++)
+            {
+                consume(_records[i & _mask]);
+            }
+            _head.store(tail, std::memory_order_release);
+            return tail - head;
+        }
+
+        /// Returns whether there are no published records waiting to be consumed.
+        bool empty() const
+        {
+            return _head.load(std::memory_order_acquire) == _tail.load(std::memory_order_acquire);
+        }
+
+        /// Marks the ring as abandoned by its producer.
+        void orphan() { _orphaned.store(true, std::memory_order_release); }
+
+        /// Returns whether the producer of the ring has exited.
+        bool orphaned() const { return _orphaned.load(std::memory_order_acquire); }
+
+    private:
+        std::unique_ptr<LogRecord[]> _records;      // Storage of the records.
+        std::size_t _mask;                          // Capacity of the ring minus one.
+        alignas(64) std::atomic<std::size_t> _head{0}; // Next position to consume.
+        alignas(64) std::atomic<std::size_t> _tail{0}; // Next position to produce.
+        std::size_t _cached_head = 0;               // Producer's last observed head.
+        std::atomic<bool> _orphaned{false};         // Whether the producer has exited.
+    };
+
+} // namespace ostp::libcc::utils
+
+#endif
@@ -0,0 +1,339 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include "level_style.h"
+#include "log_sink.h"
+
+namespace ostp::libcc::utils
+{
+    namespace
+    {
+        /// Opens a file for appending, creating it if needed.
+        ///
+        /// Throws:
+        ///     std::runtime_error if the file cannot be opened.
+        int open_append(const std::string &path)
+        {
+            int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+            if (fd < 0)
+            {
+                throw std::runtime_error("Cannot open log file " + path + ": " + strerror(errno));
+            }
+            return fd;
+        }
+
+        /// Writes the specified bytes to a descriptor retrying short writes.
+        void write_all(int fd, const char *data, std::size_t len)
+        {
+            while (len > 0)
+            {
+                ssize_t n = ::write(fd, data, len);
+                if (n < 0 && errno == EINTR)
+                {
+                    continue;
+                }
+                if (n <= 0)
+                {
+                    return;
+                }
+                data += n;
+                len -= n;
+            }
+        }
+
+    } // namespace
+
+    // ConsoleSink.
+
+    ConsoleSink::ConsoleSink(LogFormat format, bool colored) : LogSink(format, colored)
+    {
+        for (uint8_t level = 0; level < 4; level++)
+        {
+            _fds[level] = fileno(level_stream(static_cast<LogLevel>(level)));
+        }
+    }
+
+    void ConsoleSink::write(LogLevel level, std::string_view line)
+    {
+        fwrite(line.data(), 1, line.size(), level_stream(level));
+    }
+
+    void ConsoleSink::flush()
+    {
+        fflush(INFO_STREAM);
+        fflush(WARN_STREAM);
+        fflush(ERROR_STREAM);
+    }
+
+    void ConsoleSink::write_from_signal(LogLevel level, std::string_view line)
+    {
+        write_all(_fds[static_cast<uint8_t>(level)], line.data(), line.size());
+    }
+
+    // FileSink.
+
+    FileSink::FileSink(const std::string &path, LogFormat format, bool colored,
+                       std::size_t buffer_size)
+        : LogSink(format, colored), _fd(open_append(path)), _buffer(buffer_size) {}
+
+    FileSink::~FileSink()
+    {
+        flush_locked();
+        ::close(_fd);
+    }
+
+    void FileSink::write(LogLevel, std::string_view line)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_buffered + line.size() > _buffer.size())
+        {
+            flush_locked();
+        }
+        if (line.size() > _buffer.size())
+        {
+            write_all(_fd, line.data(), line.size());
+            return;
+        }
+        std::memcpy(_buffer.data() + _buffered, line.data(), line.size());
+        _buffered += line.size();
+    }
+
+    void FileSink::flush()
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        flush_locked();
+    }
+
+    void FileSink::write_from_signal(LogLevel, std::string_view line)
+    {
+        std::unique_lock<std::mutex> lock(_mutex, std::try_to_lock);
+        if (!lock.owns_lock())
+        {
+            return;
+        }
+        flush_locked();
+        write_all(_fd, line.data(), line.size());
+    }
+
+    void FileSink::flush_locked()
+    {
+        write_all(_fd, _buffer.data(), _buffered);
+        _buffered = 0;
+    }
+
+    // RotatingFileSink.
+
+    RotatingFileSink::RotatingFileSink(const std::string &path, std::size_t max_bytes,
+                                       std::chrono::seconds max_age, int max_files,
+                                       LogFormat format, bool colored)
+        : FileSink(path, format, colored), _path(path), _max_bytes(max_bytes),
+          _max_age(max_age), _max_files(max_files), _opened(std::chrono::steady_clock::now())
+    {
+        _file_bytes = ::lseek(_fd, 0, SEEK_END);
+    }
+
+    void RotatingFileSink::write(LogLevel, std::string_view line)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        const bool too_big = _max_bytes > 0 && _file_bytes > 0 &&
+                             _file_bytes + line.size() > _max_bytes;
+        const bool too_old = _max_age.count() > 0 &&
+                             std::chrono::steady_clock::now() - _opened >= _max_age;
+        if (too_big || too_old)
+        {
+            rotate_locked();
+        }
+
+        if (_buffered + line.size() > _buffer.size())
+        {
+            flush_locked();
+        }
+        if (line.size() > _buffer.size())
+        {
+            write_all(_fd, line.data(), line.size());
+        }
+        else
+        {
+            std::memcpy(_buffer.data() + _buffered, line.data(), line.size());
+            _buffered += line.size();
+        }
+        _file_bytes += line.size();
+    }
+
+    void RotatingFileSink::rotate_locked()
+    {
+        flush_locked();
+
+        // Shift every rotated file by one, dropping the oldest.
+        for (int i = _max_files - 1; i >= 1; i--)
+        {
+            const std::string from = _path + "." + std::to_string(i);
+            const std::string to = _path + "." + std::to_string(i + 1);
+            ::rename(from.c_str(), to.c_str());
+        }
+        if (_max_files > 0)
+        {
+            ::rename(_path.c_str(), (_path + ".1").c_str());
+        }
+        else
+        {
+            ::unlink(_path.c_str());
+        }
+
+        // Keep writing to the renamed file if the new one cannot be opened: this runs inside log
+        // calls, which must not throw. The next rotation tries again.
+        const int fd = ::open(_path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        if (fd < 0)
+        {
+            fprintf(ERROR_STREAM, "Cannot open log file %s: %s\n", _path.c_str(), strerror(errno));
+        }
+        else
+        {
+            ::close(_fd);
+            _fd = fd;
+        }
+        _file_bytes = 0;
+        _opened = std::chrono::steady_clock::now();
+    }
+
+    // MmapFileSink.
+
+    MmapFileSink::MmapFileSink(const std::string &path, std::size_t chunk_size, LogFormat format,
+                               bool colored)
+        : LogSink(format, colored), _chunk(chunk_size)
+    {
+        if (_chunk == 0)
+        {
+            throw std::runtime_error("Log file chunk size must not be 0");
+        }
+        _fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (_fd < 0)
+        {
+            throw std::runtime_error("Cannot open log file " + path + ": " + strerror(errno));
+        }
+        const int error = grow_locked(_chunk);
+        if (error != 0)
+        {
+            ::close(_fd);
+            throw std::runtime_error("Cannot map log file " + path + ": " + strerror(error));
+        }
+    }
+
+    MmapFileSink::~MmapFileSink()
+    {
+        if (_data != nullptr)
+        {
+            ::munmap(_data, _mapped);
+        }
+        // Drop the zero-filled tail of the last chunk.
+        [[maybe_unused]] int result = ::ftruncate(_fd, _written);
+        ::close(_fd);
+    }
+
+    void MmapFileSink::write(LogLevel, std::string_view line)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_written + line.size() > _mapped)
+        {
+            // Drop the line rather than throw: this runs inside log calls, which must not throw.
+            const int error = grow_locked(_written + line.size());
+            if (error != 0)
+            {
+                if (!_reported)
+                {
+                    fprintf(ERROR_STREAM, "Cannot extend log file: %s\n", strerror(error));
+                    _reported = true;
+                }
+                return;
+            }
+        }
+        std::memcpy(_data + _written, line.data(), line.size());
+        _written += line.size();
+    }
+
+    void MmapFileSink::flush()
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        ::msync(_data, _mapped, MS_ASYNC);
+    }
+
+    void MmapFileSink::write_from_signal(LogLevel, std::string_view line)
+    {
+        std::unique_lock<std::mutex> lock(_mutex, std::try_to_lock);
+        if (!lock.owns_lock() || _written + line.size() > _mapped)
+        {
+            return;
+        }
+        std::memcpy(_data + _written, line.data(), line.size());
+        _written += line.size();
+    }
+
+    int MmapFileSink::grow_locked(std::size_t size)
+    {
+        std::size_t mapped = _mapped;
+        while (mapped < size)
+        {
+            mapped += _chunk;
+        }
+        if (::ftruncate(_fd, mapped) != 0)
+        {
+            const int error = errno;
+            [[maybe_unused]] int result = ::ftruncate(_fd, _mapped);
+            return error;
+        }
+
+        void *data = _data == nullptr
+                         ? ::mmap(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0)
+                         : ::mremap(_data, _mapped, mapped, MREMAP_MAYMOVE);
+        if (data == MAP_FAILED)
+        {
+            const int error = errno;
+            [[maybe_unused]] int result = ::ftruncate(_fd, _mapped);
+            return error;
+        }
+        _data = static_cast<char *>(data);
+        _mapped = mapped;
+        return 0;
+    }
+
+    // MemorySink.
+
+    MemorySink::MemorySink(std::size_t capacity, LogFormat format, bool colored)
+        : LogSink(format, colored), _lines(capacity > 0 ? capacity : 1) {}
+
+    void MemorySink::write(LogLevel, std::string_view line)
+    {
+        if (!line.empty() && line.back() == '\n')
+        {
+            line.remove_suffix(1);
+        }
+        std::lock_guard<std::mutex> lock(_mutex);
+        _lines[_next++ % _lines.size()].assign(line.data(), line.size());
+    }
+
+    std::vector<std::string> MemorySink::lines()
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        std::vector<std::string> lines;
+        const std::size_t count = _next < _lines.size() ? _next : _lines.size();
+        for (std::size_t i = _next - count; i < _next; i++)
+        {
+            lines.push_back(_lines[i % _lines.size()]);
+        }
+        return lines;
+    }
+
+    void MemorySink::clear()
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _next = 0;
+    }
+
+} // namespace ostp::libcc::utils
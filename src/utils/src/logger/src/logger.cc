@@ -1,33 +1,189 @@
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
 
 #include "logger.h"
-#include "colors.h"
-#include "streams.h"
+#include "async_logger.h"
+#include "log_record.h"
+#include "log_render.h"
+#include "logger_state.h"
 
 namespace ostp::libcc::utils
 {
+    namespace
+    {
+        using SinkList = std::vector<std::shared_ptr<LogSink>>;
+
+        /// Current sinks. The list is replaced as a whole so writers never hold sinks_mutex
+        /// while writing; loading it may still take the internal lock of the atomic.
+        std::atomic<std::shared_ptr<const SinkList>> sinks(
+            std::make_shared<const SinkList>(SinkList{std::make_shared<ConsoleSink>()}));
+
+        /// Serializes changes to the list of sinks.
+        std::mutex sinks_mutex;
+
+        /// Current sinks for signal handlers, which cannot load the atomic. Only changed under
+        /// sinks_mutex, so the list stays alive while a handler holds the mutex.
+        const SinkList *signal_sinks = sinks.load().get();
+
+        /// Replaces the list of sinks. The caller must hold sinks_mutex.
+        void replace_sinks(SinkList updated)
+        {
+            auto list = std::make_shared<const SinkList>(std::move(updated));
+            signal_sinks = list.get();
+            sinks.store(std::move(list));
+        }
+
+        /// Renders a record or an entry in the format of a sink.
+        template <typename Record, typename Out>
+        void render(const Record &record, const LogSink &sink, Out &line)
+        {
+            if (sink.format() == LogFormat::JSON_LINES)
+            {
+                render_json(record, line);
+            }
+            else
+            {
+                render_text(record, sink.colored(), line);
+            }
+        }
+
+    } // namespace
+
+    namespace logger_internal
+    {
+        std::atomic<uint8_t> min_level(static_cast<uint8_t>(LogLevel::INFO));
+
+        // See logger_state.h for documentation.
+        void dispatch(const LogRecord &record)
+        {
+            const std::shared_ptr<const SinkList> current = sinks.load();
+            for (const std::shared_ptr<LogSink> &sink : *current)
+            {
+                // Records are small enough for their lines to always fit.
+                char storage[2048];
+                FormatBuffer line(storage, sizeof(storage));
+                render(record, *sink, line);
+                sink->write(record.level, line.view());
+            }
+        }
+
+        // See logger_state.h for documentation.
+        void dispatch_from_signal(const LogRecord &record)
+        {
+            std::unique_lock<std::mutex> lock(sinks_mutex, std::try_to_lock);
+            if (!lock.owns_lock())
+            {
+                return;
+            }
+            for (const std::shared_ptr<LogSink> &sink : *signal_sinks)
+            {
+                char storage[2048];
+                FormatBuffer line(storage, sizeof(storage));
+                render(record, *sink, line);
+                sink->write_from_signal(record.level, line.view());
+            }
+        }
+
+        // See logger_state.h for documentation.
+        void flush_sinks()
+        {
+            const std::shared_ptr<const SinkList> current = sinks.load();
+            for (const std::shared_ptr<LogSink> &sink : *current)
+            {
+                sink->flush();
+            }
+        }
+
+    } // namespace logger_internal
+
+    // See logger.h for documentation.
+    void write_log(LogLevel level, std::string_view sender, std::string_view msg,
+                   const LogField *fields, std::size_t field_count)
+    {
+        if (!log_enabled(level))
+        {
+            return;
+        }
+        if (async_logging_enabled())
+        {
+            async_enqueue(level, sender, msg, fields, field_count);
+            return;
+        }
+
+        // Render straight from the call so nothing is truncated, reusing the line of the thread.
+        thread_local std::string line;
+        const LogEntry entry{level, sender, msg, fields, field_count};
+        const std::shared_ptr<const SinkList> current = sinks.load();
+        for (const std::shared_ptr<LogSink> &sink : *current)
+        {
+            line.clear();
+            render(entry, *sink, line);
+            sink->write(level, line);
+        }
+    }
+
     // See logger.h for documentation.
     void log_info(const std::string &msg, const std::string &sender)
     {
-        fprintf(INFO_STREAM, NORMAL "[%s] %s\n" NORMAL, sender.c_str(), msg.c_str());
+        write_log(LogLevel::INFO, sender, msg, nullptr, 0);
     }
 
     // See logger.h for documentation.
     void log_ok(const std::string &msg, const std::string &sender)
     {
-        fprintf(INFO_STREAM, GREEN "[%s] %s\n" NORMAL, sender.c_str(), msg.c_str());
+        write_log(LogLevel::OK, sender, msg, nullptr, 0);
     }
 
     // See logger.h for documentation.
     void log_warn(const std::string &msg, const std::string &sender)
     {
-        fprintf(WARN_STREAM, YELLOW "[%s] %s\n" NORMAL, sender.c_str(), msg.c_str());
+        write_log(LogLevel::WARN, sender, msg, nullptr, 0);
     }
 
     // See logger.h for documentation.
     void log_error(const std::string &msg, const std::string &sender)
     {
-        fprintf(ERROR_STREAM, RED "[%s] %s\n" NORMAL, sender.c_str(), msg.c_str());
+        write_log(LogLevel::ERROR, sender, msg, nullptr, 0);
+    }
+
+    // See logger.h for documentation.
+    void set_log_level(LogLevel level)
+    {
+        logger_internal::min_level.store(static_cast<uint8_t>(level), std::memory_order_relaxed);
+    }
+
+    // See logger.h for documentation.
+    LogLevel log_level()
+    {
+        return static_cast<LogLevel>(logger_internal::min_level.load(std::memory_order_relaxed));
+    }
+
+    // See logger.h for documentation.
+    void add_log_sink(std::shared_ptr<LogSink> sink)
+    {
+        std::lock_guard<std::mutex> lock(sinks_mutex);
+        SinkList updated = *sinks.load();
+        updated.push_back(std::move(sink));
+        replace_sinks(std::move(updated));
+    }
+
+    // See logger.h for documentation.
+    void remove_log_sink(const std::shared_ptr<LogSink> &sink)
+    {
+        std::lock_guard<std::mutex> lock(sinks_mutex);
+        SinkList updated = *sinks.load();
+        std::erase(updated, sink);
+        replace_sinks(std::move(updated));
+    }
+
+    // See logger.h for documentation.
+    void set_log_sinks(std::vector<std::shared_ptr<LogSink>> sinks_list)
+    {
+        std::lock_guard<std::mutex> lock(sinks_mutex);
+        replace_sinks(std::move(sinks_list));
     }
 
 } // namespace ostp::libcc::util
@@ -0,0 +1,28 @@
+#ifndef LOGGER_STATE_H
+#define LOGGER_STATE_H
+
+#include "log_record.h"
+
+namespace ostp::libcc::utils::logger_internal
+{
+    /// Renders a record in the format of every sink and writes it to them.
+    ///
+    /// Arguments:
+    ///     record: the record to write.
+    void dispatch(const LogRecord &record);
+
+    /// Renders a record in the format of every sink and writes it with write_from_signal().
+    ///
+    /// Safe to call from a signal handler: nothing is written if the list of sinks is being
+    /// changed.
+    ///
+    /// Arguments:
+    ///     record: the record to write.
+    void dispatch_from_signal(const LogRecord &record);
+
+    /// Flushes every sink.
+    void flush_sinks();
+
+} // namespace ostp::libcc::utils::logger_internal
+
+#endif
@@ -0,0 +1,330 @@
+#include "logger.h"
+
+#include <signal.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "log_sink.h"
+#include "testing.h"
+
+using ostp::libcc::utils::add_log_sink;
+using ostp::libcc::utils::ConsoleSink;
+using ostp::libcc::utils::FileSink;
+using ostp::libcc::utils::flush_logs;
+using ostp::libcc::utils::kv;
+using ostp::libcc::utils::LogFormat;
+using ostp::libcc::utils::LogLevel;
+using ostp::libcc::utils::MemorySink;
+using ostp::libcc::utils::MmapFileSink;
+using ostp::libcc::utils::remove_log_sink;
+using ostp::libcc::utils::RotatingFileSink;
+using ostp::libcc::utils::set_log_sinks;
+using ostp::libcc::utils::set_log_level;
+using ostp::libcc::utils::start_async_logging;
+using ostp::libcc::utils::stop_async_logging;
+
+/// Returns the contents of the specified file.
+std::string read_file(const std::string &path) {
+    std::ifstream file(path);
+    std::stringstream contents;
+    contents << file.rdbuf();
+    return contents.str();
+}
+
+/// Returns a path in the temporary directory unique to this process.
+std::string temp_path(const std::string &name) {
+    return "/tmp/logger_test_" + std::to_string(getpid()) + "_" + name;
+}
+
+/// File sink whose mutex a test can hold, as a crash inside one of its calls would.
+class LockableFileSink : public FileSink {
+   public:
+    using FileSink::FileSink;
+
+    std::mutex &mutex() { return _mutex; }
+};
+
+START_SUITE(Logger_Tests)
+
+START_SERIAL_TEST(FormatsArgumentsAndFields) {
+    auto sink = std::make_shared<MemorySink>();
+    add_log_sink(sink);
+    LOG_INFO("sender", "a {} b {} {{}}", 1, "two", kv("k", 3), kv("name", "x y"), kv("ok", true));
+    remove_log_sink(sink);
+
+    auto lines = sink->lines();
+    ASSERT(lines.size() == 1);
+    TEST(lines[0] == "[sender] a 1 b two {} k=3 name=\"x y\" ok=true");
+}
+END_TEST
+
+START_SERIAL_TEST(LegacyFunctionsUseSinks) {
+    auto sink = std::make_shared<MemorySink>();
+    add_log_sink(sink);
+    ostp::libcc::utils::log_warn("message", "sender");
+    remove_log_sink(sink);
+
+    auto lines = sink->lines();
+    ASSERT(lines.size() == 1);
+    TEST(lines[0] == "[sender] message");
+}
+END_TEST
+
+START_SERIAL_TEST(SynchronousModeKeepsLongMessages) {
+    auto sink = std::make_shared<MemorySink>();
+    add_log_sink(sink);
+    const std::string sender(64, 's');
+    std::string msg;
+    for (int i = 0; i < 100; i++) {
+        msg += std::to_string(i) + " ";
+    }
+    ostp::libcc::utils::log_info(msg, sender);
+    remove_log_sink(sink);
+
+    // Both exceed what an asynchronous record holds.
+    ASSERT(msg.size() > 208);
+    auto lines = sink->lines();
+    ASSERT(lines.size() == 1);
+    TEST(lines[0] == "[" + sender + "] " + msg);
+}
+END_TEST
+
+START_SERIAL_TEST(RendersJsonLines) {
+    auto sink = std::make_shared<MemorySink>(16, LogFormat::JSON_LINES);
+    add_log_sink(sink);
+    LOG_ERROR("s\"q", "line\nbreak {}", -7, kv("u", 5u), kv("str", "v"));
+    remove_log_sink(sink);
+
+    auto lines = sink->lines();
+    ASSERT(lines.size() == 1);
+    TEST(lines[0] ==
+         "{\"level\":\"ERROR\",\"sender\":\"s\\\"q\",\"msg\":\"line\\nbreak -7\",\"u\":5,"
+         "\"str\":\"v\"}");
+}
+END_TEST
+
+START_SERIAL_TEST(RuntimeLevelSkipsFormatting) {
+    auto sink = std::make_shared<MemorySink>();
+    add_log_sink(sink);
+    set_log_level(LogLevel::WARN);
+    int evaluated = 0;
+    LOG_INFO("sender", "{}", ++evaluated);
+    LOG_WARN("sender", "{}", ++evaluated);
+    set_log_level(LogLevel::INFO);
+    remove_log_sink(sink);
+
+    // Only the warning was evaluated and written.
+    TEST(evaluated == 1);
+    TEST(sink->lines().size() == 1);
+}
+END_TEST
+
+START_SERIAL_TEST(AsyncModeDeliversEveryRecord) {
+    const int threads = 4;
+    const int per_thread = 500;
+    auto sink = std::make_shared<MemorySink>(threads * per_thread);
+    set_log_sinks({sink});
+    start_async_logging(64);
+
+    std::vector<std::thread> producers;
+    for (int t = 0; t < threads; t++) {
+        producers.emplace_back([t]() {
+            for (int i = 0; i < per_thread; i++) {
+                LOG_INFO("async", "{} {}", t, i);
+            }
+        });
+    }
+    for (auto &producer : producers) {
+        producer.join();
+    }
+    stop_async_logging();
+    set_log_sinks({std::make_shared<ConsoleSink>()});
+
+    TEST(sink->lines().size() == threads * per_thread);
+}
+END_TEST
+
+START_SERIAL_TEST(AsyncStopLosesNoRecord) {
+    const int threads = 4;
+    const int per_thread = 20000;
+    auto sink = std::make_shared<MemorySink>(threads * per_thread);
+    set_log_sinks({sink});
+
+    // Producers keep logging while the logger switches between modes.
+    std::atomic<int> done(0);
+    std::vector<std::thread> producers;
+    for (int t = 0; t < threads; t++) {
+        producers.emplace_back([t, &done]() {
+            for (int i = 0; i < per_thread; i++) {
+                LOG_INFO("", "{} {}", t, i);
+            }
+            done++;
+        });
+    }
+    while (done.load() < threads) {
+        start_async_logging(16);
+        std::this_thread::yield();
+        stop_async_logging();
+    }
+    for (auto &producer : producers) {
+        producer.join();
+    }
+    set_log_sinks({std::make_shared<ConsoleSink>()});
+
+    // A record left behind by a stop would be missing or written after later records of its
+    // thread.
+    std::vector<int> next(threads, 0);
+    int out_of_order = 0;
+    const std::vector<std::string> lines = sink->lines();
+    for (const std::string &line : lines) {
+        int t = 0;
+        int i = 0;
+        std::istringstream(line.substr(line.find(']') + 2)) >> t >> i;
+        out_of_order += i != next[t]++;
+    }
+    TEST(lines.size() == threads * per_thread);
+    TEST(out_of_order == 0);
+}
+END_TEST
+
+START_SERIAL_TEST(FileSinkBuffersUntilFlush) {
+    const std::string path = temp_path("file");
+    auto sink = std::make_shared<FileSink>(path);
+    add_log_sink(sink);
+    LOG_OK("sender", "buffered");
+    TEST(read_file(path).empty());
+    flush_logs();
+    remove_log_sink(sink);
+
+    TEST(read_file(path) == "[sender] buffered\n");
+    unlink(path.c_str());
+}
+END_TEST
+
+START_SERIAL_TEST(FileSinkWritesFromSignalUnlessBusy) {
+    const std::string path = temp_path("signal");
+    LockableFileSink sink(path);
+    sink.write(LogLevel::INFO, "buffered\n");
+
+    // The buffered line goes out first, with no flush needed.
+    sink.write_from_signal(LogLevel::ERROR, "crash\n");
+    TEST(read_file(path) == "buffered\ncrash\n");
+
+    // A sink held by the crashing thread drops the line instead of deadlocking.
+    {
+        std::lock_guard<std::mutex> lock(sink.mutex());
+        sink.write_from_signal(LogLevel::ERROR, "dropped\n");
+    }
+    TEST(read_file(path) == "buffered\ncrash\n");
+    unlink(path.c_str());
+}
+END_TEST
+
+START_SERIAL_TEST(RotatingFileSinkRotatesOnSize) {
+    const std::string path = temp_path("rotating");
+    {
+        auto sink = std::make_shared<RotatingFileSink>(path, 20, std::chrono::seconds(0), 2);
+        add_log_sink(sink);
+        LOG_INFO("s", "first line");
+        LOG_INFO("s", "second line");
+        LOG_INFO("s", "third line");
+        remove_log_sink(sink);
+    }
+
+    // Each line is 17 bytes so every line lands in its own file.
+    TEST(read_file(path) == "[s] third line\n");
+    TEST(read_file(path + ".1") == "[s] second line\n");
+    TEST(read_file(path + ".2") == "[s] first line\n");
+    unlink(path.c_str());
+    unlink((path + ".1").c_str());
+    unlink((path + ".2").c_str());
+}
+END_TEST
+
+START_SERIAL_TEST(RotatingFileSinkSurvivesFailedReopen) {
+    const std::string dir = temp_path("rotating_dir");
+    const std::string path = dir + "/log";
+    mkdir(dir.c_str(), 0755);
+    auto sink = std::make_shared<RotatingFileSink>(path, 20, std::chrono::seconds(0), 2);
+    add_log_sink(sink);
+    LOG_INFO("s", "first line");
+
+    // Removing the directory makes the next rotation fail to open a new file, so the line goes
+    // to the old one; once the directory is back the following rotation succeeds.
+    unlink(path.c_str());
+    rmdir(dir.c_str());
+    LOG_INFO("s", "second line");
+    mkdir(dir.c_str(), 0755);
+    LOG_INFO("s", "third line");
+    flush_logs();
+    remove_log_sink(sink);
+
+    TEST(read_file(path) == "[s] third line\n");
+    unlink(path.c_str());
+    rmdir(dir.c_str());
+}
+END_TEST
+
+START_SERIAL_TEST(MmapFileSinkGrowsAndTruncates) {
+    const std::string path = temp_path("mmap");
+    std::string expected;
+    {
+        auto sink = std::make_shared<MmapFileSink>(path, 4096);
+        set_log_sinks({sink});
+        for (int i = 0; i < 1000; i++) {
+            LOG_INFO("s", "{}", i);
+            expected += "[s] " + std::to_string(i) + "\n";
+        }
+        set_log_sinks({std::make_shared<ConsoleSink>()});
+    }
+
+    TEST(read_file(path) == expected);
+    unlink(path.c_str());
+}
+END_TEST
+
+START_SERIAL_TEST(MmapFileSinkDropsLinesItCannotFit) {
+    bool thrown = false;
+    try {
+        MmapFileSink sink(temp_path("mmap_zero"), 0);
+    } catch (const std::runtime_error &) {
+        thrown = true;
+    }
+    TEST(thrown);
+    unlink(temp_path("mmap_zero").c_str());
+
+    // Capping the file size makes growing past the first chunk fail.
+    const std::string path = temp_path("mmap_full");
+    rlimit saved;
+    getrlimit(RLIMIT_FSIZE, &saved);
+    rlimit capped = saved;
+    capped.rlim_cur = 4096;
+    signal(SIGXFSZ, SIG_IGN);
+    setrlimit(RLIMIT_FSIZE, &capped);
+    {
+        MmapFileSink sink(path, 4096);
+        const std::string line(1000, 'x');
+        for (int i = 0; i < 5; i++) {
+            sink.write(LogLevel::INFO, line);
+        }
+    }
+    setrlimit(RLIMIT_FSIZE, &saved);
+    signal(SIGXFSZ, SIG_DFL);
+
+    TEST(read_file(path) == std::string(4000, 'x'));
+    unlink(path.c_str());
+}
+END_TEST
+
+END_SUITE
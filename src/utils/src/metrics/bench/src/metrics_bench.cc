@@ -0,0 +1,38 @@
+#include "metrics.h"
+
+#include <cstdint>
+
+#include "benchmarking.h"
+
+using ostp::libcc::utils::Counter;
+using ostp::libcc::utils::Gauge;
+using ostp::libcc::utils::Histogram;
+using ostp::libcc::utils::ScopedTimer;
+
+START_BENCH_SUITE(Metrics)
+
+Counter counter;
+Gauge gauge;
+Histogram histogram;
+
+START_BENCH(CounterAdd) {
+    BENCH_LOOP { counter.add(); }
+}
+END_BENCH
+
+START_BENCH(GaugeAdd) {
+    BENCH_LOOP { gauge.add(_iteration & 1 ? 1 : -1); }
+}
+END_BENCH
+
+START_BENCH(HistogramRecord) {
+    BENCH_LOOP { histogram.record(_iteration * 2654435761u >> 40); }
+}
+END_BENCH
+
+START_BENCH(ScopedTimer) {
+    BENCH_LOOP { ScopedTimer timer(histogram); }
+}
+END_BENCH
+
+END_BENCH_SUITE
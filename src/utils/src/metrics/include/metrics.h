@@ -0,0 +1,303 @@
+#ifndef LIBCC_METRICS_H
+#define LIBCC_METRICS_H
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "status_or.h"
+
+namespace ostp::libcc::utils {
+
+/// Whether the containers of the library record metrics.
+///
+/// Recording is opt-in: configure with -DLIBCC_METRICS=ON to define LIBCC_METRICS. When it is not
+/// defined, the instrumentation of the containers is discarded at compile time.
+#ifdef LIBCC_METRICS
+inline constexpr bool metrics_enabled = true;
+#else
+inline constexpr bool metrics_enabled = false;
+#endif
+
+namespace metrics_internal {
+
+/// Number of shards of each counter, gauge and histogram.
+inline constexpr std::size_t SHARDS = 16;
+
+/// Next shard assigned to a thread.
+inline std::atomic<std::size_t> next_shard{0};
+
+/// Shard of the calling thread, or SHARDS until it is assigned. Constant-initialized so reading
+/// it needs no TLS guard.
+inline thread_local std::size_t thread_shard = SHARDS;
+
+/// Returns the shard of the calling thread. Threads are assigned shards round-robin.
+inline std::size_t shard_index() {
+    if (thread_shard == SHARDS) [[unlikely]] {
+        thread_shard = next_shard.fetch_add(1, std::memory_order_relaxed) % SHARDS;
+    }
+    return thread_shard;
+}
+
+/// A value on its own cache line so shards written by different threads do not false share.
+template <typename T>
+struct alignas(64) Shard {
+    std::atomic<T> value{0};
+};
+
+}  // namespace metrics_internal
+
+/// Monotonic counter.
+///
+/// Each thread adds to its own shard with a relaxed atomic addition and the value is the sum of
+/// the shards, so recording never contends on a shared cache line.
+class Counter {
+   public:
+    /// Adds the specified amount to the counter.
+    void add(uint64_t n = 1) {
+        _shards[metrics_internal::shard_index()].value.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    /// Returns the sum of the shards.
+    uint64_t value() const {
+        uint64_t sum = 0;
+        for (const auto &shard : _shards) {
+            sum += shard.value.load(std::memory_order_relaxed);
+        }
+        return sum;
+    }
+
+   private:
+    std::array<metrics_internal::Shard<uint64_t>, metrics_internal::SHARDS> _shards;
+};
+
+/// Value that goes up and down, such as the number of queued messages.
+///
+/// Like a counter, additions go to the shard of the calling thread and the value is the sum of
+/// the shards.
+class Gauge {
+   public:
+    /// Adds the specified amount, which may be negative, to the gauge.
+    void add(int64_t n) {
+        _shards[metrics_internal::shard_index()].value.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    /// Sets the gauge to the specified value.
+    ///
+    /// Additions made concurrently with set() may be lost, so a gauge is either set by a single
+    /// thread or only added to.
+    void set(int64_t value) {
+        for (auto &shard : _shards) {
+            shard.value.store(0, std::memory_order_relaxed);
+        }
+        _shards[0].value.store(value, std::memory_order_relaxed);
+    }
+
+    /// Returns the sum of the shards.
+    int64_t value() const {
+        int64_t sum = 0;
+        for (const auto &shard : _shards) {
+            sum += shard.value.load(std::memory_order_relaxed);
+        }
+        return sum;
+    }
+
+   private:
+    std::array<metrics_internal::Shard<int64_t>, metrics_internal::SHARDS> _shards;
+};
+
+/// Histogram of unsigned values with log-linear buckets.
+///
+/// Values below SUB_BUCKETS have a bucket each. Above, every power of two is split into
+/// SUB_BUCKETS linear buckets, which bounds the relative error of a bucket to 1 / SUB_BUCKETS
+/// over the whole 64-bit range, as in HDR histograms. Recording finds the bucket with a count of
+/// leading zeros and adds to it in the shard of the calling thread.
+class Histogram {
+   public:
+    /// Number of linear buckets per power of two.
+    static constexpr int SUB_BUCKET_BITS = 3;
+    static constexpr uint64_t SUB_BUCKETS = uint64_t{1} << SUB_BUCKET_BITS;
+
+    /// Number of buckets covering every uint64_t.
+    static constexpr std::size_t BUCKETS = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+    /// Returns the bucket of the specified value.
+    static constexpr std::size_t bucket_of(uint64_t value) {
+        if (value < SUB_BUCKETS) {
+            return value;
+        }
+        const int exponent = 63 - std::countl_zero(value);
+        const int shift = exponent - SUB_BUCKET_BITS;
+        return (shift + 1) * SUB_BUCKETS + ((value >> shift) & (SUB_BUCKETS - 1));
+    }
+
+    /// Returns the smallest value of the specified bucket.
+    static constexpr uint64_t bucket_lower_bound(std::size_t bucket) {
+        if (bucket < SUB_BUCKETS) {
+            return bucket;
+        }
+        const int shift = static_cast<int>(bucket / SUB_BUCKETS) - 1;
+        return (SUB_BUCKETS + bucket % SUB_BUCKETS) << shift;
+    }
+
+    /// Returns the largest value of the specified bucket.
+    static constexpr uint64_t bucket_upper_bound(std::size_t bucket) {
+        return bucket + 1 < BUCKETS ? bucket_lower_bound(bucket + 1) - 1 : UINT64_MAX;
+    }
+
+    /// Records a value.
+    void record(uint64_t value) {
+        Shard &shard = _shards[metrics_internal::shard_index()];
+        shard.buckets[bucket_of(value)].fetch_add(1, std::memory_order_relaxed);
+        shard.sum.fetch_add(value, std::memory_order_relaxed);
+    }
+
+    /// Returns the number of values recorded in the specified bucket.
+    uint64_t bucket_count(std::size_t bucket) const {
+        uint64_t count = 0;
+        for (const Shard &shard : _shards) {
+            count += shard.buckets[bucket].load(std::memory_order_relaxed);
+        }
+        return count;
+    }
+
+    /// Returns the number of recorded values.
+    uint64_t count() const {
+        uint64_t count = 0;
+        for (std::size_t bucket = 0; bucket < BUCKETS; bucket++) {
+            count += bucket_count(bucket);
+        }
+        return count;
+    }
+
+    /// Returns the sum of the recorded values.
+    uint64_t sum() const {
+        uint64_t sum = 0;
+        for (const Shard &shard : _shards) {
+            sum += shard.sum.load(std::memory_order_relaxed);
+        }
+        return sum;
+    }
+
+    /// Returns an upper bound of the specified quantile of the recorded values.
+    ///
+    /// Arguments:
+    ///     quantile: the quantile between 0 and 1.
+    ///
+    /// Returns:
+    ///     the largest value of the bucket holding the quantile or 0 if nothing was recorded.
+    uint64_t quantile(double quantile) const;
+
+   private:
+    /// Buckets and sum of the values recorded by the threads of a shard.
+    struct alignas(64) Shard {
+        std::array<std::atomic<uint64_t>, BUCKETS> buckets{};
+        std::atomic<uint64_t> sum{0};
+    };
+
+    std::array<Shard, metrics_internal::SHARDS> _shards;
+};
+
+/// Records the time elapsed between its construction and destruction in a histogram, in
+/// nanoseconds.
+class ScopedTimer {
+   public:
+    /// Starts timing.
+    ///
+    /// Arguments:
+    ///     histogram: the histogram the elapsed time is recorded in.
+    explicit ScopedTimer(Histogram &histogram)
+        : _histogram(histogram), _start(std::chrono::steady_clock::now()) {}
+
+    /// Records the elapsed time.
+    ~ScopedTimer() {
+        _histogram.record(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                              std::chrono::steady_clock::now() - _start)
+                              .count());
+    }
+
+    ScopedTimer(const ScopedTimer &) = delete;
+    ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+   private:
+    Histogram &_histogram;                              // Histogram of the elapsed times.
+    const std::chrono::steady_clock::time_point _start; // When timing started.
+};
+
+/// Named collection of metrics.
+///
+/// Metrics are created on first use and live as long as the registry, so callers look them up
+/// once, typically into a function-local static reference, and record without locking. Names
+/// follow the Prometheus conventions, e.g. "libcc_message_buffer_pushed_total".
+class MetricsRegistry {
+   public:
+    /// Returns the registry the containers of the library record to.
+    static MetricsRegistry &global();
+
+    /// Returns the counter with the specified name, creating it if needed.
+    ///
+    /// Arguments:
+    ///     name: the name of the counter.
+    ///     help: the description exported with the counter.
+    Counter &counter(const std::string &name, const std::string &help = "");
+
+    /// Returns the gauge with the specified name, creating it if needed.
+    ///
+    /// Arguments:
+    ///     name: the name of the gauge.
+    ///     help: the description exported with the gauge.
+    Gauge &gauge(const std::string &name, const std::string &help = "");
+
+    /// Returns the histogram with the specified name, creating it if needed.
+    ///
+    /// Arguments:
+    ///     name: the name of the histogram.
+    ///     help: the description exported with the histogram.
+    Histogram &histogram(const std::string &name, const std::string &help = "");
+
+    /// Renders a snapshot of every metric in the Prometheus text exposition format.
+    ///
+    /// Histograms are exported with a cumulative bucket for each non-empty bucket, labelled with
+    /// its largest value, followed by the +Inf bucket, the sum and the count.
+    std::string to_prometheus() const;
+
+    /// Writes a snapshot of every metric to a file in the Prometheus text exposition format.
+    ///
+    /// The snapshot is written to a temporary file renamed over the destination, so readers
+    /// never see a partial snapshot.
+    ///
+    /// Arguments:
+    ///     path: the path of the file.
+    ///
+    /// Returns:
+    ///     OK if the snapshot was written.
+    ///     ERROR if the file could not be written.
+    StatusOr<void> export_to(const std::string &path) const;
+
+   private:
+    /// A registered metric. Exactly one of the pointers is set.
+    struct Entry {
+        std::string help;
+        std::unique_ptr<Counter> counter;
+        std::unique_ptr<Gauge> gauge;
+        std::unique_ptr<Histogram> histogram;
+    };
+
+    /// Returns the entry with the specified name, creating it if needed. The caller must hold
+    /// the mutex.
+    Entry &entry(const std::string &name, const std::string &help);
+
+    mutable std::mutex _mutex;            // Guards the map, not the metrics.
+    std::map<std::string, Entry> _entries; // Metrics sorted by name.
+};
+
+}  // namespace ostp::libcc::utils
+
+#endif
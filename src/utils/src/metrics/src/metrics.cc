@@ -0,0 +1,137 @@
+#include "metrics.h"
+
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+
+namespace ostp::libcc::utils {
+
+// See metrics.h for documentation.
+
+uint64_t Histogram::quantile(double quantile) const {
+    std::array<uint64_t, BUCKETS> counts;
+    uint64_t total = 0;
+    for (std::size_t bucket = 0; bucket < BUCKETS; bucket++) {
+        counts[bucket] = bucket_count(bucket);
+        total += counts[bucket];
+    }
+    if (total == 0) {
+        return 0;
+    }
+
+    // Find the first bucket at which the cumulative count reaches the rank of the quantile.
+    const double rank = quantile <= 0 ? 1 : quantile >= 1 ? total : quantile * total;
+    uint64_t cumulative = 0;
+    for (std::size_t bucket = 0; bucket < BUCKETS; bucket++) {
+        cumulative += counts[bucket];
+        if (counts[bucket] > 0 && cumulative >= rank) {
+            return bucket_upper_bound(bucket);
+        }
+    }
+    return UINT64_MAX;
+}
+
+MetricsRegistry &MetricsRegistry::global() {
+    // Never destroyed so containers with static storage duration can record until exit.
+    static MetricsRegistry *registry = new MetricsRegistry();
+    return *registry;
+}
+
+MetricsRegistry::Entry &MetricsRegistry::entry(const std::string &name, const std::string &help) {
+    Entry &entry = _entries[name];
+    if (entry.help.empty()) {
+        entry.help = help;
+    }
+    return entry;
+}
+
+Counter &MetricsRegistry::counter(const std::string &name, const std::string &help) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    Entry &entry = this->entry(name, help);
+    if (entry.gauge || entry.histogram) {
+        throw std::runtime_error("Metric " + name + " is not a counter");
+    }
+    if (!entry.counter) {
+        entry.counter = std::make_unique<Counter>();
+    }
+    return *entry.counter;
+}
+
+Gauge &MetricsRegistry::gauge(const std::string &name, const std::string &help) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    Entry &entry = this->entry(name, help);
+    if (entry.counter || entry.histogram) {
+        throw std::runtime_error("Metric " + name + " is not a gauge");
+    }
+    if (!entry.gauge) {
+        entry.gauge = std::make_unique<Gauge>();
+    }
+    return *entry.gauge;
+}
+
+Histogram &MetricsRegistry::histogram(const std::string &name, const std::string &help) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    Entry &entry = this->entry(name, help);
+    if (entry.counter || entry.gauge) {
+        throw std::runtime_error("Metric " + name + " is not a histogram");
+    }
+    if (!entry.histogram) {
+        entry.histogram = std::make_unique<Histogram>();
+    }
+    return *entry.histogram;
+}
+
+std::string MetricsRegistry::to_prometheus() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    std::string out;
+    for (const auto &[name, entry] : _entries) {
+        if (!entry.help.empty()) {
+            out += "# HELP " + name + " " + entry.help + "\n";
+        }
+        if (entry.counter) {
+            out += "# TYPE " + name + " counter\n";
+            out += name + " " + std::to_string(entry.counter->value()) + "\n";
+        } else if (entry.gauge) {
+            out += "# TYPE " + name + " gauge\n";
+            out += name + " " + std::to_string(entry.gauge->value()) + "\n";
+        } else if (entry.histogram) {
+            out += "# TYPE " + name + " histogram\n";
+            uint64_t cumulative = 0;
+            for (std::size_t bucket = 0; bucket < Histogram::BUCKETS; bucket++) {
+                const uint64_t count = entry.histogram->bucket_count(bucket);
+                if (count == 0) {
+                    continue;
+                }
+                cumulative += count;
+                out += name + "_bucket{le=\"" +
+                       std::to_string(Histogram::bucket_upper_bound(bucket)) + "\"} " +
+                       std::to_string(cumulative) + "\n";
+            }
+            out += name + "_bucket{le=\"+Inf\"} " + std::to_string(cumulative) + "\n";
+            out += name + "_sum " + std::to_string(entry.histogram->sum()) + "\n";
+            out += name + "_count " + std::to_string(cumulative) + "\n";
+        }
+    }
+    return out;
+}
+
+StatusOr<void> MetricsRegistry::export_to(const std::string &path) const {
+    const std::string snapshot = to_prometheus();
+    const std::string temporary = path + ".tmp";
+    FILE *file = fopen(temporary.c_str(), "w");
+    if (file == nullptr) {
+        return {Status::ERROR, "Cannot open the metrics file."};
+    }
+    const bool written = fwrite(snapshot.data(), 1, snapshot.size(), file) == snapshot.size();
+    if (fclose(file) != 0 || !written) {
+        std::remove(temporary.c_str());
+        return {Status::ERROR, "Cannot write the metrics file."};
+    }
+    if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+        std::remove(temporary.c_str());
+        return {Status::ERROR, "Cannot replace the metrics file."};
+    }
+    return {};
+}
+
+}  // namespace ostp::libcc::utils
@@ -0,0 +1,137 @@
+#include "metrics.h"
+
+#include <unistd.h>
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "logger.h"
+#include "status.h"
+#include "testing.h"
+
+using ostp::libcc::utils::Counter;
+using ostp::libcc::utils::Gauge;
+using ostp::libcc::utils::Histogram;
+using ostp::libcc::utils::MetricsRegistry;
+using ostp::libcc::utils::Status;
+
+// Buckets are contiguous and cover every value.
+static_assert(Histogram::bucket_of(0) == 0);
+static_assert(Histogram::bucket_of(Histogram::SUB_BUCKETS) == Histogram::SUB_BUCKETS);
+static_assert(Histogram::bucket_of(UINT64_MAX) == Histogram::BUCKETS - 1);
+
+START_SUITE(Metrics_Tests)
+
+START_TEST(CounterSumsThreads) {
+    Counter counter;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; t++) {
+        threads.emplace_back([&counter]() {
+            for (int i = 0; i < 10000; i++) {
+                counter.add();
+            }
+        });
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+    TEST(counter.value() == 80000);
+}
+END_TEST
+
+START_TEST(GaugeAddsAndSets) {
+    Gauge gauge;
+    gauge.add(5);
+    gauge.add(-2);
+    TEST(gauge.value() == 3);
+    gauge.set(-7);
+    TEST(gauge.value() == -7);
+}
+END_TEST
+
+START_TEST(HistogramBucketsBoundValues) {
+    const uint64_t values[] = {0, 1, 7, 8, 9, 100, 1000, 123456789, uint64_t{1} << 40, UINT64_MAX};
+    for (uint64_t value : values) {
+        const std::size_t bucket = Histogram::bucket_of(value);
+        ASSERT(Histogram::bucket_lower_bound(bucket) <= value);
+        ASSERT(value <= Histogram::bucket_upper_bound(bucket));
+
+        // The width of a bucket is at most 1 / SUB_BUCKETS of its values.
+        const uint64_t width =
+            Histogram::bucket_upper_bound(bucket) - Histogram::bucket_lower_bound(bucket);
+        ASSERT(width <= Histogram::bucket_lower_bound(bucket) / Histogram::SUB_BUCKETS);
+    }
+    for (std::size_t bucket = 0; bucket + 1 < Histogram::BUCKETS; bucket++) {
+        ASSERT(Histogram::bucket_upper_bound(bucket) + 1 ==
+               Histogram::bucket_lower_bound(bucket + 1));
+    }
+}
+END_TEST
+
+START_TEST(HistogramQuantiles) {
+    Histogram histogram;
+    TEST(histogram.quantile(0.5) == 0);
+    for (uint64_t value = 1; value <= 1000; value++) {
+        histogram.record(value);
+    }
+    TEST(histogram.count() == 1000);
+    TEST(histogram.sum() == 500500);
+
+    // Quantiles are within the relative error of a bucket.
+    const uint64_t median = histogram.quantile(0.5);
+    TEST(median >= 500 && median <= 500 + 500 / Histogram::SUB_BUCKETS);
+    const uint64_t p99 = histogram.quantile(0.99);
+    TEST(p99 >= 990 && p99 <= 990 + 990 / Histogram::SUB_BUCKETS);
+    TEST(histogram.quantile(1) >= 1000);
+}
+END_TEST
+
+START_TEST(RegistryReturnsSameMetric) {
+    MetricsRegistry registry;
+    Counter &counter = registry.counter("requests_total", "Requests.");
+    counter.add(2);
+    TEST(&registry.counter("requests_total") == &counter);
+
+    bool thrown = false;
+    try {
+        registry.gauge("requests_total");
+    } catch (const std::runtime_error &) {
+        thrown = true;
+    }
+    TEST(thrown);
+}
+END_TEST
+
+START_TEST(ExportsPrometheusText) {
+    MetricsRegistry registry;
+    registry.counter("requests_total", "Requests.").add(3);
+    registry.gauge("depth").add(-1);
+    Histogram &latency = registry.histogram("latency_ns");
+    latency.record(5);
+    latency.record(5);
+    latency.record(100);
+
+    const std::string text = registry.to_prometheus();
+    TEST(text.find("# HELP requests_total Requests.\n# TYPE requests_total counter\n"
+                   "requests_total 3\n") != std::string::npos);
+    TEST(text.find("# TYPE depth gauge\ndepth -1\n") != std::string::npos);
+    TEST(text.find("latency_ns_bucket{le=\"5\"} 2\n") != std::string::npos);
+    TEST(text.find("latency_ns_bucket{le=\"+Inf\"} 3\n") != std::string::npos);
+    TEST(text.find("latency_ns_sum 110\nlatency_ns_count 3\n") != std::string::npos);
+
+    const std::string path = "/tmp/metrics_test_" + std::to_string(getpid()) + ".prom";
+    TEST(registry.export_to(path).ok());
+    std::ifstream file(path);
+    std::stringstream contents;
+    contents << file.rdbuf();
+    TEST(contents.str() == text);
+    unlink(path.c_str());
+
+    TEST(registry.export_to("/nonexistent/metrics.prom").status() == Status::ERROR);
+}
+END_TEST
+
+END_SUITE
@@ -1,62 +1,364 @@
 #ifndef LIBCC_STATUS_OR_H
 #define LIBCC_STATUS_OR_H
 
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
 #include "status.h"
 
 namespace ostp::libcc::utils {
-/// Represents the status of an operation and the result of that operation.
+
 template <typename T>
-struct StatusOr {
-    /// The status of the operation.
-    const Status status;
+class StatusOr;
 
-    /// The status message of the operation.
-    const char *status_message;
+namespace status_or_internal {
 
-    /// The result of the operation.
-    T result;
+/// Whether a type is a StatusOr.
+template <typename T>
+struct is_status_or : std::false_type {};
+
+template <typename T>
+struct is_status_or<StatusOr<T>> : std::true_type {};
 
-    /// Constructs a StatusOr with the given status and result.
+}  // namespace status_or_internal
+
+/// Represents the status of an operation and the result of that operation.
+///
+/// The result only exists if the status is OK. It shares its storage with the status message, so
+/// an error never constructs a T and is represented by the status and a single pointer. The
+/// message must be a string with static storage duration such as a literal. A StatusOr of a
+/// trivially copyable type is itself trivially copyable.
+template <typename T>
+class [[nodiscard]] StatusOr {
+   public:
+    /// Constructs a successful StatusOr holding the specified result.
     ///
     /// Arguments:
-    ///     status: The status of the operation.
     ///     result: The result of the operation.
-    StatusOr(const Status status, const char *status_message, T &&result)
-        : status(status), result(std::move(result)), status_message(status_message) {}
+    StatusOr(const T &result) : _result(result), _status(Status::OK) {}
+
+    /// Constructs a successful StatusOr holding the specified result.
+    ///
+    /// Arguments:
+    ///     result: The result of the operation.
+    StatusOr(T &&result) : _result(std::move(result)), _status(Status::OK) {}
+
+    /// Constructs a successful StatusOr constructing the result in place.
+    ///
+    /// Arguments:
+    ///     args: The arguments of the constructor of the result.
+    template <typename... Args>
+    explicit StatusOr(std::in_place_t, Args &&...args)
+        : _result(std::forward<Args>(args)...), _status(Status::OK) {}
+
+    /// Constructs a failed StatusOr.
+    ///
+    /// Arguments:
+    ///     status: The status of the operation. OK is taken as ERROR, since there is no result.
+    ///     status_message: A static message describing the status.
+    StatusOr(const Status status, const char *status_message)
+        : _message(status_message), _status(status == Status::OK ? Status::ERROR : status) {}
+
+    StatusOr(const StatusOr &) requires std::is_trivially_copy_constructible_v<T> = default;
+    StatusOr(const StatusOr &other) requires(!std::is_trivially_copy_constructible_v<T> &&
+                                             std::is_copy_constructible_v<T>)
+        : _status(other._status) {
+        if (other.ok()) {
+            std::construct_at(&_result, other._result);
+        } else {
+            _message = other._message;
+        }
+    }
+
+    StatusOr(StatusOr &&) requires std::is_trivially_move_constructible_v<T> = default;
+    StatusOr(StatusOr &&other) noexcept(std::is_nothrow_move_constructible_v<T>) requires(
+        !std::is_trivially_move_constructible_v<T> && std::is_move_constructible_v<T>)
+        : _status(other._status) {
+        if (other.ok()) {
+            std::construct_at(&_result, std::move(other._result));
+        } else {
+            _message = other._message;
+        }
+    }
+
+    StatusOr &operator=(const StatusOr &) requires std::is_trivially_copy_assignable_v<T> &&
+        std::is_trivially_copy_constructible_v<T> && std::is_trivially_destructible_v<T>
+    = default;
+    StatusOr &operator=(const StatusOr &other) requires(
+        !(std::is_trivially_copy_assignable_v<T> && std::is_trivially_copy_constructible_v<T> &&
+          std::is_trivially_destructible_v<T>) &&
+        std::is_copy_constructible_v<T>) {
+        if (this != &other) {
+            reset();
+            // Hold no result until it is constructed in case constructing it throws.
+            _status = Status::ERROR;
+            _message = nullptr;
+            if (other.ok()) {
+                std::construct_at(&_result, other._result);
+            } else {
+                _message = other._message;
+            }
+            _status = other._status;
+        }
+        return *this;
+    }
+
+    StatusOr &operator=(StatusOr &&) requires std::is_trivially_move_assignable_v<T> &&
+        std::is_trivially_move_constructible_v<T> && std::is_trivially_destructible_v<T>
+    = default;
+    StatusOr &operator=(StatusOr &&other) noexcept(std::is_nothrow_move_constructible_v<T>) requires(
+        !(std::is_trivially_move_assignable_v<T> && std::is_trivially_move_constructible_v<T> &&
+          std::is_trivially_destructible_v<T>) &&
+        std::is_move_constructible_v<T>) {
+        if (this != &other) {
+            reset();
+            // Hold no result until it is constructed in case constructing it throws.
+            _status = Status::ERROR;
+            _message = nullptr;
+            if (other.ok()) {
+                std::construct_at(&_result, std::move(other._result));
+            } else {
+                _message = other._message;
+            }
+            _status = other._status;
+        }
+        return *this;
+    }
+
+    ~StatusOr() requires std::is_trivially_destructible_v<T> = default;
+    ~StatusOr() { reset(); }
 
     // Methods to check the status of the operation.
 
     /// Returns true if the operation was successful.
-    bool ok() const { return status == Status::OK; }
+    bool ok() const { return _status == Status::OK; }
 
     /// Returns true if the operation failed.
-    bool failed() const { return status != Status::OK; }
-};
+    bool failed() const { return _status != Status::OK; }
+
+    /// Returns the status of the operation.
+    Status status() const { return _status; }
+
+    /// Returns the message of a failed operation or nullptr if it succeeded.
+    const char *status_message() const { return ok() ? nullptr : _message; }
+
+    // Methods to access the result of the operation.
+
+    /// Returns the result of the operation.
+    ///
+    /// Throws:
+    ///     std::runtime_error if the operation failed.
+    T &value() & {
+        check();
+        return _result;
+    }
+    const T &value() const & {
+        check();
+        return _result;
+    }
+    T &&value() && {
+        check();
+        return std::move(_result);
+    }
+
+    /// Returns the result of the operation without checking that it succeeded.
+    T &operator*() & { return _result; }
+    const T &operator*() const & { return _result; }
+    T &&operator*() && { return std::move(_result); }
+    T *operator->() { return &_result; }
+    const T *operator->() const { return &_result; }
+
+    /// Returns the result of the operation or the specified value if it failed.
+    ///
+    /// Arguments:
+    ///     default_value: The value returned if the operation failed.
+    template <typename U>
+    T value_or(U &&default_value) const & {
+        return ok() ? _result : static_cast<T>(std::forward<U>(default_value));
+    }
+    template <typename U>
+    T value_or(U &&default_value) && {
+        return ok() ? std::move(_result) : static_cast<T>(std::forward<U>(default_value));
+    }
+
+    // Monadic operations.
+
+    /// Chains an operation that can fail.
+    ///
+    /// Arguments:
+    ///     f: Callable taking the result and returning a StatusOr.
+    ///
+    /// Returns:
+    ///     the StatusOr returned by f or this failure converted to its type.
+    template <typename F>
+    auto and_then(F &&f) & {
+        return and_then_impl(*this, std::forward<F>(f));
+    }
+    template <typename F>
+    auto and_then(F &&f) const & {
+        return and_then_impl(*this, std::forward<F>(f));
+    }
+    template <typename F>
+    auto and_then(F &&f) && {
+        return and_then_impl(std::move(*this), std::forward<F>(f));
+    }
+
+    /// Transforms the result of a successful operation.
+    ///
+    /// Arguments:
+    ///     f: Callable taking the result and returning the new result.
+    ///
+    /// Returns:
+    ///     a StatusOr holding the value returned by f or this failure.
+    template <typename F>
+    auto transform(F &&f) & {
+        return transform_impl(*this, std::forward<F>(f));
+    }
+    template <typename F>
+    auto transform(F &&f) const & {
+        return transform_impl(*this, std::forward<F>(f));
+    }
+    template <typename F>
+    auto transform(F &&f) && {
+        return transform_impl(std::move(*this), std::forward<F>(f));
+    }
+
+   private:
+    template <typename U>
+    friend class StatusOr;
+
+    /// Destroys the result if there is one.
+    void reset() {
+        if (ok()) {
+            std::destroy_at(&_result);
+        }
+    }
+
+    /// Throws if the operation failed.
+    void check() const {
+        if (!ok()) {
+            throw std::runtime_error(_message != nullptr ? _message : "StatusOr has no value");
+        }
+    }
+
+    template <typename Self, typename F>
+    static auto and_then_impl(Self &&self, F &&f) {
+        using Result = std::remove_cvref_t<
+            std::invoke_result_t<F, decltype((std::forward<Self>(self)._result))>>;
+        static_assert(status_or_internal::is_status_or<Result>::value,
+                      "and_then requires a callable returning a StatusOr");
+        if (!self.ok()) {
+            return Result(self._status, self._message);
+        }
+        return std::invoke(std::forward<F>(f), std::forward<Self>(self)._result);
+    }
+
+    template <typename Self, typename F>
+    static auto transform_impl(Self &&self, F &&f) {
+        using U = std::remove_cv_t<
+            std::invoke_result_t<F, decltype((std::forward<Self>(self)._result))>>;
+        if (!self.ok()) {
+            return StatusOr<U>(self._status, self._message);
+        }
+        if constexpr (std::is_void_v<U>) {
+            std::invoke(std::forward<F>(f), std::forward<Self>(self)._result);
+            return StatusOr<U>();
+        } else {
+            return StatusOr<U>(std::invoke(std::forward<F>(f), std::forward<Self>(self)._result));
+        }
+    }
+
+    /// The result of a successful operation or the message of a failed one.
+    union {
+        T _result;
+        const char *_message;
+    };
 
-/// Specialization of StatusOr for void.
-template <>
-struct StatusOr<void> {
     /// The status of the operation.
-    const Status status;
+    Status _status;
+};
 
-    /// The status message of the operation.
-    const char *status_message;
+/// Specialization of StatusOr for operations without a result.
+template <>
+class [[nodiscard]] StatusOr<void> {
+   public:
+    /// Constructs a successful StatusOr.
+    StatusOr() : _status(Status::OK), _message(nullptr) {}
 
     /// Constructs a StatusOr with the given status.
     ///
     /// Arguments:
     ///     status: The status of the operation.
+    ///     status_message: A static message describing the status.
     StatusOr(const Status status, const char *status_message)
-        : status(status), status_message(status_message) {}
+        : _status(status), _message(status_message) {}
 
     // Methods to check the status of the operation.
 
     /// Returns true if the operation was successful.
-    bool ok() const { return status == Status::OK; }
+    bool ok() const { return _status == Status::OK; }
 
     /// Returns true if the operation failed.
-    bool failed() const { return status != Status::OK; }
+    bool failed() const { return _status != Status::OK; }
+
+    /// Returns the status of the operation.
+    Status status() const { return _status; }
+
+    /// Returns the message of the operation.
+    const char *status_message() const { return _message; }
+
+    // Monadic operations.
+
+    /// Chains an operation that can fail.
+    ///
+    /// Arguments:
+    ///     f: Callable taking no arguments and returning a StatusOr.
+    ///
+    /// Returns:
+    ///     the StatusOr returned by f or this failure converted to its type.
+    template <typename F>
+    auto and_then(F &&f) const {
+        using Result = std::remove_cvref_t<std::invoke_result_t<F>>;
+        static_assert(status_or_internal::is_status_or<Result>::value,
+                      "and_then requires a callable returning a StatusOr");
+        if (!ok()) {
+            return Result(_status, _message);
+        }
+        return std::invoke(std::forward<F>(f));
+    }
+
+    /// Produces a result after a successful operation.
+    ///
+    /// Arguments:
+    ///     f: Callable taking no arguments and returning the result.
+    ///
+    /// Returns:
+    ///     a StatusOr holding the value returned by f or this failure.
+    template <typename F>
+    auto transform(F &&f) const {
+        using U = std::remove_cv_t<std::invoke_result_t<F>>;
+        if (!ok()) {
+            return StatusOr<U>(_status, _message);
+        }
+        if constexpr (std::is_void_v<U>) {
+            std::invoke(std::forward<F>(f));
+            return StatusOr<U>();
+        } else {
+            return StatusOr<U>(std::invoke(std::forward<F>(f)));
+        }
+    }
+
+   private:
+    /// The status of the operation.
+    Status _status;
+
+    /// The status message of the operation.
+    const char *_message;
 };
+
 }  // namespace ostp::libcc::utils
 
 #endif
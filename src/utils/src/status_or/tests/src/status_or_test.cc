@@ -0,0 +1,149 @@
+#include "status_or.h"
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+#include "logger.h"
+#include "status.h"
+#include "testing.h"
+
+using ostp::libcc::utils::Status;
+using ostp::libcc::utils::StatusOr;
+
+// An error only costs the status and the message pointer.
+static_assert(sizeof(StatusOr<std::unique_ptr<int>>) == 2 * sizeof(void *));
+
+// Trivially copyable results keep StatusOr trivially copyable.
+static_assert(std::is_trivially_copyable_v<StatusOr<int>>);
+static_assert(!std::is_copy_constructible_v<StatusOr<std::unique_ptr<int>>>);
+
+/// Type counting its live instances to check that errors construct none.
+struct Counted {
+    static inline int live = 0;
+    Counted() { live++; }
+    Counted(const Counted &) { live++; }
+    ~Counted() { live--; }
+};
+
+/// Type counting its live instances whose copies throw on demand.
+struct ThrowingCopy {
+    static inline int live = 0;
+    static inline bool fail = false;
+    ThrowingCopy() { live++; }
+    ThrowingCopy(const ThrowingCopy &) {
+        if (fail) {
+            throw std::runtime_error("copy failed");
+        }
+        live++;
+    }
+    ~ThrowingCopy() { live--; }
+};
+
+START_SUITE(StatusOr_Tests)
+
+START_TEST(HoldsResultOnSuccess) {
+    StatusOr<std::string> result(std::string("abc"));
+    TEST(result.ok());
+    TEST(result.status() == Status::OK);
+    TEST(result.status_message() == nullptr);
+    TEST(*result == "abc");
+    TEST(result->size() == 3);
+}
+END_TEST
+
+START_TEST(ErrorDoesNotConstructResult) {
+    {
+        StatusOr<Counted> result(Status::CLOSED, "closed");
+        TEST(result.failed());
+        TEST(Counted::live == 0);
+        TEST(std::string(result.status_message()) == "closed");
+    }
+    {
+        StatusOr<Counted> result(std::in_place);
+        TEST(Counted::live == 1);
+    }
+    TEST(Counted::live == 0);
+}
+END_TEST
+
+START_TEST(OkWithoutResultIsAnError) {
+    StatusOr<Counted> result(Status::OK, "no result");
+    TEST(result.failed());
+    TEST(result.status() == Status::ERROR);
+    TEST(std::string(result.status_message()) == "no result");
+    TEST(Counted::live == 0);
+}
+END_TEST
+
+START_TEST(MovesOnlyPayloads) {
+    StatusOr<std::unique_ptr<int>> result(std::make_unique<int>(3));
+    StatusOr<std::unique_ptr<int>> moved(std::move(result));
+    TEST(moved.ok());
+    TEST(**moved == 3);
+
+    moved = StatusOr<std::unique_ptr<int>>(Status::TIMEOUT, "timeout");
+    TEST(moved.status() == Status::TIMEOUT);
+}
+END_TEST
+
+START_TEST(ThrowingAssignmentHoldsNoResult) {
+    {
+        StatusOr<ThrowingCopy> target(std::in_place);
+        const StatusOr<ThrowingCopy> source(std::in_place);
+        ThrowingCopy::fail = true;
+        bool thrown = false;
+        try {
+            target = source;
+        } catch (const std::runtime_error &) {
+            thrown = true;
+        }
+        ThrowingCopy::fail = false;
+        TEST(thrown);
+        TEST(target.failed());
+        TEST(ThrowingCopy::live == 1);
+    }
+    // The failed target is not destroyed a second time.
+    TEST(ThrowingCopy::live == 0);
+}
+END_TEST
+
+START_TEST(ValueOrReturnsDefaultOnError) {
+    StatusOr<int> ok(1);
+    StatusOr<int> error(Status::EMPTY, "empty");
+    TEST(ok.value_or(2) == 1);
+    TEST(error.value_or(2) == 2);
+
+    bool thrown = false;
+    try {
+        [[maybe_unused]] int value = error.value();
+    } catch (const std::runtime_error &) {
+        thrown = true;
+    }
+    TEST(thrown);
+}
+END_TEST
+
+START_TEST(ChainsOperations) {
+    auto half = [](int value) -> StatusOr<int> {
+        if (value % 2 != 0) {
+            return {Status::ERROR, "odd"};
+        }
+        return value / 2;
+    };
+
+    TEST(*StatusOr<int>(8).and_then(half).and_then(half) == 2);
+    TEST(StatusOr<int>(6).and_then(half).and_then(half).status() == Status::ERROR);
+    TEST(StatusOr<int>(Status::CLOSED, "closed").and_then(half).status() == Status::CLOSED);
+
+    auto text = StatusOr<int>(4).transform([](int value) { return std::to_string(value); });
+    TEST(*text == "4");
+    TEST(StatusOr<void>().transform([]() { return 5; }).value_or(0) == 5);
+    TEST(StatusOr<void>(Status::CLOSED, "closed")
+             .and_then([]() { return StatusOr<int>(1); })
+             .status() == Status::CLOSED);
+}
+END_TEST
+
+END_SUITE
@@ -1,53 +1,386 @@
 #ifndef LIBCC_TESTING_H
 #define LIBCC_TESTING_H
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
 #include <cstring>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
 
 #include "logger.h"
 
 #define __FILENAME__ (strrchr(__FILE__, '/') ? strrchr(__FILE__, '/') + 1 : __FILE__)
 
-#define START_SUITE(name)                      \
-    int main() {                               \
-        const std::string _suite_name = #name; \
-        int _tests_failed = 0;                 \
-        int _tests_passed = 0;
+namespace ostp::libcc::utils {
 
-#define START_TEST(name) [&_tests_failed, &_tests_passed]() {            \
-        const std::string _test_name = #name;       \
-        bool _failed = false;
-#define ASSERT(expr)                                                                  \
-    if (!(expr)) {                                                                    \
-        ostp::libcc::utils::log_error("Assertion '" #expr "' Failed!", __FILENAME__); \
-        _tests_failed++;                                                              \
-        return;                                                                       \
+/// State of a running test shared by the assertions of its body.
+class TestContext {
+   public:
+    /// Marks the test as failed.
+    ///
+    /// Arguments:
+    ///     message: the description of the failure.
+    void fail(std::string message) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _failed = true;
+        _failures.push_back(std::move(message));
+    }
+
+    /// Returns whether the test failed.
+    bool failed() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _failed;
+    }
+
+    /// Returns the descriptions of the failures.
+    std::vector<std::string> failures() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _failures;
+    }
+
+   private:
+    mutable std::mutex _mutex;           // Guards the failures; assertions may run on any thread.
+    bool _failed = false;                // Whether the test failed.
+    std::vector<std::string> _failures;  // Descriptions of the failures.
+};
+
+/// Registers the tests of a suite and runs them on a pool of worker threads.
+///
+/// Tests run in parallel unless registered as serial, in which case they run one at a time
+/// after the parallel ones, e.g. because they change the sinks of the logger. Each test is timed
+/// and fails if it outlives its timeout; a timed out test cannot be stopped, so the suite reports
+/// it, replaces its worker and exits without waiting for it once the other tests finish.
+///
+/// Command line options:
+///     --filter=<text>      only runs the tests whose name contains the text.
+///     --jobs=<n>           number of worker threads (default: the number of cores).
+///     --timeout-ms=<n>     timeout of each test in milliseconds (default 60000).
+///     --junit=<path>       writes the results as JUnit XML.
+///     --list               prints the names of the tests without running them.
+class TestSuite {
+   public:
+    /// Body of a test.
+    using Body = std::function<void(TestContext &)>;
+
+    /// Constructs a suite parsing its options from the command line.
+    ///
+    /// Arguments:
+    ///     name: the name of the suite.
+    ///     file: the name of the file of the suite, used as the sender of its logs.
+    ///     argc: the number of command line arguments.
+    ///     argv: the command line arguments.
+    TestSuite(const char *name, const char *file, int argc, char **argv)
+        : _name(name), _file(file) {
+        const unsigned cores = std::thread::hardware_concurrency();
+        _jobs = cores > 0 ? static_cast<int>(cores) : 1;
+        for (int i = 1; i < argc; i++) {
+            std::string_view arg(argv[i]);
+            if (arg.starts_with("--filter=")) {
+                _filter = arg.substr(9);
+            } else if (arg.starts_with("--jobs=")) {
+                _jobs = std::max(1, std::atoi(argv[i] + 7));
+            } else if (arg.starts_with("--timeout-ms=")) {
+                _timeout = std::chrono::milliseconds(std::atoi(argv[i] + 13));
+            } else if (arg.starts_with("--junit=")) {
+                _junit_path = arg.substr(8);
+            } else if (arg == "--list") {
+                _list = true;
+            }
+        }
+    }
+
+    /// Registers a test.
+    ///
+    /// Arguments:
+    ///     name: the name of the test.
+    ///     serial: whether the test must not run concurrently with other tests.
+    ///     body: the body of the test.
+    void add(const char *name, bool serial, Body body) {
+        if (_filter.empty() || std::string_view(name).find(_filter) != std::string_view::npos) {
+            _tests.push_back(std::make_unique<Test>(name, serial, std::move(body)));
+        }
+    }
+
+    /// Runs the registered tests and reports their results.
+    ///
+    /// Returns:
+    ///     the exit code of the test program.
+    int run() {
+        if (_list) {
+            for (const auto &test : _tests) {
+                fprintf(stdout, "%s\n", test->name);
+            }
+            return 0;
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        std::vector<Test *> parallel;
+        std::vector<Test *> serial;
+        for (const auto &test : _tests) {
+            (test->serial ? serial : parallel).push_back(test.get());
+        }
+        const bool hung = !run_pool(parallel, _jobs) | !run_pool(serial, 1);
+        const double seconds =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        int failed = 0;
+        for (const auto &test : _tests) {
+            failed += test->state != State::PASSED;
+        }
+        write_junit(seconds);
+        if (failed > 0) {
+            LOG_ERROR(_file, "Suite '{}' failed! {} of {} tests failed in {} s", _name, failed,
+                      _tests.size(), seconds);
+        } else {
+            LOG_OK(_file, "Suite '{}' passed! {} tests in {} s", _name, _tests.size(), seconds);
+        }
+
+        // Threads stuck in timed out tests cannot be joined, so leave without destroying them.
+        if (hung) {
+            flush_logs();
+            std::_Exit(1);
+        }
+        return failed > 0 ? 1 : 0;
+    }
+
+   private:
+    /// Progress of a test.
+    enum class State { PENDING, RUNNING, PASSED, FAILED, TIMED_OUT };
+
+    /// A registered test and its result.
+    struct Test {
+        Test(const char *name, bool serial, Body body)
+            : name(name), serial(serial), body(std::move(body)) {}
+
+        const char *name;
+        const bool serial;
+        const Body body;
+        TestContext context;
+        State state = State::PENDING;
+        std::chrono::steady_clock::time_point start;
+        std::thread::id runner;
+        double seconds = 0;
+    };
+
+    /// Runs tests on the specified number of workers until each finished or timed out.
+    ///
+    /// Arguments:
+    ///     tests: the tests to run.
+    ///     jobs: the maximum number of tests running at once.
+    ///
+    /// Returns:
+    ///     false if a test timed out, in which case its worker was detached.
+    bool run_pool(const std::vector<Test *> &tests, int jobs) {
+        if (tests.empty()) {
+            return true;
+        }
+
+        // Workers share the index of the next test and report through the finished count. The
+        // pool outlives this call for workers stuck in timed out tests.
+        struct Pool {
+            std::vector<Test *> tests;
+            std::mutex mutex;
+            std::condition_variable done;
+            std::size_t next = 0;
+            std::size_t finished = 0;
+        };
+        auto pool = std::make_shared<Pool>();
+        pool->tests = tests;
+        auto worker = [this, pool]() {
+            std::unique_lock<std::mutex> lock(pool->mutex);
+            while (pool->next < pool->tests.size()) {
+                Test &test = *pool->tests[pool->next++];
+                test.state = State::RUNNING;
+                test.start = std::chrono::steady_clock::now();
+                test.runner = std::this_thread::get_id();
+                lock.unlock();
+                execute(test);
+                lock.lock();
+                if (test.state == State::TIMED_OUT) {
+                    // The pool replaced this detached worker.
+                    return;
+                }
+                test.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                                             test.start)
+                                   .count();
+                test.state = test.context.failed() ? State::FAILED : State::PASSED;
+                report(test);
+                pool->finished++;
+                pool->done.notify_all();
+            }
+        };
+
+        std::vector<std::thread> workers;
+        for (int i = 0; i < std::min<int>(jobs, tests.size()); i++) {
+            workers.emplace_back(worker);
+        }
+
+        // Wait for the tests, timing out those running for too long.
+        bool hung = false;
+        std::unique_lock<std::mutex> lock(pool->mutex);
+        while (pool->finished < tests.size()) {
+            pool->done.wait_for(lock, std::chrono::milliseconds(10));
+            const auto now = std::chrono::steady_clock::now();
+            for (Test *test : tests) {
+                if (test->state == State::RUNNING && now - test->start > _timeout) {
+                    test->state = State::TIMED_OUT;
+                    test->seconds = std::chrono::duration<double>(now - test->start).count();
+                    test->context.fail("Timed out");
+                    report(*test);
+                    pool->finished++;
+                    hung = true;
+
+                    // Detach the stuck worker and start a new one in its place.
+                    for (std::thread &thread : workers) {
+                        if (thread.joinable() && thread.get_id() == test->runner) {
+                            thread.detach();
+                        }
+                    }
+                    workers.emplace_back(worker);
+                }
+            }
+        }
+        lock.unlock();
+
+        for (std::thread &thread : workers) {
+            if (thread.joinable()) {
+                thread.join();
+            }
+        }
+        return !hung;
+    }
+
+    /// Runs the body of a test, turning exceptions into failures.
+    void execute(Test &test) {
+        try {
+            test.body(test.context);
+        } catch (const std::exception &e) {
+            test.context.fail(std::string("Uncaught exception: ") + e.what());
+            LOG_ERROR(_file, "Test '{}' threw '{}'", test.name, e.what());
+        } catch (...) {
+            test.context.fail("Uncaught exception");
+            LOG_ERROR(_file, "Test '{}' threw an unknown exception", test.name);
+        }
+    }
+
+    /// Logs the result of a test.
+    void report(const Test &test) {
+        const long long ms = static_cast<long long>(test.seconds * 1000);
+        switch (test.state) {
+            case State::PASSED:
+                LOG_OK(_file, "Test '{}' passed in {} ms", test.name, ms);
+                break;
+            case State::TIMED_OUT:
+                LOG_ERROR(_file, "Test '{}' timed out after {} ms", test.name, ms);
+                break;
+            default:
+                LOG_ERROR(_file, "Test '{}' failed in {} ms", test.name, ms);
+                break;
+        }
+    }
+
+    /// Writes the results as JUnit XML if requested.
+    void write_junit(double seconds) {
+        if (_junit_path.empty()) {
+            return;
+        }
+        FILE *file = fopen(_junit_path.c_str(), "w");
+        if (file == nullptr) {
+            LOG_ERROR(_file, "Cannot open {}", _junit_path);
+            return;
+        }
+        int failures = 0;
+        for (const auto &test : _tests) {
+            failures += test->state != State::PASSED;
+        }
+        fprintf(file, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+        fprintf(file, "<testsuite name=\"%s\" tests=\"%zu\" failures=\"%d\" time=\"%.3f\">\n",
+                xml_escape(_name).c_str(), _tests.size(), failures, seconds);
+        for (const auto &test : _tests) {
+            fprintf(file, "  <testcase classname=\"%s\" name=\"%s\" time=\"%.3f\"",
+                    xml_escape(_name).c_str(), xml_escape(test->name).c_str(), test->seconds);
+            if (test->state == State::PASSED) {
+                fprintf(file, "/>\n");
+                continue;
+            }
+            fprintf(file, ">\n");
+            for (const std::string &failure : test->context.failures()) {
+                fprintf(file, "    <failure message=\"%s\"/>\n", xml_escape(failure).c_str());
+            }
+            fprintf(file, "  </testcase>\n");
+        }
+        fprintf(file, "</testsuite>\n");
+        fclose(file);
+    }
+
+    /// Escapes the special characters of XML attributes.
+    static std::string xml_escape(std::string_view text) {
+        std::string escaped;
+        for (char c : text) {
+            switch (c) {
+                case '&': escaped += "&amp;"; break;
+                case '<': escaped += "&lt;"; break;
+                case '>': escaped += "&gt;"; break;
+                case '"': escaped += "&quot;"; break;
+                default: escaped += c; break;
+            }
+        }
+        return escaped;
+    }
+
+    const char *_name;                        // Name of the suite.
+    const char *_file;                        // File of the suite.
+    std::string _filter;                      // Filter on test names.
+    int _jobs;                                // Number of worker threads.
+    std::chrono::milliseconds _timeout{60000}; // Timeout of each test.
+    std::string _junit_path;                  // JUnit XML output.
+    bool _list = false;                       // Whether to only list the tests.
+    std::vector<std::unique_ptr<Test>> _tests; // Registered tests in order.
+};
+
+}  // namespace ostp::libcc::utils
+
+#define START_SUITE(name)                                                              \
+    int main(int argc, char **argv) {                                                  \
+        ostp::libcc::utils::TestSuite _suite(#name, __FILENAME__, argc, argv);
+
+#define START_TEST(name)                                                               \
+    _suite.add(#name, false, [&](ostp::libcc::utils::TestContext & _test) {            \
+        [[maybe_unused]] const char *_test_name = #name;
+
+/// Starts a test that runs alone, for tests changing process-wide state such as log sinks.
+#define START_SERIAL_TEST(name)                                                        \
+    _suite.add(#name, true, [&](ostp::libcc::utils::TestContext & _test) {             \
+        [[maybe_unused]] const char *_test_name = #name;
+
+#define ASSERT(expr)                                                                   \
+    if (!(expr)) {                                                                     \
+        LOG_ERROR(__FILENAME__, "Assertion '{}' Failed!", #expr);                      \
+        _test.fail("Assertion '" #expr "' failed at line " + std::to_string(__LINE__)); \
+        return;                                                                        \
     }
 
 #define TEST(expr)                                                                     \
     if (!(expr)) {                                                                     \
-        _failed = true;                                                                \
-        ostp::libcc::utils::log_error("Expression '" #expr "' Failed!", __FILENAME__); \
-    }
-
-#define END_TEST                                                                          \
-    if (_failed) {                                                                        \
-        ostp::libcc::utils::log_error("Test '" + _test_name + "' failed!", __FILENAME__); \
-        _tests_failed++;                                                                  \
-    } else {                                                                              \
-        ostp::libcc::utils::log_ok("Test '" + _test_name + "' passed!", __FILENAME__);    \
-        _tests_passed++;                                                                  \
-    }                                                                                     \
-    }                                                                                     \
-    ();
-
-#define END_SUITE                                                                           \
-    if (_tests_failed) {                                                                    \
-        ostp::libcc::utils::log_error("Suite '" + _suite_name + "' failed!", __FILENAME__); \
-        return 1;                                                                           \
-    } else {                                                                                \
-        ostp::libcc::utils::log_ok("Suite '" + _suite_name + "' passed!", __FILENAME__);    \
-        return 0;                                                                           \
-    }                                                                                       \
+        LOG_ERROR(__FILENAME__, "Expression '{}' Failed!", #expr);                     \
+        _test.fail("Expression '" #expr "' failed at line " + std::to_string(__LINE__)); \
+    }
+
+#define END_TEST                                                                       \
+    });
+
+#define END_SUITE                                                                      \
+    return _suite.run();                                                               \
     }
 
 #endif
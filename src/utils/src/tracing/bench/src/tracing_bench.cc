@@ -0,0 +1,34 @@
+#include "tracing.h"
+
+#include "benchmarking.h"
+
+using ostp::libcc::utils::TraceSpan;
+
+START_BENCH_SUITE(Tracing)
+
+START_BENCH(StoppedSpan) {
+    ostp::libcc::utils::stop_tracing();
+    BENCH_LOOP { TraceSpan span("bench"); }
+}
+END_BENCH
+
+START_BENCH(Span) {
+    ostp::libcc::utils::clear_trace();
+    ostp::libcc::utils::start_tracing(1 << 20);
+    BENCH_LOOP { TraceSpan span("bench"); }
+    ostp::libcc::utils::stop_tracing();
+}
+END_BENCH
+
+START_BENCH(SpanWithFlow) {
+    ostp::libcc::utils::clear_trace();
+    ostp::libcc::utils::start_tracing(1 << 20);
+    BENCH_LOOP {
+        TraceSpan span("bench");
+        span.flow_start(_iteration);
+    }
+    ostp::libcc::utils::stop_tracing();
+}
+END_BENCH
+
+END_BENCH_SUITE
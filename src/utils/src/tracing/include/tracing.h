@@ -0,0 +1,162 @@
+#ifndef LIBCC_TRACING_H
+#define LIBCC_TRACING_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+#include "status_or.h"
+
+namespace ostp::libcc::utils {
+
+/// Whether tracing is compiled in.
+///
+/// Configure with -DLIBCC_TRACING=ON to define LIBCC_TRACING. Otherwise Span is an empty type
+/// whose methods are inlined away, so instrumented code pays nothing.
+#ifdef LIBCC_TRACING
+inline constexpr bool tracing_compiled = true;
+#else
+inline constexpr bool tracing_compiled = false;
+#endif
+
+/// Kind of a trace event, named after its Chrome trace phase.
+enum class TracePhase : char {
+    /// A span with a start and a duration.
+    COMPLETE = 'X',
+
+    /// The start of a flow, bound to the span enclosing it.
+    FLOW_START = 's',
+
+    /// The end of a flow, bound to the span enclosing it.
+    FLOW_END = 'f',
+};
+
+/// A recorded trace event. Names and categories must have static storage duration.
+struct TraceEvent {
+    const char *name;
+    const char *category;
+    uint64_t timestamp_ns;
+    uint64_t duration_ns;
+    uint64_t flow_id;
+    TracePhase phase;
+};
+
+namespace tracing_internal {
+
+/// Whether events are recorded.
+extern std::atomic<bool> enabled;
+
+/// Returns the current time in nanoseconds on the clock of the trace.
+inline uint64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+/// Appends an event to the buffer of the calling thread, dropping it if the buffer is full.
+void record(const TraceEvent &event);
+
+}  // namespace tracing_internal
+
+/// Starts recording trace events.
+///
+/// Each thread records into its own buffer, allocated on its first event, which only that thread
+/// writes; events are published with a release store so dump_trace() can read them while threads
+/// keep recording. Once a buffer is full further events of its thread are dropped.
+///
+/// Arguments:
+///     events_per_thread: the capacity of buffers allocated from now on.
+void start_tracing(std::size_t events_per_thread = 1 << 16);
+
+/// Stops recording trace events. Recorded events are kept until clear_trace().
+void stop_tracing();
+
+/// Returns whether trace events are being recorded.
+inline bool tracing_enabled() { return tracing_internal::enabled.load(std::memory_order_relaxed); }
+
+/// Discards the recorded events. Must not be called while threads are recording.
+void clear_trace();
+
+/// Returns the number of events dropped because a buffer was full.
+uint64_t dropped_trace_events();
+
+/// Writes the recorded events in the Chrome trace event format, which Perfetto and
+/// chrome://tracing open.
+///
+/// Arguments:
+///     path: the path of the JSON file.
+///
+/// Returns:
+///     OK if the trace was written.
+///     ERROR if the file could not be written.
+StatusOr<void> dump_trace(const std::string &path);
+
+/// Records the span of its lifetime as a complete event, along with the flows it starts and
+/// ends.
+///
+/// A span constructed while tracing is stopped records nothing. Recording a span costs two clock
+/// reads and a store into the buffer of the calling thread.
+class TraceSpan {
+   public:
+    /// Starts a span.
+    ///
+    /// Arguments:
+    ///     name: the static name of the span.
+    ///     category: the static category of the span.
+    explicit TraceSpan(const char *name, const char *category = "libcc")
+        : _name(name), _category(category),
+          _start(tracing_enabled() ? tracing_internal::now_ns() : 0) {}
+
+    /// Ends the span.
+    ~TraceSpan() {
+        if (_start != 0) {
+            tracing_internal::record({_name, _category, _start, tracing_internal::now_ns() - _start,
+                                      0, TracePhase::COMPLETE});
+        }
+    }
+
+    TraceSpan(const TraceSpan &) = delete;
+    TraceSpan &operator=(const TraceSpan &) = delete;
+
+    /// Starts a flow from this span, e.g. to the span that will consume a pushed message.
+    ///
+    /// Arguments:
+    ///     id: the identifier shared by both ends of the flow.
+    void flow_start(uint64_t id) { flow(id, TracePhase::FLOW_START); }
+
+    /// Ends in this span a flow started by another one.
+    ///
+    /// Arguments:
+    ///     id: the identifier shared by both ends of the flow.
+    void flow_end(uint64_t id) { flow(id, TracePhase::FLOW_END); }
+
+   private:
+    /// Records one end of a flow at the current time.
+    void flow(uint64_t id, TracePhase phase) {
+        if (_start != 0) {
+            tracing_internal::record({_name, _category, tracing_internal::now_ns(), 0, id, phase});
+        }
+    }
+
+    const char *const _name;     // Name of the span.
+    const char *const _category; // Category of the span.
+    const uint64_t _start;       // Start in nanoseconds, or 0 if tracing was stopped.
+};
+
+/// Span used when tracing is not compiled in.
+class NullSpan {
+   public:
+    explicit NullSpan(const char *, const char * = "libcc") {}
+    void flow_start(uint64_t) {}
+    void flow_end(uint64_t) {}
+};
+
+/// Span to instrument code with: a TraceSpan if tracing is compiled in, a NullSpan otherwise.
+using Span = std::conditional_t<tracing_compiled, TraceSpan, NullSpan>;
+
+}  // namespace ostp::libcc::utils
+
+#endif
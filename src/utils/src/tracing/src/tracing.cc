@@ -0,0 +1,154 @@
+#include "tracing.h"
+
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace ostp::libcc::utils {
+
+// See tracing.h for documentation.
+
+namespace tracing_internal {
+
+std::atomic<bool> enabled(false);
+
+}  // namespace tracing_internal
+
+namespace {
+
+/// Events recorded by one thread. Only that thread appends; readers load the size with acquire
+/// semantics and read the events before it.
+struct ThreadBuffer {
+    ThreadBuffer(std::size_t capacity, long tid)
+        : events(std::make_unique_for_overwrite<TraceEvent[]>(capacity)), capacity(capacity),
+          tid(tid) {}
+
+    std::unique_ptr<TraceEvent[]> events; // Recorded events.
+    const std::size_t capacity;           // Number of events the buffer holds.
+    std::atomic<std::size_t> size{0};     // Number of published events.
+    const long tid;                       // Kernel identifier of the thread.
+};
+
+std::atomic<std::size_t> buffer_capacity(1 << 16);  // Capacity of buffers allocated from now on.
+std::atomic<uint64_t> dropped(0);                   // Events dropped because a buffer was full.
+std::mutex buffers_mutex;                           // Guards the list of buffers.
+std::vector<std::shared_ptr<ThreadBuffer>> buffers; // Buffers of every recording thread.
+thread_local std::shared_ptr<ThreadBuffer> local_buffer; // Buffer of the calling thread.
+
+/// Returns the buffer of the calling thread registering it on first use.
+ThreadBuffer &thread_buffer() {
+    if (!local_buffer) {
+        local_buffer = std::make_shared<ThreadBuffer>(buffer_capacity.load(),
+                                                      static_cast<long>(syscall(SYS_gettid)));
+        std::lock_guard<std::mutex> lock(buffers_mutex);
+        buffers.push_back(local_buffer);
+    }
+    return *local_buffer;
+}
+
+/// Writes a string as a JSON string.
+void write_json_string(FILE *file, const char *text) {
+    fputc('"', file);
+    for (const char *c = text; *c != '\0'; c++) {
+        if (*c == '"' || *c == '\\') {
+            fputc('\\', file);
+        }
+        fputc(*c, file);
+    }
+    fputc('"', file);
+}
+
+/// Writes an event as a Chrome trace event object.
+void write_event(FILE *file, const TraceEvent &event, long pid, long tid) {
+    fputs("{\"name\":", file);
+    write_json_string(file, event.name);
+    fputs(",\"cat\":", file);
+    write_json_string(file, event.category);
+    fprintf(file, ",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":%ld,\"tid\":%ld",
+            static_cast<char>(event.phase), event.timestamp_ns / 1e3, pid, tid);
+    switch (event.phase) {
+        case TracePhase::COMPLETE:
+            fprintf(file, ",\"dur\":%.3f}", event.duration_ns / 1e3);
+            break;
+        case TracePhase::FLOW_START:
+            fprintf(file, ",\"id\":%llu}", static_cast<unsigned long long>(event.flow_id));
+            break;
+        case TracePhase::FLOW_END:
+            // Bind to the enclosing span rather than the next one to start.
+            fprintf(file, ",\"id\":%llu,\"bp\":\"e\"}",
+                    static_cast<unsigned long long>(event.flow_id));
+            break;
+    }
+}
+
+}  // namespace
+
+void tracing_internal::record(const TraceEvent &event) {
+    ThreadBuffer &buffer = thread_buffer();
+    const std::size_t size = buffer.size.load(std::memory_order_relaxed);
+    if (size == buffer.capacity) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    buffer.events[size] = event;
+    buffer.size.store(size + 1, std::memory_order_release);
+}
+
+void start_tracing(std::size_t events_per_thread) {
+    buffer_capacity.store(events_per_thread > 0 ? events_per_thread : 1);
+    tracing_internal::enabled.store(true);
+}
+
+void stop_tracing() { tracing_internal::enabled.store(false); }
+
+void clear_trace() {
+    std::lock_guard<std::mutex> lock(buffers_mutex);
+    std::erase_if(buffers, [](const std::shared_ptr<ThreadBuffer> &buffer) {
+        // Drop the buffers of exited threads, which only the list still owns.
+        return buffer.use_count() == 1;
+    });
+    for (const std::shared_ptr<ThreadBuffer> &buffer : buffers) {
+        buffer->size.store(0, std::memory_order_relaxed);
+    }
+    dropped.store(0);
+}
+
+uint64_t dropped_trace_events() { return dropped.load(); }
+
+StatusOr<void> dump_trace(const std::string &path) {
+    FILE *file = fopen(path.c_str(), "w");
+    if (file == nullptr) {
+        return {Status::ERROR, "Cannot open the trace file."};
+    }
+
+    const long pid = static_cast<long>(getpid());
+    bool first = true;
+    fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", file);
+    {
+        std::lock_guard<std::mutex> lock(buffers_mutex);
+        for (const std::shared_ptr<ThreadBuffer> &buffer : buffers) {
+            const std::size_t size = buffer->size.load(std::memory_order_acquire);
+            for (std::size_t i = 0; i < size; i++) {
+                fputs(first ? "\n" : ",\n", file);
+                write_event(file, buffer->events[i], pid, buffer->tid);
+                first = false;
+            }
+        }
+    }
+    fputs("\n]}\n", file);
+
+    if (ferror(file) != 0) {
+        fclose(file);
+        return {Status::ERROR, "Cannot write the trace file."};
+    }
+    if (fclose(file) != 0) {
+        return {Status::ERROR, "Cannot write the trace file."};
+    }
+    return {};
+}
+
+}  // namespace ostp::libcc::utils
@@ -0,0 +1,102 @@
+#include "tracing.h"
+
+#include <unistd.h>
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "logger.h"
+#include "status.h"
+#include "testing.h"
+
+using ostp::libcc::utils::NullSpan;
+using ostp::libcc::utils::Status;
+using ostp::libcc::utils::TraceSpan;
+
+// Tracing compiled out leaves nothing to store.
+static_assert(std::is_empty_v<NullSpan>);
+
+/// Dumps the trace to a temporary file and returns its contents.
+std::string dump() {
+    const std::string path = "/tmp/tracing_test_" + std::to_string(getpid()) + ".json";
+    if (!ostp::libcc::utils::dump_trace(path).ok()) {
+        return "";
+    }
+    std::ifstream file(path);
+    std::stringstream contents;
+    contents << file.rdbuf();
+    unlink(path.c_str());
+    return contents.str();
+}
+
+/// Returns the number of occurrences of a string in another.
+int occurrences(const std::string &text, const std::string &pattern) {
+    int count = 0;
+    for (std::size_t i = text.find(pattern); i != std::string::npos;
+         i = text.find(pattern, i + 1)) {
+        count++;
+    }
+    return count;
+}
+
+START_SUITE(Tracing_Tests)
+
+START_SERIAL_TEST(StoppedTracingRecordsNothing) {
+    ostp::libcc::utils::clear_trace();
+    {
+        TraceSpan span("ignored");
+        span.flow_start(1);
+    }
+    TEST(occurrences(dump(), "ignored") == 0);
+}
+END_TEST
+
+START_SERIAL_TEST(SpansAndFlowsAreExported) {
+    ostp::libcc::utils::clear_trace();
+    ostp::libcc::utils::start_tracing();
+    {
+        TraceSpan span("producer", "test");
+        span.flow_start(7);
+    }
+    std::thread consumer([]() {
+        TraceSpan span("consumer", "test");
+        span.flow_end(7);
+    });
+    consumer.join();
+    ostp::libcc::utils::stop_tracing();
+
+    const std::string trace = dump();
+    TEST(trace.starts_with("{\"displayTimeUnit\":\"ns\",\"traceEvents\":["));
+    TEST(occurrences(trace, "\"name\":\"producer\",\"cat\":\"test\",\"ph\":\"X\"") == 1);
+    TEST(occurrences(trace, "\"name\":\"consumer\",\"cat\":\"test\",\"ph\":\"X\"") == 1);
+    TEST(occurrences(trace, "\"ph\":\"s\"") == 1);
+    TEST(occurrences(trace, "\"id\":7,\"bp\":\"e\"") == 1);
+}
+END_TEST
+
+START_SERIAL_TEST(FullBuffersDropEvents) {
+    ostp::libcc::utils::clear_trace();
+    ostp::libcc::utils::start_tracing(4);
+
+    // A new thread gets a buffer with the new capacity.
+    std::thread recorder([]() {
+        for (int i = 0; i < 10; i++) {
+            TraceSpan span("bounded");
+        }
+    });
+    recorder.join();
+    ostp::libcc::utils::stop_tracing();
+
+    TEST(occurrences(dump(), "\"bounded\"") == 4);
+    TEST(ostp::libcc::utils::dropped_trace_events() == 6);
+}
+END_TEST
+
+START_SERIAL_TEST(DumpReportsUnwritableFile) {
+    TEST(ostp::libcc::utils::dump_trace("/nonexistent/trace.json").status() == Status::ERROR);
+}
+END_TEST
+
+END_SUITE